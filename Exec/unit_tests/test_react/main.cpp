@@ -4,6 +4,8 @@
 #include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <string>
 
 #ifndef WIN32
 #include <unistd.h>
@@ -18,6 +20,8 @@
 #include <AMReX_ParmParse.H>
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_AmrLevel.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_VisMF.H>
 
 #include <time.h>
 
@@ -30,16 +34,127 @@
 #endif
 
 #include "Castro_io.H"
+#include "Castro_F.H"
 
+using namespace amrex;
 
 extern "C"
 {
-   void do_burn();
+   void do_burn(const Real* rho, const Real* T, const Real* X, const int& nsamples);
 }
 
 
 std::string inputs_name = "";
 
+// Draw nsamples zones (with replacement) from the coarse level of a
+// Castro plotfile and return their density, temperature and mass
+// fractions. The sequence of zones only depends on the seed, so a
+// given plotfile always gives the same benchmark problem.
+
+static void
+sample_plotfile (const std::string& plotfile, int nsamples, int seed,
+                 Vector<Real>& rho, Vector<Real>& T, Vector<Real>& X)
+{
+    int nspec;
+    ca_get_num_spec(&nspec);
+
+    Vector<std::string> spec_names;
+    for (int i = 0; i < nspec; i++) {
+        int len = 20;
+        Vector<int> int_spec_names(len);
+        ca_get_spec_names(int_spec_names.dataPtr(), &i, &len);
+        std::string name;
+        for (int j = 0; j < len; j++)
+            name += static_cast<char>(int_spec_names[j]);
+        spec_names.push_back(name);
+    }
+
+    // The plotfile Header lists the variables, in order, after the
+    // version string and the number of variables.
+
+    std::ifstream header((plotfile + "/Header").c_str());
+    if (!header.good())
+        amrex::Abort("test_react: unable to open " + plotfile + "/Header");
+
+    std::string version;
+    int nvars;
+    header >> version >> nvars;
+
+    Vector<std::string> var_names(nvars);
+    for (int n = 0; n < nvars; n++)
+        header >> var_names[n];
+
+    auto find_var = [&] (const std::string& name) -> int {
+        for (int n = 0; n < nvars; n++)
+            if (var_names[n] == name) return n;
+        return -1;
+    };
+
+    const int idens = find_var("density");
+    const int itemp = find_var("Temp");
+
+    if (idens < 0 || itemp < 0)
+        amrex::Abort("test_react: plotfile must contain density and Temp");
+
+    // Species may be stored either as mass fractions or as partial densities.
+
+    Vector<int> ispec(nspec);
+    Vector<int> spec_is_partial_density(nspec, 0);
+
+    for (int i = 0; i < nspec; i++) {
+        ispec[i] = find_var("X(" + spec_names[i] + ")");
+        if (ispec[i] < 0) {
+            ispec[i] = find_var("rho_" + spec_names[i]);
+            spec_is_partial_density[i] = 1;
+        }
+        if (ispec[i] < 0)
+            amrex::Abort("test_react: plotfile has no data for species " + spec_names[i]);
+    }
+
+    MultiFab mf;
+    VisMF::Read(mf, plotfile + "/Level_0/Cell");
+
+    // Gather the coarse level onto a single FAB so that every zone can be sampled.
+
+    const Box& domain = mf.boxArray().minimalBox();
+
+    FArrayBox data(domain, nvars);
+    data.setVal(0.0);
+
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        data.copy(mf[mfi], mfi.validbox());
+
+    ParallelDescriptor::ReduceRealSum(data.dataPtr(), data.box().numPts() * nvars);
+
+    rho.resize(nsamples);
+    T.resize(nsamples);
+    X.resize(nsamples * nspec);
+
+    // Park-Miller minimal standard generator.
+
+    long state = seed > 0 ? seed : 1;
+
+    for (int s = 0; s < nsamples; s++) {
+
+        state = (16807 * state) % 2147483647;
+
+        const long zone = state % domain.numPts();
+
+        IntVect iv = domain.atOffset(zone);
+
+        rho[s] = data(iv, idens);
+        T[s]   = data(iv, itemp);
+
+        for (int i = 0; i < nspec; i++) {
+            X[i * nsamples + s] = data(iv, ispec[i]);
+            if (spec_is_partial_density[i])
+                X[i * nsamples + s] /= rho[s];
+        }
+
+    }
+
+}
+
 int
 main (int   argc,
       char* argv[])
@@ -57,7 +172,27 @@ main (int   argc,
       }
     }
 
-    do_burn();
+    // Optionally take the thermodynamic states to burn from a plotfile.
+    // Otherwise the distribution is chosen by sample_type in the probin.
+
+    ParmParse pp("bench");
+
+    std::string plotfile = "";
+    int nsamples = 4096;
+    int seed = 1;
+
+    pp.query("plotfile", plotfile);
+    pp.query("nsamples", nsamples);
+    pp.query("seed", seed);
+
+    Vector<Real> rho, T, X;
+
+    if (!plotfile.empty())
+        sample_plotfile(plotfile, nsamples, seed, rho, T, X);
+    else
+        nsamples = 0;
+
+    do_burn(rho.dataPtr(), T.dataPtr(), X.dataPtr(), nsamples);
 
     amrex::Finalize();
 
@@ -1,39 +1,120 @@
-subroutine do_burn() bind(C)
+module testburn_module
+
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer(8), save :: seed_state = 1
+
+contains
+
+  ! Park-Miller minimal standard generator, so that every sample
+  ! distribution is reproducible from sample_seed.
+
+  function random_uniform() result(r)
+
+    real(rt) :: r
+
+    seed_state = mod(16807_8 * seed_state, 2147483647_8)
+    r = real(seed_state, rt) / 2147483647.0e0_rt
+
+  end function random_uniform
+
+
+
+  function wall_time() result(t)
+
+    real(rt) :: t
+    integer(8) :: count, count_rate
+
+    call system_clock(count, count_rate)
+    t = real(count, rt) / real(count_rate, rt)
+
+  end function wall_time
+
+
+
+  subroutine report(label, nzones, nthreads, thread_time, nrhs, njac)
+
+    character (len=*), intent(in) :: label
+    integer,  intent(in) :: nzones, nthreads
+    real(rt), intent(in) :: thread_time(0:nthreads-1)
+    integer(8), intent(in) :: nrhs, njac
+
+    real(rt) :: t_max, t_mean
+
+    t_max  = maxval(thread_time)
+    t_mean = sum(thread_time) / nthreads
+
+    write(*,'(1x,a24,i8,es14.4,es14.4)', advance='no') label, nthreads, t_max, dble(nzones) / t_max
+
+    if (nrhs >= 0) then
+       write(*,'(2f12.2)', advance='no') dble(nrhs) / nzones, dble(njac) / nzones
+    else
+       write(*,'(2a12)', advance='no') 'n/a', 'n/a'
+    endif
+
+    ! Load imbalance: the time of the slowest thread relative to the mean.
+
+    if (t_mean > 0.0e0_rt) then
+       write(*,'(f12.3)') t_max / t_mean
+    else
+       write(*,'(f12.3)') 1.0e0_rt
+    endif
+
+  end subroutine report
+
+end module testburn_module
+
+
+
+subroutine do_burn(rho_in, T_in, X_in, nsamples) bind(C)
 
   use network
   use eos_type_module, only : eos_t, eos_input_rt
   use eos_module
   use burner_module
+  use burn_type_module, only : burn_t
   use actual_burner_module
   use actual_rhs_module, only: actual_rhs_init
   use meth_params_module
   use reactions_module, only: ca_react_state
-  use extern_probin_module, only: ncell, dt, dens_min, dens_max, temp_min, temp_max
+  use model_parser_module, only : read_model_file, model_state, npts_model, &
+                                  idens_model, itemp_model, ispec_model
+  use extern_probin_module, only: ncell, dt, dens_min, dens_max, temp_min, temp_max, &
+                                  sample_type, sample_seed, model_file
+  use testburn_module
+  use bl_error_module, only : bl_error
+  !$ use omp_lib
 
   use amrex_fort_module, only : rt => amrex_real
   implicit none
 
+  integer,  intent(in) :: nsamples
+  real(rt), intent(in) :: rho_in(nsamples), T_in(nsamples), X_in(nsamples, nspec)
+
   integer, parameter :: nv = 7 + nspec
 
   real(rt)        , parameter :: time = 0.0e0_rt
 
-  integer :: lo(3), hi(3), w(3)
+  integer :: lo(3), hi(3), w(3), klo(3), khi(3)
 
   real(rt)         :: dlogrho, dlogT
 
-  real(rt)        , allocatable :: state(:,:,:,:), reactions(:,:,:,:)
+  real(rt)        , allocatable :: state_init(:,:,:,:), state(:,:,:,:), reactions(:,:,:,:)
   integer, allocatable :: mask(:,:,:)
   real(rt), allocatable :: weights(:,:,:)
+  real(rt), allocatable :: thread_time(:)
 
-  integer :: i, j, k
+  integer :: i, j, k, n, m, s, nzones, nthreads, tid
 
   type (eos_t) :: eos_state
+  type (burn_t) :: burn_state_in, burn_state_out
 
-  real(rt)         :: start, finish
+  real(rt)         :: start
+  integer(8)       :: nrhs, njac
 
   character (len=32) :: probin_file
   integer :: probin_pass(32)
-  integer :: n
 
   probin_file = "probin"
   do n = 1, len(trim(probin_file))
@@ -68,33 +149,90 @@ subroutine do_burn() bind(C)
   hi = [ncell, ncell, ncell]
   w = hi - lo + 1
 
+  nzones = w(1) * w(2) * w(3)
+
+  nthreads = 1
+  !$ nthreads = omp_get_max_threads()
+
+  allocate(state_init(lo(1):hi(1),lo(2):hi(2),lo(3):hi(3),NVAR))
   allocate(state(lo(1):hi(1),lo(2):hi(2),lo(3):hi(3),NVAR))
   allocate(reactions(lo(1):hi(1),lo(2):hi(2),lo(3):hi(3),nspec+2))
   allocate(mask(lo(1):hi(1),lo(2):hi(2),lo(3):hi(3)))
   allocate(weights(lo(1):hi(1),lo(2):hi(2),lo(3):hi(3)))
+  allocate(thread_time(0:nthreads-1))
+
+  ! Build the distribution of thermodynamic states to burn.
+  !
+  ! If samples were passed in (from a plotfile), zones cycle through them.
+  ! Otherwise sample_type selects:
+  !   1: a uniform grid in (log rho, log T), with the composition varying along z
+  !   2: random (log rho, log T) in the same ranges and random compositions
+  !   3: random points from the 1-d initial model in model_file
+
+  seed_state = max(sample_seed, 1)
+
+  if (nsamples == 0 .and. sample_type == 3) then
+     call read_model_file(model_file)
+  endif
 
   dlogrho = (log10(dens_max) - log10(dens_min)) / w(1)
   dlogT   = (log10(temp_max) - log10(temp_min)) / w(2)
 
+  s = 0
+
   do k = lo(3), hi(3)
      do j = lo(2), hi(2)
         do i = lo(1), hi(1)
 
-           state(i,j,k,:) = ZERO
+           state_init(i,j,k,:) = ZERO
+
+           if (nsamples > 0) then
+
+              s = mod(s, nsamples) + 1
+
+              eos_state % rho = rho_in(s)
+              eos_state % T   = T_in(s)
+              eos_state % xn  = X_in(s,:)
+
+           else if (sample_type == 1) then
 
-           eos_state % rho = 10.0e0_rt**(log10(dens_min) + dble(i)*dlogrho)
-           eos_state % T   = 10.0e0_rt**(log10(temp_min) + dble(j)*dlogT  )
-           eos_state % xn  = 1.e-12_rt
-           eos_state % xn(1 + INT( (dble(k) / w(3)) * nspec)) = ONE  - (nspec - 1) * 1.e-12_rt
+              eos_state % rho = 10.0e0_rt**(log10(dens_min) + dble(i)*dlogrho)
+              eos_state % T   = 10.0e0_rt**(log10(temp_min) + dble(j)*dlogT  )
+              eos_state % xn  = 1.e-12_rt
+              eos_state % xn(1 + INT( (dble(k) / w(3)) * nspec)) = ONE  - (nspec - 1) * 1.e-12_rt
+
+           else if (sample_type == 2) then
+
+              eos_state % rho = 10.0e0_rt**(log10(dens_min) + random_uniform() * (log10(dens_max) - log10(dens_min)))
+              eos_state % T   = 10.0e0_rt**(log10(temp_min) + random_uniform() * (log10(temp_max) - log10(temp_min)))
+
+              do n = 1, nspec
+                 eos_state % xn(n) = random_uniform()
+              enddo
+              eos_state % xn = eos_state % xn / sum(eos_state % xn)
+
+           else if (sample_type == 3) then
+
+              m = min(1 + int(random_uniform() * npts_model), npts_model)
+
+              eos_state % rho = model_state(m, idens_model)
+              eos_state % T   = model_state(m, itemp_model)
+              eos_state % xn  = model_state(m, ispec_model:ispec_model+nspec-1)
+
+           else
+
+              call bl_error("ERROR: invalid sample_type in test_react")
+
+           endif
 
            call eos(eos_input_rt, eos_state)
 
-           state(i,j,k,URHO)            = eos_state % rho
-           state(i,j,k,UTEMP)           = eos_state % T
-           state(i,j,k,UFS:UFS+nspec-1) = eos_state % rho * eos_state % xn
-           state(i,j,k,UEINT)           = eos_state % rho * eos_state % e
-           state(i,j,k,UEDEN)           = eos_state % rho * eos_state % e
-           state(i,j,k,UMX:UMZ)         = ZERO
+           state_init(i,j,k,URHO)            = eos_state % rho
+           state_init(i,j,k,UTEMP)           = eos_state % T
+           state_init(i,j,k,UFS:UFS+nspec-1) = eos_state % rho * eos_state % xn
+           state_init(i,j,k,UEINT)           = eos_state % rho * eos_state % e
+           state_init(i,j,k,UEDEN)           = eos_state % rho * eos_state % e
+           state_init(i,j,k,UMX:UMZ)         = ZERO
 
            mask(i,j,k) = 1
            weights(i,j,k) = 0.0
@@ -103,16 +241,106 @@ subroutine do_burn() bind(C)
      enddo
   enddo
 
-  call cpu_time(start)
+  print *, 'zones = ', nzones, ', dt = ', dt
+  print *, ''
+  write(*,'(1x,a24,a8,a14,a14,a12,a12,a12)') 'kernel', 'threads', 'time (s)', 'zones/s', &
+                                              'RHS/zone', 'Jac/zone', 'imbalance'
+
+  ! burner alone, one thread and then all threads. Each zone starts
+  ! from the same (rho, T, X) that ca_react_state sees.
+
+  do m = 1, 2
 
-  call ca_react_state(lo, hi, state, lo, hi, reactions, lo, hi, &
-                      weights, lo, hi, &
-                      mask, lo, hi, time, dt, 0)
+     nrhs = 0
+     njac = 0
+     thread_time(:) = ZERO
+
+     !$omp parallel private(i, j, k, tid, start, burn_state_in, burn_state_out) &
+     !$omp reduction(+:nrhs, njac) if(m == 2)
+
+     tid = 0
+     !$ tid = omp_get_thread_num()
+
+     start = wall_time()
+
+     !$omp do collapse(3) schedule(static)
+     do k = lo(3), hi(3)
+        do j = lo(2), hi(2)
+           do i = lo(1), hi(1)
+
+              burn_state_in % rho = state_init(i,j,k,URHO)
+              burn_state_in % T   = state_init(i,j,k,UTEMP)
+              burn_state_in % xn  = state_init(i,j,k,UFS:UFS+nspec-1) / state_init(i,j,k,URHO)
+              burn_state_in % e   = ZERO
+              burn_state_in % i   = i
+              burn_state_in % j   = j
+              burn_state_in % k   = k
+              burn_state_in % n_rhs = 0
+              burn_state_in % n_jac = 0
+
+              call burner(burn_state_in, burn_state_out, dt, time)
+
+              nrhs = nrhs + burn_state_out % n_rhs
+              njac = njac + burn_state_out % n_jac
+
+           enddo
+        enddo
+     enddo
+     !$omp end do nowait
 
-  call cpu_time(finish)
+     thread_time(tid) = wall_time() - start
+
+     !$omp end parallel
+
+     if (m == 1) then
+        call report('burner', nzones, 1, thread_time(0:0), nrhs, njac)
+     else
+        call report('burner', nzones, nthreads, thread_time, nrhs, njac)
+     endif
+
+  enddo
+
+  ! ca_react_state, one thread on the whole box and then all threads
+  ! each taking z-slabs, the way tiles are handed out in Castro.
+
+  do m = 1, 2
+
+     state(:,:,:,:) = state_init(:,:,:,:)
+     thread_time(:) = ZERO
+
+     !$omp parallel private(k, tid, start, klo, khi) if(m == 2)
+
+     tid = 0
+     !$ tid = omp_get_thread_num()
+
+     start = wall_time()
+
+     !$omp do schedule(static)
+     do k = lo(3), hi(3)
+
+        klo = [lo(1), lo(2), k]
+        khi = [hi(1), hi(2), k]
+
+        call ca_react_state(klo, khi, state, lo, hi, reactions, lo, hi, &
+                            weights, lo, hi, &
+                            mask, lo, hi, time, dt, 0)
+
+     enddo
+     !$omp end do nowait
+
+     thread_time(tid) = wall_time() - start
+
+     !$omp end parallel
+
+     if (m == 1) then
+        call report('ca_react_state', nzones, 1, thread_time(0:0), -1_8, -1_8)
+     else
+        call report('ca_react_state', nzones, nthreads, thread_time, -1_8, -1_8)
+     endif
+
+  enddo
 
-  print *, 'done!'
-  print *, 'execution time = ', finish - start
+  print *, ''
   print *, 'sum of reactions energy = ', sum(reactions(:,:,:,nspec+1))
 
 end subroutine do_burn
@@ -6,6 +6,8 @@ using std::string;
 
 #include "Diffusion.H"
 
+#include <cmath>
+
 using namespace amrex;
 
 void
@@ -20,10 +22,25 @@ Castro::construct_old_diff_source(Real time, Real dt)
     MultiFab ViscousTermforMomentum(grids, dmap, BL_SPACEDIM, 1);
     MultiFab ViscousTermforEnergy(grids, dmap, 1, 1);
 
-    add_temp_diffusion_to_source(*old_sources[diff_src], TempDiffTerm, time, 1);
+    if (diffusion_sts) {
+
+        // Integrate the thermal and species diffusion over the whole
+        // step now; the old-time source is the average rate of change.
+
+        sts_diff_src.define(grids, dmap, NUM_STATE, 0);
+        diffusion_sts_update(sts_diff_src, time, dt);
+        MultiFab::Add(*old_sources[diff_src], sts_diff_src, 0, 0, NUM_STATE, 0);
+
+    } else {
+
+        add_temp_diffusion_to_source(*old_sources[diff_src], TempDiffTerm, time, 1);
+#if (BL_SPACEDIM == 1)
+        add_spec_diffusion_to_source(*old_sources[diff_src], SpecDiffTerm, time, 1);
+#endif
+
+    }
 
 #if (BL_SPACEDIM == 1)
-    add_spec_diffusion_to_source(*old_sources[diff_src], SpecDiffTerm, time, 1);
     add_viscous_term_to_source(*old_sources[diff_src], ViscousTermforMomentum, ViscousTermforEnergy, time);
 #endif
 
@@ -37,15 +54,22 @@ Castro::construct_new_diff_source(Real time, Real dt)
 
     new_sources[diff_src]->setVal(0.0);
 
+    // The new-time state has been updated since any earlier evaluation.
+    clear_transport_coeffs();
+
     MultiFab TempDiffTerm(grids, dmap, 1, 1);
     MultiFab SpecDiffTerm(grids, dmap, NumSpec, 1);
     MultiFab ViscousTermforMomentum(grids, dmap, BL_SPACEDIM, 1);
     MultiFab ViscousTermforEnergy(grids, dmap, 1, 1);
 
-    add_temp_diffusion_to_source(*new_sources[diff_src], TempDiffTerm, time, 0);
+    if (!diffusion_sts) {
+        add_temp_diffusion_to_source(*new_sources[diff_src], TempDiffTerm, time, 0);
+#if (BL_SPACEDIM == 1)
+        add_spec_diffusion_to_source(*new_sources[diff_src], SpecDiffTerm, time, 0);
+#endif
+    }
 
 #if (BL_SPACEDIM == 1)
-    add_spec_diffusion_to_source(*new_sources[diff_src], SpecDiffTerm, time, 0);
     add_viscous_term_to_source(*new_sources[diff_src], ViscousTermforMomentum, ViscousTermforEnergy, time);
 #endif
 
@@ -55,6 +79,243 @@ Castro::construct_new_diff_source(Real time, Real dt)
 
     MultiFab::Saxpy(*new_sources[diff_src], -0.5, *old_sources[diff_src], 0, 0, NUM_STATE, ng);
 
+    // The super-time-stepped part of the old-time source is already
+    // the complete update, so it takes no correction.
+
+    if (diffusion_sts)
+        MultiFab::Saxpy(*new_sources[diff_src], 0.5, sts_diff_src, 0, 0, NUM_STATE, ng);
+
+}
+
+// **********************************************************************************************
+
+Real
+Castro::estdt_diffusion(const MultiFab& State)
+{
+    BL_PROFILE("Castro::estdt_diffusion()");
+
+    const Real* dx = geom.CellSize();
+
+    Real estdt = 1.e200;
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(min:estdt)
+#endif
+    {
+        Real dt = 1.e200;
+
+        for (MFIter mfi(State,true); mfi.isValid(); ++mfi)
+        {
+            const Box& box = mfi.tilebox();
+
+            if (diffuse_temp)
+                ca_estdt_temp_diffusion(ARLIM_3D(box.loVect()), ARLIM_3D(box.hiVect()),
+                                        BL_TO_FORTRAN_3D(State[mfi]),
+                                        ZFILL(dx),&dt);
+            if (diffuse_enth)
+                ca_estdt_enth_diffusion(ARLIM_3D(box.loVect()), ARLIM_3D(box.hiVect()),
+                                        BL_TO_FORTRAN_3D(State[mfi]),
+                                        ZFILL(dx),&dt);
+        }
+
+        estdt = std::min(estdt, dt);
+    }
+
+    return estdt;
+}
+
+// **********************************************************************************************
+
+// The s-stage RKL2 scheme (Meyer, Balsara & Aslam 2014, JCP 257, 594)
+// is stable for steps up to (s**2 + s - 2) / 4 times the explicit limit.
+
+Real
+Castro::rkl2_stability_factor(int nstages)
+{
+    return 0.25 * (nstages * nstages + nstages - 2);
+}
+
+// Advance the thermal diffusion (and, in 1-d, the species diffusion)
+// from time over dt with RKL2, starting from the state in S_new.  The
+// stages are built in S_new so that the operator can fill its ghost
+// cells from the state data; S_new is restored at the end.  On output
+// DiffSrc holds the change of the state over the step divided by dt.
+//
+// Each stage is evaluated at its own time: the new time of this level
+// is moved to the stage time while the stage is in S_new, so that the
+// coarse data for the coarse-fine ghost cells is interpolated to that
+// time, as in the rest of the step, instead of being taken at the end
+// of the step.
+
+void
+Castro::diffusion_sts_update(MultiFab& DiffSrc, Real time, Real dt)
+{
+    BL_PROFILE("Castro::diffusion_sts_update()");
+
+    MultiFab& S_new = get_new_data(State_Type);
+    const Real prev_time = state[State_Type].prevTime();
+    const Real cur_time = state[State_Type].curTime();
+
+    // Pick the number of stages from the explicit limit.  If dt needs
+    // more than diffusion_sts_max_stages stages (dt was not limited by
+    // this level's diffusion, e.g. after the state changed), the step
+    // is split into equal substeps that each need at most that many.
+
+    Real dt_diff = estdt_diffusion(S_new);
+    ParallelDescriptor::ReduceRealMin(dt_diff);
+    dt_diff *= cfl;
+
+    const Real ratio = dt / dt_diff;
+
+    int nsub = 1;
+    if (ratio > rkl2_stability_factor(diffusion_sts_max_stages))
+        nsub = int(std::ceil(ratio / rkl2_stability_factor(diffusion_sts_max_stages)));
+
+    const Real dt_sub = dt / nsub;
+
+    int nstages = std::max(2, int(std::ceil(0.5 * (std::sqrt(9.0 + 16.0 * ratio / nsub) - 1.0))));
+    nstages = std::min(nstages, diffusion_sts_max_stages);
+
+    if (verbose && ParallelDescriptor::IOProcessor()) {
+        std::cout << "... diffusion STS at level " << level << ": " << nstages
+                  << " stages for dt / dt_diffusion = " << ratio;
+        if (nsub > 1)
+            std::cout << ", in " << nsub << " substeps";
+        std::cout << std::endl;
+    }
+
+    // The components that diffuse, and the component of the diffusion
+    // term that updates each of them.
+
+    Vector<int> comp = {Eden, Eint};
+    Vector<int> term = {0, 0};
+
+    int nterm = 1;
+
+#if (BL_SPACEDIM == 1)
+    if (diffuse_spec == 1) {
+        for (int n = 0; n < NumSpec; ++n) {
+            comp.push_back(FirstSpec + n);
+            term.push_back(1 + n);
+        }
+        nterm += NumSpec;
+    }
+#endif
+
+    const int ncomp = comp.size();
+
+    MultiFab S_start(grids, dmap, NUM_STATE, S_new.nGrow());
+    MultiFab Y0(grids, dmap, ncomp, 0);
+    MultiFab Yjm2(grids, dmap, ncomp, 0);
+    MultiFab Yj(grids, dmap, ncomp, 0);
+    MultiFab L0(grids, dmap, nterm, 0);
+    MultiFab L(grids, dmap, nterm, 0);
+
+    MultiFab::Copy(S_start, S_new, 0, 0, NUM_STATE, S_new.nGrow());
+
+    const Real w1 = 4.0 / (nstages * nstages + nstages - 2);
+
+    auto b = [] (int j) -> Real {
+        return (j <= 2) ? 1.0 / 3.0 : (j * j + j - 2.0) / (2.0 * j * (j + 1.0));
+    };
+
+    // The time of stage j within a substep, as a fraction of it.
+
+    auto c = [w1] (int j) -> Real {
+        return (j <= 1) ? j * w1 / 3.0 : 0.25 * w1 * (j * j + j - 2.0);
+    };
+
+    for (int isub = 0; isub < nsub; ++isub) {
+
+        const Real t0 = time + isub * dt_sub;
+
+        for (int i = 0; i < ncomp; ++i) {
+            MultiFab::Copy(Y0, S_new, comp[i], i, 1, 0);
+            MultiFab::Copy(Yjm2, S_new, comp[i], i, 1, 0);
+        }
+
+        // First stage: Y_1 = Y_0 + mu~_1 dt L(Y_0)
+
+        state[State_Type].setTimeLevel(t0, dt, 0.0);
+        get_sts_diffusion_term(L0, t0);
+
+        for (int i = 0; i < ncomp; ++i)
+            MultiFab::Saxpy(S_new, b(1) * w1 * dt_sub, L0, term[i], comp[i], 1, 0);
+
+        computeTemp(S_new);
+
+        for (int j = 2; j <= nstages; ++j) {
+
+            const Real mu = (2.0 * j - 1.0) / j * b(j) / b(j-1);
+            const Real nu = -(j - 1.0) / j * b(j) / b(j-2);
+            const Real mu_t = mu * w1;
+            const Real gamma_t = -(1.0 - b(j-1)) * mu_t;
+
+            const Real t_stage = t0 + c(j-1) * dt_sub;
+
+            state[State_Type].setTimeLevel(t_stage, dt, 0.0);
+            get_sts_diffusion_term(L, t_stage);
+
+            // Y_j = mu Y_{j-1} + nu Y_{j-2} + (1 - mu - nu) Y_0
+            //     + mu~ dt L(Y_{j-1}) + gamma~ dt L(Y_0)
+
+            for (int i = 0; i < ncomp; ++i) {
+                MultiFab::LinComb(Yj, mu, S_new, comp[i], nu, Yjm2, i, i, 1, 0);
+                MultiFab::Saxpy(Yj, 1.0 - mu - nu, Y0, i, i, 1, 0);
+                MultiFab::Saxpy(Yj, mu_t * dt_sub, L, term[i], i, 1, 0);
+                MultiFab::Saxpy(Yj, gamma_t * dt_sub, L0, term[i], i, 1, 0);
+
+                MultiFab::Copy(Yjm2, S_new, comp[i], i, 1, 0);
+                MultiFab::Copy(S_new, Yj, i, comp[i], 1, 0);
+            }
+
+            computeTemp(S_new);
+
+        }
+
+    }
+
+    DiffSrc.setVal(0.0);
+
+    for (int i = 0; i < ncomp; ++i) {
+        MultiFab::LinComb(DiffSrc, 1.0 / dt, S_new, comp[i], -1.0 / dt, S_start, comp[i], comp[i], 1, 0);
+    }
+
+    MultiFab::Copy(S_new, S_start, 0, 0, NUM_STATE, S_new.nGrow());
+
+    state[State_Type].setOldTimeLevel(prev_time);
+    state[State_Type].setNewTimeLevel(cur_time);
+}
+
+// The diffusion terms that are super-time-stepped, evaluated from the
+// new-time state data: the thermal term in component 0 and, in 1-d,
+// the species terms after it.
+
+void
+Castro::get_sts_diffusion_term(MultiFab& DiffTerm, Real time)
+{
+    MultiFab TempDiffTerm(grids, dmap, 1, 1);
+
+    // Each stage changes the new-time state.
+    clear_transport_coeffs();
+
+    TempDiffTerm.setVal(0.0);
+    if (diffuse_temp == 1) {
+        getTempDiffusionTerm(time, TempDiffTerm, 0);
+    } else if (diffuse_enth == 1) {
+        getEnthDiffusionTerm(time, TempDiffTerm, 0);
+    }
+
+    MultiFab::Copy(DiffTerm, TempDiffTerm, 0, 0, 1, 0);
+
+#if (BL_SPACEDIM == 1)
+    if (diffuse_spec == 1) {
+        MultiFab SpecDiffTerm(grids, dmap, NumSpec, 1);
+        SpecDiffTerm.setVal(0.0);
+        getSpecDiffusionTerm(time, SpecDiffTerm, 0);
+        MultiFab::Copy(DiffTerm, SpecDiffTerm, 0, 1, NumSpec, 0);
+    }
+#endif
 }
 
 // **********************************************************************************************
@@ -64,6 +325,10 @@ Castro::add_temp_diffusion_to_source (MultiFab& ext_src, MultiFab& DiffTerm, Rea
 {
     // Define an explicit temperature update.
     DiffTerm.setVal(0.);
+
+    // With implicit diffusion this is a separate step instead.
+    if (diffusion_implicit) return;
+
     if (diffuse_temp == 1) {
        getTempDiffusionTerm(t, DiffTerm, is_old);
     } else if (diffuse_enth == 1) {
@@ -79,6 +344,231 @@ Castro::add_temp_diffusion_to_source (MultiFab& ext_src, MultiFab& DiffTerm, Rea
 
 // **********************************************************************************************
 
+// Backward Euler thermal diffusion.  For thermal diffusion we solve
+//
+//   rho c_v (T^{n+1} - T^*) - dt div(k grad T^{n+1}) = 0
+//
+// for T^{n+1}, with rho c_v and k from the state after the hydro update
+// and the sources (T^*); for enthalpy diffusion T is replaced with h
+// and rho c_v with rho.  The internal and total energy then change by
+// rho c_v (T^{n+1} - T^*).
+
+void
+Castro::implicit_diffusion_level(Real time, Real dt)
+{
+    BL_PROFILE("Castro::implicit_diffusion_level()");
+
+    const Real strt = ParallelDescriptor::second();
+
+    MultiFab phi(grids, dmap, 1, 1);
+    MultiFab phi_old(grids, dmap, 1, 0);
+    MultiFab acoef(grids, dmap, 1, 0);
+    MultiFab rhs(grids, dmap, 1, 0);
+    MultiFab dE(grids, dmap, 1, 0);
+
+    Vector<Vector<std::unique_ptr<MultiFab> > > bcoef(1);
+
+    implicit_diffusion_setup(time, phi, acoef, rhs, bcoef[0]);
+
+    MultiFab::Copy(phi_old, phi, 0, 0, 1, 0);
+    MultiFab::Copy(dE, acoef, 0, 0, 1, 0);
+
+    // Temperature (or enthalpy) at the coarse-fine boundary.
+
+    MultiFab CrsePhi;
+    if (level > 0) {
+	Castro& crse = getLevel(level-1);
+	const BoxArray& crse_grids = crse.boxArray();
+	const DistributionMapping& crse_dmap = crse.DistributionMap();
+	CrsePhi.define(crse_grids, crse_dmap, 1, 1);
+	if (diffuse_temp == 1) {
+	    FillPatch(crse, CrsePhi, 1, time, State_Type, Temp, 1);
+	} else {
+	    MultiFab CrseState(crse_grids, crse_dmap, NUM_STATE, 1);
+	    FillPatch(crse, CrseState, 1, time, State_Type, Density, NUM_STATE);
+	    // the ghost cells are needed as well, as for the temperature
+	    for (MFIter mfi(CrseState); mfi.isValid(); ++mfi)
+	    {
+		const Box bx = amrex::grow(crse_grids[mfi.index()], 1);
+		make_enthalpy(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+			      BL_TO_FORTRAN_3D(CrseState[mfi]),
+			      BL_TO_FORTRAN_3D(CrsePhi[mfi]));
+	    }
+	}
+    }
+
+    Vector<Vector<std::unique_ptr<MultiFab> > > flux(1);
+    flux[0].resize(BL_SPACEDIM);
+    for (int dir = 0; dir < BL_SPACEDIM; ++dir)
+	flux[0][dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
+
+    Vector<MultiFab*> phi_p = {&phi};
+    Vector<MultiFab*> rhs_p = {&rhs};
+    Vector<MultiFab*> acoef_p = {&acoef};
+    Vector<Vector<MultiFab*> > flux_p = {amrex::GetVecOfPtrs(flux[0])};
+
+    Real resnorm = diffusion->solve_implicit(level, level, dt, phi_p, rhs_p, acoef_p,
+					     bcoef, CrsePhi, flux_p);
+
+    implicit_diffusion_finish(phi, phi_old, dE);
+
+    // The solve returns dt times the diffusive flux; register it with
+    // the hydro fluxes so the reflux keeps the energy conserved across
+    // levels.
+
+    if (do_reflux) {
+	for (int dir = 0; dir < BL_SPACEDIM; ++dir) {
+	    MultiFab::Multiply(*flux[0][dir], area[dir], 0, 0, 1, 0);
+	    MultiFab::Add(*fluxes[dir], *flux[0][dir], 0, Eden, 1, 0);
+	    MultiFab::Add(*fluxes[dir], *flux[0][dir], 0, Eint, 1, 0);
+	}
+    }
+
+    if (verbose) {
+	Real run_time = ParallelDescriptor::second() - strt;
+	ParallelDescriptor::ReduceRealMax(run_time, ParallelDescriptor::IOProcessorNumber());
+	if (ParallelDescriptor::IOProcessor())
+	    std::cout << "... implicit diffusion at level " << level
+		      << ": residual = " << resnorm
+		      << ", time = " << run_time << std::endl;
+    }
+}
+
+// The same update as a composite solve on all levels at once.  This
+// is done at the end of the coarse timestep, so every level has to be
+// at the same time.
+
+void
+Castro::implicit_diffusion_composite(Real time, Real dt)
+{
+    BL_PROFILE("Castro::implicit_diffusion_composite()");
+
+    BL_ASSERT(level == 0);
+
+    const Real strt = ParallelDescriptor::second();
+
+    const int finest_level = parent->finestLevel();
+    const int nlevs = finest_level + 1;
+
+    for (int lev = 1; lev <= finest_level; ++lev)
+	if (parent->nCycle(lev) != 1)
+	    amrex::Error("castro.diffusion_implicit = 2 requires amr.subcycling_mode = None");
+
+    Vector<std::unique_ptr<MultiFab> > phi(nlevs), phi_old(nlevs), acoef(nlevs), rhs(nlevs), dE(nlevs);
+    Vector<Vector<std::unique_ptr<MultiFab> > > bcoef(nlevs), flux(nlevs);
+
+    for (int lev = 0; lev <= finest_level; ++lev) {
+
+	Castro& c_lev = getLevel(lev);
+	const BoxArray& ba = c_lev.boxArray();
+	const DistributionMapping& dm = c_lev.DistributionMap();
+
+	phi[lev].reset(new MultiFab(ba, dm, 1, 1));
+	phi_old[lev].reset(new MultiFab(ba, dm, 1, 0));
+	acoef[lev].reset(new MultiFab(ba, dm, 1, 0));
+	rhs[lev].reset(new MultiFab(ba, dm, 1, 0));
+	dE[lev].reset(new MultiFab(ba, dm, 1, 0));
+
+	c_lev.implicit_diffusion_setup(time, *phi[lev], *acoef[lev], *rhs[lev], bcoef[lev]);
+
+	MultiFab::Copy(*phi_old[lev], *phi[lev], 0, 0, 1, 0);
+	MultiFab::Copy(*dE[lev], *acoef[lev], 0, 0, 1, 0);
+
+	flux[lev].resize(BL_SPACEDIM);
+	for (int dir = 0; dir < BL_SPACEDIM; ++dir)
+	    flux[lev][dir].reset(new MultiFab(c_lev.getEdgeBoxArray(dir), dm, 1, 0));
+    }
+
+    Vector<Vector<MultiFab*> > flux_p(nlevs);
+    for (int lev = 0; lev <= finest_level; ++lev)
+	flux_p[lev] = amrex::GetVecOfPtrs(flux[lev]);
+
+    MultiFab CrsePhi;
+
+    Real resnorm = diffusion->solve_implicit(0, finest_level, dt,
+					     amrex::GetVecOfPtrs(phi),
+					     amrex::GetVecOfPtrs(rhs),
+					     amrex::GetVecOfPtrs(acoef),
+					     bcoef, CrsePhi, flux_p);
+
+    for (int lev = 0; lev <= finest_level; ++lev)
+	getLevel(lev).implicit_diffusion_finish(*phi[lev], *phi_old[lev], *dE[lev]);
+
+    for (int lev = finest_level-1; lev >= 0; --lev)
+	getLevel(lev).avgDown();
+
+    if (verbose) {
+	Real run_time = ParallelDescriptor::second() - strt;
+	ParallelDescriptor::ReduceRealMax(run_time, ParallelDescriptor::IOProcessorNumber());
+	if (ParallelDescriptor::IOProcessor())
+	    std::cout << "... implicit diffusion at levels 0 to " << finest_level
+		      << ": residual = " << resnorm
+		      << ", time = " << run_time << std::endl;
+    }
+}
+
+// Fill the unknown (with one ghost cell), the coefficients and the
+// right hand side of the implicit diffusion solve from the new-time
+// state at this level.
+
+void
+Castro::implicit_diffusion_setup(Real time, MultiFab& phi, MultiFab& acoef,
+				 MultiFab& rhs, Vector<std::unique_ptr<MultiFab> >& bcoef)
+{
+    // The new-time state has changed since the source terms were built.
+    clear_transport_coeffs();
+    const MultiFab& coeffs_cc = get_transport_coeffs(time);
+
+    MultiFab& S_new = get_new_data(State_Type);
+
+    FillPatchIterator fpi(*this, S_new, 1, time, State_Type, 0, NUM_STATE);
+    MultiFab& state = fpi.get_mf();
+
+    if (diffuse_temp == 1) {
+	fill_edge_coeffs(coeffs_cc, temp_cond_coeff, bcoef);
+
+	MultiFab::Copy(phi, state, Temp, 0, 1, 1);
+	MultiFab::Copy(acoef, coeffs_cc, rho_cv_coeff, 0, 1, 0);
+    } else {
+	fill_edge_coeffs(coeffs_cc, enth_cond_coeff, bcoef);
+
+	// including the ghost cell, as for the temperature above
+	for (MFIter mfi(state); mfi.isValid(); ++mfi)
+	{
+	    const Box bx = amrex::grow(grids[mfi.index()], 1);
+
+	    make_enthalpy(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+			  BL_TO_FORTRAN_3D(state[mfi]),
+			  BL_TO_FORTRAN_3D(phi[mfi]));
+	}
+
+	MultiFab::Copy(acoef, state, Density, 0, 1, 0);
+    }
+
+    MultiFab::Copy(rhs, acoef, 0, 0, 1, 0);
+    MultiFab::Multiply(rhs, phi, 0, 0, 1, 0);
+}
+
+// Apply the solution to the state.  dE holds the coefficient a on
+// input and the change in the internal energy on output.
+
+void
+Castro::implicit_diffusion_finish(const MultiFab& phi, const MultiFab& phi_old, MultiFab& dE)
+{
+    MultiFab dphi(grids, dmap, 1, 0);
+    MultiFab::LinComb(dphi, 1.0, phi, 0, -1.0, phi_old, 0, 0, 1, 0);
+    MultiFab::Multiply(dE, dphi, 0, 0, 1, 0);
+
+    MultiFab& S_new = get_new_data(State_Type);
+
+    MultiFab::Add(S_new, dE, 0, Eden, 1, 0);
+    MultiFab::Add(S_new, dE, 0, Eint, 1, 0);
+
+    computeTemp(S_new);
+}
+
+// **********************************************************************************************
+
 #if (BL_SPACEDIM == 1)
 void
 Castro::add_spec_diffusion_to_source (MultiFab& ext_src, MultiFab& SpecDiffTerm, Real t, int is_old)
@@ -116,6 +606,92 @@ Castro::add_viscous_term_to_source(MultiFab& ext_src, MultiFab& ViscousTermforMo
 
 // **********************************************************************************************
 
+// The transport coefficients of the state at the given time at this
+// level.  They are computed with one EOS call per zone for all the
+// diffusion terms, and reused as long as the time matches; whoever
+// changes the state data at that time has to call
+// clear_transport_coeffs.
+
+const MultiFab&
+Castro::get_transport_coeffs(Real time)
+{
+    if (transport_coeffs.ok() && transport_coeffs_time == time) {
+        return transport_coeffs;
+    }
+
+    BL_PROFILE("Castro::get_transport_coeffs()");
+
+    const int do_cond = (diffuse_temp == 1 || diffuse_enth == 1 || diffuse_spec == 1);
+    const int do_visc = (diffuse_vel == 1);
+
+    transport_coeffs.clear();
+    transport_coeffs.define(grids, dmap, num_transport_coeffs, 1);
+
+    FillPatchIterator fpi(*this, get_new_data(State_Type), 1, time, State_Type, 0, NUM_STATE);
+    const MultiFab& state = fpi.get_mf();
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(transport_coeffs, true); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.growntilebox(1);
+
+        ca_fill_transport_coeffs(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+                                 BL_TO_FORTRAN_3D(state[mfi]),
+                                 BL_TO_FORTRAN_3D(transport_coeffs[mfi]),
+                                 do_cond, do_visc);
+    }
+
+    transport_coeffs_time = time;
+
+    return transport_coeffs;
+}
+
+void
+Castro::clear_transport_coeffs()
+{
+    transport_coeffs.clear();
+}
+
+// Average component comp of the cell-centered coefficients to the
+// edges, as needed by the diffusion operator.
+
+void
+Castro::fill_edge_coeffs(const MultiFab& coeffs_cc, int comp,
+                         Vector<std::unique_ptr<MultiFab> >& coeffs)
+{
+    coeffs.resize(BL_SPACEDIM);
+    for (int dir = 0; dir < BL_SPACEDIM; dir++) {
+        coeffs[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
+    }
+
+    // the dimension-agnostic Fortran also wants the unused directions
+    MultiFab dummy(grids, dmap, 1, 0);
+    Vector<MultiFab*> coeffs_3d(3, &dummy);
+    for (int dir = 0; dir < BL_SPACEDIM; dir++) {
+        coeffs_3d[dir] = coeffs[dir].get();
+    }
+
+    const int nc = coeffs_cc.nComp();
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(coeffs_cc); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.validbox();
+
+        ca_average_coeff_to_edges(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+                                  BL_TO_FORTRAN_3D(coeffs_cc[mfi]), nc, comp,
+                                  BL_TO_FORTRAN_3D((*coeffs_3d[0])[mfi]),
+                                  BL_TO_FORTRAN_3D((*coeffs_3d[1])[mfi]),
+                                  BL_TO_FORTRAN_3D((*coeffs_3d[2])[mfi]));
+    }
+}
+
+// **********************************************************************************************
+
 void
 Castro::getTempDiffusionTerm (Real time, MultiFab& TempDiffTerm, int is_old)
 {
@@ -134,18 +710,6 @@ Castro::getTempDiffusionTerm (Real time, MultiFab& TempDiffTerm, int is_old)
    if (verbose && ParallelDescriptor::IOProcessor())
       std::cout << "Calculating diffusion term at time " << time << std::endl;
 
-   // Fill coefficients at this level.
-   Vector<std::unique_ptr<MultiFab> >coeffs(BL_SPACEDIM);
-   Vector<std::unique_ptr<MultiFab> >coeffs_temporary(3); // This is what we pass to the dimension-agnostic Fortran
-   for (int dir = 0; dir < 3; dir++) {
-       if (dir < BL_SPACEDIM) {
-	   coeffs[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-	   coeffs_temporary[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-       } else {
-	   coeffs_temporary[dir].reset(new MultiFab(grids, dmap, 1, 0));
-       }
-   }
-
    // Fill temperature at this level.
    MultiFab Temperature(grids,dmap,1,1);
 
@@ -154,24 +718,11 @@ Castro::getTempDiffusionTerm (Real time, MultiFab& TempDiffTerm, int is_old)
        MultiFab& state = fpi.get_mf();
 
        MultiFab::Copy(Temperature, state, Temp, 0, 1, 1);
-
-       for (MFIter mfi(state); mfi.isValid(); ++mfi)
-       {
-	   const Box& bx = grids[mfi.index()];
-
-	   ca_fill_temp_cond(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
-			     BL_TO_FORTRAN_3D(state[mfi]),
-			     BL_TO_FORTRAN_3D((*coeffs_temporary[0])[mfi]),
-			     BL_TO_FORTRAN_3D((*coeffs_temporary[1])[mfi]),
-			     BL_TO_FORTRAN_3D((*coeffs_temporary[2])[mfi]));
-       }
    }
 
-   // Now copy the temporary array results back to the
-   // correctly dimensioned coeffs array.
-
-   for (int dir = 0; dir < BL_SPACEDIM; dir++)
-     MultiFab::Copy(*coeffs[dir], *coeffs_temporary[dir], 0, 0, 1, 0);
+   // Fill coefficients at this level.
+   Vector<std::unique_ptr<MultiFab> > coeffs;
+   fill_edge_coeffs(get_transport_coeffs(time), temp_cond_coeff, coeffs);
 
    MultiFab CrseTemp;
    if (level > 0) {
@@ -213,18 +764,6 @@ Castro::getEnthDiffusionTerm (Real time, MultiFab& DiffTerm, int is_old)
    if (verbose && ParallelDescriptor::IOProcessor())
       std::cout << "Calculating diffusion term at time " << time << std::endl;
 
-   // Fill coefficients at this level.
-   Vector<std::unique_ptr<MultiFab> > coeffs(BL_SPACEDIM);
-   Vector<std::unique_ptr<MultiFab> > coeffs_temporary(3); // This is what we pass to the dimension-agnostic Fortran
-   for (int dir = 0; dir < 3; dir++) {
-       if (dir < BL_SPACEDIM) {
-	   coeffs[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-	   coeffs_temporary[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-       } else {
-	   coeffs_temporary[dir].reset(new MultiFab(grids, dmap, 1, 0));
-       }
-   }
-
    // Define enthalpy at this level.
    MultiFab Enthalpy(grids,dmap,1,1);
    {
@@ -237,20 +776,12 @@ Castro::getEnthDiffusionTerm (Real time, MultiFab& DiffTerm, int is_old)
 	   make_enthalpy(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
 	                 BL_TO_FORTRAN_3D(state[mfi]),
 	                 BL_TO_FORTRAN_3D(Enthalpy[mfi]));
-
-	   ca_fill_enth_cond(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
-			     BL_TO_FORTRAN_3D(state[mfi]),
-			     BL_TO_FORTRAN_3D((*coeffs_temporary[0])[mfi]),
-			     BL_TO_FORTRAN_3D((*coeffs_temporary[1])[mfi]),
-			     BL_TO_FORTRAN_3D((*coeffs_temporary[2])[mfi]));
        }
    }
 
-   // Now copy the temporary array results back to the
-   // correctly dimensioned coeffs array.
-
-   for (int dir = 0; dir < BL_SPACEDIM; dir++)
-     MultiFab::Copy(*coeffs[dir], *coeffs_temporary[dir], 0, 0, 1, 0);
+   // Fill coefficients at this level.
+   Vector<std::unique_ptr<MultiFab> > coeffs;
+   fill_edge_coeffs(get_transport_coeffs(time), enth_cond_coeff, coeffs);
 
    MultiFab CrseEnth, CrseState;
    if (level > 0) {
@@ -302,37 +833,14 @@ Castro::getSpecDiffusionTerm (Real time, MultiFab& SpecDiffTerm, int is_old)
   if (verbose && ParallelDescriptor::IOProcessor())
     std::cout << "Calculating species diffusion term at time " << time << std::endl;
 
-  // Fill coefficients at this level.
-  Vector<std::unique_ptr<MultiFab> > coeffs(BL_SPACEDIM);
-  Vector<std::unique_ptr<MultiFab> > coeffs_temporary(3); // This is what we pass to the dimension-agnostic Fortran
-   for (int dir = 0; dir < 3; dir++) {
-       if (dir < BL_SPACEDIM) {
-	   coeffs[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-	   coeffs_temporary[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-       } else {
-	   coeffs_temporary[dir].reset(new MultiFab(grids, dmap, 1, 0));
-       }
-   }
+   // Fill coefficients at this level; the species coefficient is the
+   // same conductivity / c_p as for the enthalpy.
+   Vector<std::unique_ptr<MultiFab> > coeffs;
+   fill_edge_coeffs(get_transport_coeffs(time), enth_cond_coeff, coeffs);
 
    FillPatchIterator fpi(*this, *S, 1, time, State_Type, 0, NUM_STATE);
    MultiFab& state = fpi.get_mf();
 
-   for (MFIter mfi(state); mfi.isValid(); ++mfi)
-   {
-       const Box& bx = grids[mfi.index()];
-
-       ca_fill_spec_coeff(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
-			  BL_TO_FORTRAN_3D(state[mfi]),
-			  BL_TO_FORTRAN_3D((*coeffs_temporary[0])[mfi]),
-			  BL_TO_FORTRAN_3D((*coeffs_temporary[1])[mfi]),
-			  BL_TO_FORTRAN_3D((*coeffs_temporary[2])[mfi]));
-   }
-
-   // Now copy the temporary array results back to the
-   // correctly dimensioned coeffs array.
-   for (int dir = 0; dir < BL_SPACEDIM; dir++)
-     MultiFab::Copy(*coeffs[dir], *coeffs_temporary[dir], 0, 0, 1, 0);
-
    // Create MultiFabs that only hold the data for one species at a time.
    MultiFab Species(grids,dmap,1,1);
    MultiFab     SDT(grids,dmap,SpecDiffTerm.nComp(),SpecDiffTerm.nGrow());
@@ -403,18 +911,6 @@ Castro::getFirstViscousTerm (Real time, MultiFab& ViscousTerm)
 {
    MultiFab& S_old = get_old_data(State_Type);
 
-   // Fill coefficients at this level.
-   Vector<std::unique_ptr<MultiFab> > coeffs(BL_SPACEDIM);
-   Vector<std::unique_ptr<MultiFab> > coeffs_temporary(3); // This is what we pass to the dimension-agnostic Fortran
-   for (int dir = 0; dir < 3; dir++) {
-       if (dir < BL_SPACEDIM) {
-	   coeffs[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-	   coeffs_temporary[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-       } else {
-	   coeffs_temporary[dir].reset(new MultiFab(grids, dmap, 1, 0));
-       }
-   }
-
    // Fill velocity at this level.
    MultiFab Vel(grids,dmap,1,1);
 
@@ -425,21 +921,9 @@ Castro::getFirstViscousTerm (Real time, MultiFab& ViscousTerm)
    MultiFab::Copy  (Vel, state_old, Xmom   , 0, 1, 1);
    MultiFab::Divide(Vel, state_old, Density, 0, 1, 1);
 
-   for (MFIter mfi(state_old); mfi.isValid(); ++mfi)
-   {
-       const Box& bx = grids[mfi.index()];
-
-       ca_fill_first_visc_coeff(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
-				BL_TO_FORTRAN_3D(state_old[mfi]),
-				BL_TO_FORTRAN_3D((*coeffs_temporary[0])[mfi]),
-				BL_TO_FORTRAN_3D((*coeffs_temporary[1])[mfi]),
-				BL_TO_FORTRAN_3D((*coeffs_temporary[2])[mfi]));
-   }
-
-   // Now copy the temporary array results back to the
-   // correctly dimensioned coeffs array.
-   for (int dir = 0; dir < BL_SPACEDIM; dir++)
-     MultiFab::Copy(*coeffs[dir], *coeffs_temporary[dir], 0, 0, 1, 0);
+   // Fill coefficients at this level.
+   Vector<std::unique_ptr<MultiFab> > coeffs;
+   fill_edge_coeffs(get_transport_coeffs(time), first_visc_coeff, coeffs);
 
    MultiFab CrseVel, CrseDen;
    if (level > 0) {
@@ -470,18 +954,6 @@ Castro::getSecndViscousTerm (Real time, MultiFab& ViscousTerm)
 {
    MultiFab& S_old = get_old_data(State_Type);
 
-   // Fill coefficients at this level.
-   Vector<std::unique_ptr<MultiFab> > coeffs(BL_SPACEDIM);
-   Vector<std::unique_ptr<MultiFab> > coeffs_temporary(3); // This is what we pass to the dimension-agnostic Fortran
-   for (int dir = 0; dir < 3; dir++) {
-       if (dir < BL_SPACEDIM) {
-	   coeffs[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-	   coeffs_temporary[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-       } else {
-	   coeffs_temporary[dir].reset(new MultiFab(grids, dmap, 1, 0));
-       }
-   }
-
    // Fill velocity at this level.
    MultiFab Vel(grids,dmap,1,1);
 
@@ -492,21 +964,9 @@ Castro::getSecndViscousTerm (Real time, MultiFab& ViscousTerm)
    MultiFab::Copy  (Vel, state_old, Xmom   , 0, 1, 1);
    MultiFab::Divide(Vel, state_old, Density, 0, 1, 1);
 
-   for (MFIter mfi(state_old); mfi.isValid(); ++mfi)
-   {
-       const Box& bx = grids[mfi.index()];
-
-       ca_fill_secnd_visc_coeff(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
-				BL_TO_FORTRAN_3D(state_old[mfi]),
-				BL_TO_FORTRAN_3D((*coeffs_temporary[0])[mfi]),
-				BL_TO_FORTRAN_3D((*coeffs_temporary[1])[mfi]),
-				BL_TO_FORTRAN_3D((*coeffs_temporary[2])[mfi]));
-   }
-
-   // Now copy the temporary array results back to the
-   // correctly dimensioned coeffs array.
-   for (int dir = 0; dir < BL_SPACEDIM; dir++)
-     MultiFab::Copy(*coeffs[dir], *coeffs_temporary[dir], 0, 0, 1, 0);
+   // Fill coefficients at this level.
+   Vector<std::unique_ptr<MultiFab> > coeffs;
+   fill_edge_coeffs(get_transport_coeffs(time), secnd_visc_coeff, coeffs);
 
    MultiFab CrseVel, CrseDen;
    if (level > 0) {
@@ -537,18 +997,6 @@ Castro::getViscousTermForEnergy (Real time, MultiFab& ViscousTerm)
 {
    MultiFab& S_old = get_old_data(State_Type);
 
-   // Fill coefficients at this level.
-   Vector<std::unique_ptr<MultiFab> > coeffs(BL_SPACEDIM);
-   Vector<std::unique_ptr<MultiFab> > coeffs_temporary(3); // This is what we pass to the dimension-agnostic Fortran
-   for (int dir = 0; dir < 3; dir++) {
-       if (dir < BL_SPACEDIM) {
-	   coeffs[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-	   coeffs_temporary[dir].reset(new MultiFab(getEdgeBoxArray(dir), dmap, 1, 0));
-       } else {
-	   coeffs_temporary[dir].reset(new MultiFab(grids, dmap, 1, 0));
-       }
-   }
-
    FillPatchIterator fpi(*this,S_old,2,time,State_Type,0,NUM_STATE);
    MultiFab& state_old = fpi.get_mf();
 
@@ -19,6 +19,9 @@ Diffusion::Diffusion(Amr* Parent, BCRec* _phys_bc)
     grids(MAX_LEV),
     volume(MAX_LEV),
     area(MAX_LEV),
+#if (BL_SPACEDIM < 3)
+    coeffs_curv(MAX_LEV),
+#endif
     phys_bc(_phys_bc)
 {
     read_params();
@@ -59,6 +62,34 @@ Diffusion::install_level (int                   level,
 
     BoxArray ba(LevelData[level]->boxArray());
     grids[level] = ba;
+
+#if (BL_SPACEDIM < 3)
+    coeffs_curv[level].clear();
+#endif
+
+    mg_cache.clear(level);
+}
+
+MGSolverCache::Entry&
+Diffusion::get_mg_op (int level, MultiFab& phi, MultiFab& crse_phi,
+                      const Vector<std::unique_ptr<MultiFab> >& coef)
+{
+    bool built;
+    MGSolverCache::Entry& mg = mg_cache.get(level, {parent->Geom(level)},
+                                            {phi.boxArray()}, {phi.DistributionMap()},
+                                            mg_bc, std::max(verbose - 1, 0), built);
+
+    if (level > 0)
+        mg.op->setCoarseFineBC(&crse_phi, parent->refRatio(level-1)[0]);
+
+    mg.op->setLevelBC(0, &phi);
+
+    std::array<MultiFab const*,BL_SPACEDIM> b;
+    for (int n = 0; n < BL_SPACEDIM; ++n)
+        b[n] = coef[n].get();
+    mg.op->setBCoeffs(0, b);
+
+    return mg;
 }
 
 void
@@ -71,40 +102,40 @@ Diffusion::applyop (int level, MultiFab& Temperature,
         std::cout << "... compute diffusive term at level " << level << '\n';
     }
 
-    Vector<std::unique_ptr<MultiFab> > coeffs_curv;
+    Vector<std::unique_ptr<MultiFab> >* coeffs = &temp_cond_coef;
 #if (BL_SPACEDIM < 3)
     // NOTE: we just pass DiffTerm here to use in the MFIter loop...
     if (Geometry::IsRZ() || Geometry::IsSPHERICAL())
     {
-	coeffs_curv.resize(BL_SPACEDIM);
-
-	for (int i = 0; i< BL_SPACEDIM; ++i) {
-	    coeffs_curv[i].reset(new MultiFab(temp_cond_coef[i]->boxArray(),
-					      temp_cond_coef[i]->DistributionMap(),
-					      1, 0));
-	    MultiFab::Copy(*coeffs_curv[i], *temp_cond_coef[i], 0, 0, 1, 0);
+	// The conductivity changes from call to call, but the storage
+	// for its metric-weighted copy is kept until the grids change.
+
+	auto& cc = coeffs_curv[level];
+
+	if (cc.size() != BL_SPACEDIM ||
+	    cc[0]->boxArray() != temp_cond_coef[0]->boxArray() ||
+	    cc[0]->DistributionMap() != temp_cond_coef[0]->DistributionMap())
+	{
+	    cc.resize(BL_SPACEDIM);
+	    for (int i = 0; i< BL_SPACEDIM; ++i) {
+		cc[i].reset(new MultiFab(temp_cond_coef[i]->boxArray(),
+					 temp_cond_coef[i]->DistributionMap(),
+					 1, 0));
+	    }
 	}
 
-	applyMetricTerms(0, DiffTerm, coeffs_curv);
-    }
-#endif
-
-    auto & coeffs = (coeffs_curv.size() > 0) ? coeffs_curv : temp_cond_coef;
+	for (int i = 0; i< BL_SPACEDIM; ++i)
+	    MultiFab::Copy(*cc[i], *temp_cond_coef[i], 0, 0, 1, 0);
 
-    IntVect crse_ratio = level > 0 ? parent->refRatio(level-1)
-                                   : IntVect::TheZeroVector();
+	applyMetricTerms(level, DiffTerm, cc);
 
-    FMultiGrid fmg(parent->Geom(level), level, crse_ratio);
-
-    if (level == 0) {
-	fmg.set_bc(mg_bc, Temperature);
-    } else {
-	fmg.set_bc(mg_bc, CrseTemp, Temperature);
+	coeffs = &cc;
     }
+#endif
 
-    fmg.set_diffusion_coeffs(amrex::GetVecOfPtrs(coeffs));
+    MGSolverCache::Entry& mg = get_mg_op(level, Temperature, CrseTemp, *coeffs);
 
-    fmg.applyop(Temperature, DiffTerm);
+    mg.mlmg->apply({&DiffTerm}, {&Temperature});
 
 #if (BL_SPACEDIM < 3)
     // Do this to unweight Res
@@ -124,28 +155,17 @@ Diffusion::applyViscOp (int level, MultiFab& Vel,
         std::cout << "... compute second part of viscous term at level " << level << '\n';
     }
 
-    IntVect crse_ratio = level > 0 ? parent->refRatio(level-1)
-                                   : IntVect::TheZeroVector();
-
-    FMultiGrid fmg(parent->Geom(level), level, crse_ratio);
-
-    if (level == 0) {
-	fmg.set_bc(mg_bc, Vel);
-    } else {
-	fmg.set_bc(mg_bc, CrseVel, Vel);
-    }
-
-    // Here we DO NOT multiply the coefficients by (1/r^2) for spherical coefficients
-    // because we are computing (1/r^2) d/dr (const * d/dr(r^2 u))
-    fmg.set_diffusion_coeffs(amrex::GetVecOfPtrs(visc_coeff));
-
 #if (BL_SPACEDIM < 3)
-    // Here we weight the Vel going into the FMG applyop
+    // Here we weight the Vel going into the applyop
     if (Geometry::IsSPHERICAL() || Geometry::IsRZ() )
 	weight_cc(level, Vel);
 #endif
 
-    fmg.applyop(Vel, ViscTerm);
+    // Here we DO NOT multiply the coefficients by (1/r^2) for spherical coefficients
+    // because we are computing (1/r^2) d/dr (const * d/dr(r^2 u))
+    MGSolverCache::Entry& mg = get_mg_op(level, Vel, CrseVel, visc_coeff);
+
+    mg.mlmg->apply({&ViscTerm}, {&Vel});
 
 #if (BL_SPACEDIM < 3)
     // Do this to unweight Res
@@ -155,6 +175,75 @@ Diffusion::applyViscOp (int level, MultiFab& Vel,
 }
 #endif
 
+Real
+Diffusion::solve_implicit (int crse_level, int fine_level, Real beta,
+                           const Vector<MultiFab*>& phi,
+                           const Vector<MultiFab*>& rhs,
+                           const Vector<MultiFab*>& acoef,
+                           Vector<Vector<std::unique_ptr<MultiFab> > >& bcoef,
+                           MultiFab& CrsePhi,
+                           const Vector<Vector<MultiFab*> >& flux)
+{
+    BL_PROFILE("Diffusion::solve_implicit()");
+
+    if (verbose && ParallelDescriptor::IOProcessor()) {
+        std::cout << "   " << '\n';
+        std::cout << "... implicit diffusion solve at levels " << crse_level
+                  << " to " << fine_level << '\n';
+    }
+
+    int nlevs = fine_level - crse_level + 1;
+
+#if (BL_SPACEDIM < 3)
+    // In curvilinear coordinates the operator is metric-weighted, so
+    // the whole equation has to be.
+    if (Geometry::IsRZ() || Geometry::IsSPHERICAL())
+    {
+	for (int ilev = 0; ilev < nlevs; ++ilev) {
+	    int amr_lev = ilev + crse_level;
+	    applyMetricTerms(amr_lev, *rhs[ilev], bcoef[ilev]);
+	    weight_cc(amr_lev, *acoef[ilev]);
+	}
+    }
+#endif
+
+    Vector<Geometry> geom(nlevs);
+    Vector<Vector<MultiFab*> > b(nlevs);
+    for (int ilev = 0; ilev < nlevs; ++ilev) {
+	geom[ilev] = parent->Geom(ilev + crse_level);
+	b[ilev] = amrex::GetVecOfPtrs(bcoef[ilev]);
+    }
+
+    IntVect crse_ratio = crse_level > 0 ? parent->refRatio(crse_level-1)
+                                        : IntVect::TheZeroVector();
+
+    FMultiGrid fmg(geom, crse_level, crse_ratio);
+
+    if (crse_level == 0) {
+	fmg.set_bc(mg_bc, *phi[0]);
+    } else {
+	fmg.set_bc(mg_bc, CrsePhi, *phi[0]);
+    }
+
+    fmg.set_scalars(1.0, beta);
+    fmg.set_coefficients(acoef, b);
+
+    int always_use_bnorm = 0;
+    int need_grad_phi = 1;
+    Real final_resnorm = fmg.solve(phi, rhs, implicit_rel_tol, implicit_abs_tol,
+				   always_use_bnorm, need_grad_phi, verbose);
+
+    fmg.get_fluxes(flux);
+
+#if (BL_SPACEDIM < 3)
+    if (Geometry::IsRZ() || Geometry::IsSPHERICAL())
+	for (int ilev = 0; ilev < nlevs; ++ilev)
+	    unweight_edges(ilev + crse_level, flux[ilev]);
+#endif
+
+    return final_resnorm;
+}
+
 #if (BL_SPACEDIM < 3)
 void
 Diffusion::applyMetricTerms(int level, MultiFab& Rhs, Vector<std::unique_ptr<MultiFab> >& coeffs)
@@ -221,6 +310,27 @@ Diffusion::unweight_cc(int level, MultiFab& cc)
 }
 #endif
 
+#if (BL_SPACEDIM < 3)
+void
+Diffusion::unweight_edges(int level, const Vector<MultiFab*>& edges)
+{
+    const Real* dx = parent->Geom(level).CellSize();
+    const int coord_type = Geometry::Coord();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (int idir=0; idir<BL_SPACEDIM; ++idir) {
+	for (MFIter mfi(*edges[idir],true); mfi.isValid(); ++mfi)
+	{
+	    const Box& bx = mfi.tilebox();
+	    ca_unweight_edges(bx.loVect(), bx.hiVect(),
+			      BL_TO_FORTRAN((*edges[idir])[mfi]),
+			      dx,&coord_type,&idir);
+	}
+    }
+}
+#endif
+
 void
 Diffusion::make_mg_bc ()
 {
@@ -194,93 +194,6 @@ contains
 
 
   
-  ! This routine fills the species diffusion coefficients on the edges of a zone
-  ! by calling the cell-centered conductivity routine and averaging to
-  ! the interfaces
-
-  subroutine ca_fill_spec_coeff(lo,hi, &
-       state,s_lo,s_hi, &
-       coefx,cx_lo,cx_hi, &
-       coefy,cy_lo,cy_hi, &
-       coefz,cz_lo,cz_hi) &
-       bind(C, name="ca_fill_spec_coeff")
-
-    use bl_constants_module
-    use network, only: nspec, naux
-    use meth_params_module, only : NVAR, URHO, UTEMP, UEINT, UFS, UFX, diffuse_cutoff_density
-    use prob_params_module, only : dg
-    use conductivity_module
-    use eos_type_module
-    use eos_module, only : eos
-    use amrex_fort_module, only : rt => amrex_real
-    implicit none
-
-    integer         , intent(in   ) :: lo(3), hi(3)
-    integer         , intent(in   ) :: s_lo(3), s_hi(3)
-    integer         , intent(in   ) :: cx_lo(3), cx_hi(3), cy_lo(3), cy_hi(3), cz_lo(3), cz_hi(3)
-    real(rt)        , intent(in   ) :: state(s_lo(1):s_hi(1),s_lo(2):s_hi(2),s_lo(3):s_hi(3),NVAR)
-    real(rt)        , intent(inout) :: coefx(cx_lo(1):cx_hi(1),cx_lo(2):cx_hi(2),cx_lo(3):cx_hi(3))
-    real(rt)        , intent(inout) :: coefy(cy_lo(1):cy_hi(1),cy_lo(2):cy_hi(2),cy_lo(3):cy_hi(3))
-    real(rt)        , intent(inout) :: coefz(cz_lo(1):cz_hi(1),cz_lo(2):cz_hi(2),cz_lo(3):cz_hi(3))
-
-    ! local variables
-    integer          :: i, j, k
-    real(rt)         :: coef_cc(lo(1)-1:hi(1)+1,lo(2)-1:hi(2)+1,lo(3)-1:hi(3)+1)
-
-    type (eos_t) :: eos_state
-    real(rt)         :: coeff
-
-    ! fill the cell-centered diffusion coefficient
-
-    do k = lo(3)-1*dg(3),hi(3)+1*dg(3)
-       do j = lo(2)-1*dg(2),hi(2)+1*dg(2)
-          do i = lo(1)-1*dg(1),hi(1)+1*dg(1)
-             eos_state%rho    = state(i,j,k,URHO)
-             eos_state%T      = state(i,j,k,UTEMP)
-             eos_state%e      = state(i,j,k,UEINT)/state(i,j,k,URHO)
-             eos_state%xn(:)  = state(i,j,k,UFS:UFS-1+nspec)/ state(i,j,k,URHO)
-             eos_state%aux(:) = state(i,j,k,UFX:UFX-1+naux)/ state(i,j,k,URHO)
-             call eos(eos_input_re,eos_state)
-
-             if (eos_state%rho > diffuse_cutoff_density) then
-                call conductivity(eos_state, coeff)
-                coeff = coeff / eos_state%cp
-             else
-                coeff = ZERO
-             endif
-
-             coef_cc(i,j,k) = coeff
-          enddo
-       enddo
-    enddo
-
-    ! average to the interfaces
-    do k = lo(3),hi(3)
-       do j = lo(2),hi(2)
-          do i = lo(1),hi(1)+1*dg(1)
-             coefx(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i-1*dg(1),j,k))
-          end do
-       end do
-    enddo
-
-    do k = lo(3),hi(3)
-       do j = lo(2),hi(2)+1*dg(2)
-          do i = lo(1),hi(1)
-             coefy(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i,j-1*dg(2),k))
-          end do
-       end do
-    enddo
-
-    do k = lo(3),hi(3)+1*dg(3)
-       do j = lo(2),hi(2)
-          do i = lo(1),hi(1)
-             coefz(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i,j,k-1*dg(3)))
-          end do
-       end do
-    enddo
-
-  end subroutine ca_fill_spec_coeff
-
   ! This routine fills the thermal conductivity on the edges of a zone
   ! by calling the cell-centered conductivity routine and averaging to
   ! the interfaces
@@ -375,240 +288,126 @@ contains
 
   end subroutine ca_fill_temp_cond
 
-  ! This routine fills the coefficient of grad(enthalpy) on the edges of a zone
-  ! by calling the cell-centered conductivity routine and averaging to
-  ! the interfaces
-  
-  subroutine ca_fill_enth_cond(lo,hi, &
+  ! This routine fills all the cell-centered transport coefficients
+  ! with a single EOS call per zone, for the coefficient cache
+  ! (Castro::get_transport_coeffs).  The components are
+  !
+  !   0: the thermal conductivity (times diffuse_cond_scale_fac)
+  !   1: conductivity / c_p, the coefficient of grad(enthalpy) and
+  !      of the species gradients
+  !   2: rho c_v, for the implicit thermal diffusion update
+  !   3: 2 mu, the first viscous coefficient
+  !   4: bulk viscosity - 2/3 mu, the second viscous coefficient
+  !
+  ! The conductivity is only evaluated if do_cond = 1 and the
+  ! viscosity only if do_visc = 1; otherwise those components are zero.
+
+  subroutine ca_fill_transport_coeffs(lo,hi, &
        state,s_lo,s_hi, &
-       coefx,cx_lo,cx_hi, &
-       coefy,cy_lo,cy_hi, &
-       coefz,cz_lo,cz_hi) &
-       bind(C, name="ca_fill_enth_cond")
+       coef,c_lo,c_hi, &
+       do_cond, do_visc) &
+       bind(C, name="ca_fill_transport_coeffs")
 
     use bl_constants_module
     use network, only: nspec, naux
-    use meth_params_module, only : NVAR, URHO, UTEMP, UEINT, UFS, UFX, diffuse_cutoff_density
-    use prob_params_module, only : dg
+    use meth_params_module, only : NVAR, URHO, UTEMP, UEINT, UFS, UFX, &
+         diffuse_cutoff_density, diffuse_cond_scale_fac, small_temp
     use conductivity_module
+    use viscosity_module
     use eos_type_module
     use eos_module, only : eos
-
     use amrex_fort_module, only : rt => amrex_real
     implicit none
 
     integer         , intent(in   ) :: lo(3), hi(3)
     integer         , intent(in   ) :: s_lo(3), s_hi(3)
-    integer         , intent(in   ) :: cx_lo(3), cx_hi(3), cy_lo(3), cy_hi(3), cz_lo(3), cz_hi(3)
+    integer         , intent(in   ) :: c_lo(3), c_hi(3)
     real(rt)        , intent(in   ) :: state(s_lo(1):s_hi(1),s_lo(2):s_hi(2),s_lo(3):s_hi(3),NVAR)
-    real(rt)        , intent(inout) :: coefx(cx_lo(1):cx_hi(1),cx_lo(2):cx_hi(2),cx_lo(3):cx_hi(3))
-    real(rt)        , intent(inout) :: coefy(cy_lo(1):cy_hi(1),cy_lo(2):cy_hi(2),cy_lo(3):cy_hi(3))
-    real(rt)        , intent(inout) :: coefz(cz_lo(1):cz_hi(1),cz_lo(2):cz_hi(2),cz_lo(3):cz_hi(3))
+    real(rt)        , intent(inout) :: coef(c_lo(1):c_hi(1),c_lo(2):c_hi(2),c_lo(3):c_hi(3),0:4)
+    integer         , intent(in   ), value :: do_cond, do_visc
 
     ! local variables
     integer          :: i, j, k
-    real(rt)         :: coef_cc(lo(1)-1:hi(1)+1,lo(2)-1:hi(2)+1,lo(3)-1:hi(3)+1)
 
     type (eos_t) :: eos_state
-    real(rt)         :: cond
+    real(rt)         :: cond, mu, bulk_visc, twothirds
 
-    ! fill the cell-centered conductivity
+    bulk_visc = 0.e0_rt
+    twothirds = 2.e0_rt / 3.e0_rt
+
+    do k = lo(3),hi(3)
+       do j = lo(2),hi(2)
+          do i = lo(1),hi(1)
 
-    do k = lo(3)-1*dg(3),hi(3)+1*dg(3)
-       do j = lo(2)-1*dg(2),hi(2)+1*dg(2)
-          do i = lo(1)-1*dg(1),hi(1)+1*dg(1)
              eos_state%rho    = state(i,j,k,URHO)
-             eos_state%T      = state(i,j,k,UTEMP)
+             eos_state%T      = state(i,j,k,UTEMP)   ! needed as an initial guess
              eos_state%e      = state(i,j,k,UEINT)/state(i,j,k,URHO)
              eos_state%xn(:)  = state(i,j,k,UFS:UFS-1+nspec)/ state(i,j,k,URHO)
              eos_state%aux(:) = state(i,j,k,UFX:UFX-1+naux)/ state(i,j,k,URHO)
-             call eos(eos_input_re,eos_state)
 
-             if (eos_state%rho > diffuse_cutoff_density) then
-                call conductivity(eos_state, cond)
-                cond = cond / eos_state%cp
+             if (eos_state%e < ZERO) then
+                eos_state%T = small_temp
+                call eos(eos_input_rt,eos_state)
              else
-                cond = ZERO
+                call eos(eos_input_re,eos_state)
              endif
 
-             coef_cc(i,j,k) = cond
-          enddo
-       enddo
-    enddo
-
-    ! average to the interfaces
-    do k = lo(3),hi(3)
-       do j = lo(2),hi(2)
-          do i = lo(1),hi(1)+1*dg(1)
-             coefx(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i-1*dg(1),j,k))
-          end do
-       end do
-    enddo
-
-    do k = lo(3),hi(3)
-       do j = lo(2),hi(2)+1*dg(2)
-          do i = lo(1),hi(1)
-             coefy(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i,j-1*dg(2),k))
-          end do
-       end do
-    enddo
-
-    do k = lo(3),hi(3)+1*dg(3)
-       do j = lo(2),hi(2)
-          do i = lo(1),hi(1)
-             coefz(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i,j,k-1*dg(3)))
-          end do
-       end do
-    enddo
-
-  end subroutine ca_fill_enth_cond
-
-  ! This routine fills the viscous coefficients "mu" on the edges of a zone
-  ! by calling the cell-centered coefficient routine and averaging to
-  ! the interfaces
-  
-  subroutine ca_fill_first_visc_coeff(lo,hi, &
-       state,s_lo,s_hi, &
-       coefx,cx_lo,cx_hi, &
-       coefy,cy_lo,cy_hi, &
-       coefz,cz_lo,cz_hi) bind(C, name="ca_fill_first_visc_coeff")
-
-    use bl_constants_module
-    use network, only: nspec, naux
-    use meth_params_module, only : NVAR, URHO, UTEMP, UFS, UFX, diffuse_cutoff_density
-    use prob_params_module, only : dg
-    use viscosity_module
-    use eos_type_module
-
-    use amrex_fort_module, only : rt => amrex_real
-    implicit none
+             coef(i,j,k,2) = eos_state%rho * eos_state%cv
 
-    integer         , intent(in   ) :: lo(3), hi(3)
-    integer         , intent(in   ) :: s_lo(3), s_hi(3)
-    integer         , intent(in   ) :: cx_lo(3), cx_hi(3), cy_lo(3), cy_hi(3), cz_lo(3), cz_hi(3)
-    real(rt)        , intent(in   ) :: state(s_lo(1):s_hi(1),s_lo(2):s_hi(2),s_lo(3):s_hi(3),NVAR)
-    real(rt)        , intent(inout) :: coefx(cx_lo(1):cx_hi(1),cx_lo(2):cx_hi(2),cx_lo(3):cx_hi(3))
-    real(rt)        , intent(inout) :: coefy(cy_lo(1):cy_hi(1),cy_lo(2):cy_hi(2),cy_lo(3):cy_hi(3))
-    real(rt)        , intent(inout) :: coefz(cz_lo(1):cz_hi(1),cz_lo(2):cz_hi(2),cz_lo(3):cz_hi(3))
-
-    ! local variables
-    integer          :: i, j, k
-    real(rt)         :: coef_cc(lo(1)-1:hi(1)+1,lo(2)-1:hi(2)+1,lo(3)-1:hi(3)+1)
-
-    type (eos_t) :: eos_state
-    real(rt)         :: coeff
-
-    ! fill the cell-centered viscous coefficient
+             if (do_cond == 1 .and. eos_state%rho > diffuse_cutoff_density) then
+                call conductivity(eos_state, cond)
+             else
+                cond = ZERO
+             endif
 
-    do k = lo(3)-1*dg(3),hi(3)+1*dg(3)
-       do j = lo(2)-1*dg(2),hi(2)+1*dg(2)
-          do i = lo(1)-1*dg(1),hi(1)+1*dg(1)
-             eos_state%rho    = state(i,j,k,URHO)
-             eos_state%T      = state(i,j,k,UTEMP)
-             eos_state%xn(:)  = state(i,j,k,UFS:UFS-1+nspec)
-             eos_state%aux(:) = state(i,j,k,UFX:UFX-1+naux)
+             coef(i,j,k,0) = diffuse_cond_scale_fac * cond
+             coef(i,j,k,1) = cond / eos_state%cp
 
-             if (eos_state%rho > diffuse_cutoff_density) then
-                call viscous_coeff(eos_state, coeff)
+             if (do_visc == 1 .and. eos_state%rho > diffuse_cutoff_density) then
+                call viscous_coeff(eos_state, mu)
              else
-                coeff = ZERO
+                mu = ZERO
              endif
-             coef_cc(i,j,k) = 2.e0_rt * coeff
-          enddo
-       enddo
-    enddo
 
-    ! average to the interfaces
-    do k = lo(3),hi(3)
-       do j = lo(2),hi(2)
-          do i = lo(1),hi(1)+1*dg(1)
-             coefx(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i-1*dg(1),j,k))
-          end do
-       end do
-    enddo
+             coef(i,j,k,3) = 2.e0_rt * mu
+             coef(i,j,k,4) = bulk_visc - twothirds*mu
 
-    do k = lo(3),hi(3)
-       do j = lo(2),hi(2)+1*dg(2)
-          do i = lo(1),hi(1)
-             coefy(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i,j-1*dg(2),k))
-          end do
-       end do
-    enddo
-
-    do k = lo(3),hi(3)+1*dg(3)
-       do j = lo(2),hi(2)
-          do i = lo(1),hi(1)
-             coefz(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i,j,k-1*dg(3)))
-          end do
-       end do
+          enddo
+       enddo
     enddo
 
-  end subroutine ca_fill_first_visc_coeff
+  end subroutine ca_fill_transport_coeffs
 
+  ! This routine averages component comp of a cell-centered coefficient
+  ! to the interfaces of the zones in lo:hi
 
-  
-  subroutine ca_fill_secnd_visc_coeff(lo,hi, &
-       state,s_lo,s_hi, &
+  subroutine ca_average_coeff_to_edges(lo,hi, &
+       coef_cc,c_lo,c_hi,nc,comp, &
        coefx,cx_lo,cx_hi, &
        coefy,cy_lo,cy_hi, &
-       coefz,cz_lo,cz_hi) bind(C, name="ca_fill_secnd_visc_coeff")
+       coefz,cz_lo,cz_hi) &
+       bind(C, name="ca_average_coeff_to_edges")
 
-    use bl_constants_module
-    use network, only: nspec, naux
-    use meth_params_module, only : NVAR, URHO, UTEMP, UFS, UFX, diffuse_cutoff_density
     use prob_params_module, only : dg
-    use viscosity_module
-    use eos_type_module
-
     use amrex_fort_module, only : rt => amrex_real
     implicit none
 
     integer         , intent(in   ) :: lo(3), hi(3)
-    integer         , intent(in   ) :: s_lo(3), s_hi(3)
+    integer         , intent(in   ) :: c_lo(3), c_hi(3)
+    integer         , intent(in   ), value :: nc, comp
     integer         , intent(in   ) :: cx_lo(3), cx_hi(3), cy_lo(3), cy_hi(3), cz_lo(3), cz_hi(3)
-    real(rt)        , intent(in   ) :: state(s_lo(1):s_hi(1),s_lo(2):s_hi(2),s_lo(3):s_hi(3),NVAR)
+    real(rt)        , intent(in   ) :: coef_cc(c_lo(1):c_hi(1),c_lo(2):c_hi(2),c_lo(3):c_hi(3),0:nc-1)
     real(rt)        , intent(inout) :: coefx(cx_lo(1):cx_hi(1),cx_lo(2):cx_hi(2),cx_lo(3):cx_hi(3))
     real(rt)        , intent(inout) :: coefy(cy_lo(1):cy_hi(1),cy_lo(2):cy_hi(2),cy_lo(3):cy_hi(3))
     real(rt)        , intent(inout) :: coefz(cz_lo(1):cz_hi(1),cz_lo(2):cz_hi(2),cz_lo(3):cz_hi(3))
 
     ! local variables
     integer          :: i, j, k
-    real(rt)         :: coef_cc(lo(1)-1:hi(1)+1,lo(2)-1:hi(2)+1,lo(3)-1:hi(3)+1)
-
-    type (eos_t) :: eos_state
-    real(rt)         :: bulk_visc, mu, twothirds
-
-    bulk_visc = 0.e0_rt
-    twothirds = 2.e0_rt / 3.e0_rt
-
-    ! fill the cell-centered viscous coefficient
-
-    do k = lo(3)-1*dg(3),hi(3)+1*dg(3)
-       do j = lo(2)-1*dg(2),hi(2)+1*dg(2)
-          do i = lo(1)-1*dg(1),hi(1)+1*dg(1)
-             eos_state%rho    = state(i,j,k,URHO)
-             eos_state%T      = state(i,j,k,UTEMP)
-             eos_state%xn(:)  = state(i,j,k,UFS:UFS-1+nspec)
-             eos_state%aux(:) = state(i,j,k,UFX:UFX-1+naux)
-
-             if (eos_state%rho > diffuse_cutoff_density) then
-                call viscous_coeff(eos_state, mu)
-             else
-                mu = ZERO
-             endif
-             !          coef_cc(i,j,k) = coeff
-
-             coef_cc(i,j,k) = (bulk_visc - twothirds*mu)
 
-          enddo
-       enddo
-    enddo
-
-    ! average to the interfaces
     do k = lo(3),hi(3)
        do j = lo(2),hi(2)
           do i = lo(1),hi(1)+1*dg(1)
-             coefx(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i-1*dg(1),j,k))
+             coefx(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k,comp) + coef_cc(i-1*dg(1),j,k,comp))
           end do
        end do
     enddo
@@ -616,7 +415,7 @@ contains
     do k = lo(3),hi(3)
        do j = lo(2),hi(2)+1*dg(2)
           do i = lo(1),hi(1)
-             coefy(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i,j-1*dg(2),k))
+             coefy(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k,comp) + coef_cc(i,j-1*dg(2),k,comp))
           end do
        end do
     enddo
@@ -624,12 +423,13 @@ contains
     do k = lo(3),hi(3)+1*dg(3)
        do j = lo(2),hi(2)
           do i = lo(1),hi(1)
-             coefz(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k) + coef_cc(i,j,k-1*dg(3)))
+             coefz(i,j,k) = 0.5e0_rt * (coef_cc(i,j,k,comp) + coef_cc(i,j,k-1*dg(3),comp))
           end do
        end do
     enddo
 
-  end subroutine ca_fill_secnd_visc_coeff
+  end subroutine ca_average_coeff_to_edges
+
 
 
   
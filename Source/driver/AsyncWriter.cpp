@@ -0,0 +1,409 @@
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Utility.H>
+
+#include "AsyncWriter.H"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+using namespace amrex;
+
+bool AsyncWriter::active = false;
+int AsyncWriter::max_files = 1;
+
+namespace {
+
+  struct Job {
+    std::unique_ptr<MultiFab> data;  // the staging copy
+    std::string name;                // full path of the MultiFab
+    std::string header;              // VisMF header (I/O processor only)
+    std::string fab_file;            // the file this processor writes to
+    Vector<long> offset;             // where each FAB starts in its file
+    int file;                        // the plotfile or checkpoint it belongs to
+    bool released;
+    bool done;
+    std::string error;               // set by the thread if writing failed
+  };
+
+  // Jobs are written in order.  The thread only reads the jobs and
+  // sets done and error; the main thread appends them, releases them,
+  // and frees the ones that are done (the arena is not thread safe).
+  // The thread must not abort or communicate, so its errors are
+  // reported from the main thread.
+  std::deque<Job> jobs;
+  std::mutex jobs_mutex;
+  std::condition_variable jobs_cv;
+
+  std::thread writer;
+  bool stop_writer = false;
+  int current_file = 0;
+
+  // checkpoints that get the completion marker once their jobs are
+  // done (main thread only, the same on every processor)
+  struct Mark {
+    int file;
+    std::string dir;
+  };
+  std::deque<Mark> marks;
+
+  const std::string temp_suffix(".temp");
+
+  // Processor p writes its FABs to file p % nfiles, after the data of
+  // the processors before it in that file, as VisMF does with NFiles
+  // files.
+  int num_fab_files()
+  {
+    return std::max(1, std::min(VisMF::GetNOutFiles(), ParallelDescriptor::NProcs()));
+  }
+
+  std::string fab_file_name(const std::string& name, int n)
+  {
+    return amrex::Concatenate(name + "_D_", n, 5);
+  }
+
+  // bytes that FArrayBox::writeOn writes for fab (native format)
+  long fab_bytes(const FArrayBox& fab)
+  {
+    std::ostringstream os;
+    FArrayBox::getFABio().write_header(os, fab, fab.nComp());
+    return static_cast<long>(os.str().size()) + fab.nBytes();
+  }
+
+  // Returns an error message, empty on success.
+  std::string write_job(const Job& job)
+  {
+    // No MFIter here: it is not meant to be used off the main thread.
+    const MultiFab& mf = *job.data;
+    const Vector<int>& index = mf.IndexArray();
+
+    if (!index.empty()) {
+      const std::string& file = job.fab_file;
+
+      // The other processors of the file write to it at the same time,
+      // each to its own part, so it is created without truncating it.
+      {
+        std::ofstream create(file.c_str(), std::ios::out | std::ios::app | std::ios::binary);
+        if (!create.good()) {
+          return "AsyncWriter: could not open " + file;
+        }
+      }
+
+      std::fstream ofs(file.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+      if (!ofs.good()) {
+        return "AsyncWriter: could not open " + file;
+      }
+      ofs.seekp(job.offset[index[0]]);
+      for (int i : index) {
+        if (static_cast<long>(ofs.tellp()) != job.offset[i]) {
+          return "AsyncWriter: unexpected FAB offset in " + file;
+        }
+        mf[i].writeOn(ofs);
+      }
+      ofs.close();
+      if (ofs.fail()) {
+        return "AsyncWriter: failed writing " + file;
+      }
+    }
+
+    if (!job.header.empty()) {
+      const std::string file = job.name + "_H";
+      std::ofstream ofs(file.c_str(), std::ios::out | std::ios::trunc);
+      if (!ofs.good()) {
+        return "AsyncWriter: could not open " + file;
+      }
+      ofs << job.header;
+      ofs.close();
+      if (ofs.fail()) {
+        return "AsyncWriter: failed writing " + file;
+      }
+    }
+
+    return std::string();
+  }
+
+  bool all_done()
+  {
+    for (const Job& j : jobs) {
+      if (!j.done) return false;
+    }
+    return true;
+  }
+
+}
+
+void AsyncWriter::Initialize(int max_outstanding)
+{
+  if (active) return;
+
+  // The FAB offsets in the headers are computed before the data is
+  // written, which needs the size of the data on disk.
+  if (FArrayBox::getFormat() != FABio::FAB_NATIVE) {
+    amrex::Error("castro.async_io needs fab.format = NATIVE");
+  }
+
+  max_files = std::max(max_outstanding, 1);
+  stop_writer = false;
+  writer = std::thread(&AsyncWriter::work);
+  active = true;
+}
+
+void AsyncWriter::Finalize()
+{
+  if (!active) return;
+
+  Wait();
+
+  {
+    std::lock_guard<std::mutex> lock(jobs_mutex);
+    stop_writer = true;
+  }
+  jobs_cv.notify_all();
+  writer.join();
+
+  active = false;
+}
+
+void AsyncWriter::work()
+{
+  std::unique_lock<std::mutex> lock(jobs_mutex);
+
+  for (;;) {
+    Job* job = nullptr;
+
+    jobs_cv.wait(lock, [&job] {
+        job = nullptr;
+        for (Job& j : jobs) {
+          if (!j.done) {
+            if (j.released) job = &j;
+            break;
+          }
+        }
+        return job != nullptr || stop_writer;
+      });
+
+    if (job == nullptr) {
+      return;
+    }
+
+    // References to deque elements survive push_back, and the main
+    // thread only erases jobs that are done.
+    lock.unlock();
+    std::string error = write_job(*job);
+    lock.lock();
+
+    job->error = error;
+    job->done = true;
+    jobs_cv.notify_all();
+  }
+}
+
+void AsyncWriter::reap()
+{
+  std::string error;
+
+  {
+    std::lock_guard<std::mutex> lock(jobs_mutex);
+
+    while (!jobs.empty() && jobs.front().done) {
+      if (error.empty()) {
+        error = jobs.front().error;
+      }
+      jobs.pop_front();
+    }
+  }
+
+  if (!error.empty()) {
+    amrex::Abort(error);
+  }
+}
+
+int AsyncWriter::outstanding_files()
+{
+  int n = 0;
+  int last = -1;
+  for (const Job& j : jobs) {
+    if (!j.done && j.file != last) {
+      n++;
+      last = j.file;
+    }
+  }
+  return n;
+}
+
+void AsyncWriter::mark_done()
+{
+  while (!marks.empty()) {
+    bool done = true;
+    {
+      std::lock_guard<std::mutex> lock(jobs_mutex);
+      for (const Job& j : jobs) {
+        if (j.file == marks.front().file && !j.done) {
+          done = false;
+          break;
+        }
+      }
+    }
+
+    ParallelDescriptor::ReduceBoolAnd(done);
+    if (!done) {
+      break;
+    }
+
+    if (ParallelDescriptor::IOProcessor()) {
+      const std::string file = CompleteFile(marks.front().dir);
+      std::ofstream ofs(file.c_str(), std::ios::out | std::ios::trunc);
+      if (!ofs.good()) {
+        amrex::FileOpenFailed(file);
+      }
+      ofs << "complete" << std::endl;
+    }
+
+    marks.pop_front();
+  }
+}
+
+void AsyncWriter::MarkWhenDone(const std::string& dir)
+{
+  Mark m;
+  m.file = current_file;
+  m.dir = FinalDir(dir);
+  marks.push_back(m);
+}
+
+void AsyncWriter::BeginFile()
+{
+  BL_PROFILE("AsyncWriter::BeginFile()");
+
+  Release();
+
+  {
+    std::unique_lock<std::mutex> lock(jobs_mutex);
+    jobs_cv.wait(lock, [] { return outstanding_files() < max_files; });
+    current_file++;
+  }
+
+  reap();
+}
+
+void AsyncWriter::Write(std::unique_ptr<MultiFab>&& mf,
+                        const std::string& name, VisMF::How how)
+{
+  BL_PROFILE("AsyncWriter::Write()");
+
+  BL_ASSERT(active);
+
+  // The header holds the min and max of every FAB and where it is
+  // written, which takes communication, so it is built here.  The FABs
+  // of processor p go to name_D_(p % nfiles) in the order of their
+  // index, after those of the processors p - nfiles, p - 2 nfiles, ...
+  VisMF::Header hdr(*mf, how);
+
+  const int nprocs = ParallelDescriptor::NProcs();
+  const int myproc = ParallelDescriptor::MyProc();
+  const int nfiles = num_fab_files();
+
+  Job job;
+
+  Vector<long> proc_bytes(nprocs, 0L);
+  job.offset.resize(mf->size(), 0L);
+  for (int i : mf->IndexArray()) {
+    job.offset[i] = proc_bytes[myproc];
+    proc_bytes[myproc] += fab_bytes((*mf)[i]);
+  }
+
+  ParallelDescriptor::ReduceLongSum(proc_bytes.dataPtr(), nprocs);
+
+  long start = 0;
+  for (int p = myproc % nfiles; p < myproc; p += nfiles) {
+    start += proc_bytes[p];
+  }
+  for (int i : mf->IndexArray()) {
+    job.offset[i] += start;
+  }
+
+  Vector<long> offset(job.offset);
+  ParallelDescriptor::ReduceLongSum(offset.dataPtr(), offset.size(),
+                                    ParallelDescriptor::IOProcessorNumber());
+
+  const std::string base = VisMF::BaseName(name);
+  const DistributionMapping& dm = mf->DistributionMap();
+  for (int i = 0; i < mf->size(); i++) {
+    hdr.m_fod[i] = VisMF::FabOnDisk(fab_file_name(base, dm[i] % nfiles), offset[i]);
+  }
+
+  if (ParallelDescriptor::IOProcessor()) {
+    std::ostringstream os;
+    os << hdr;
+    job.header = os.str();
+  }
+
+  job.data = std::move(mf);
+  job.name = name;
+  job.fab_file = fab_file_name(name, myproc % nfiles);
+  job.file = current_file;
+  job.released = false;
+  job.done = false;
+
+  std::lock_guard<std::mutex> lock(jobs_mutex);
+  jobs.push_back(std::move(job));
+}
+
+void AsyncWriter::Release()
+{
+  {
+    std::lock_guard<std::mutex> lock(jobs_mutex);
+    for (Job& j : jobs) {
+      if (!j.released) j.released = true;
+    }
+  }
+  jobs_cv.notify_all();
+
+  reap();
+
+  mark_done();
+}
+
+void AsyncWriter::Wait()
+{
+  BL_PROFILE("AsyncWriter::Wait()");
+
+  Release();
+
+  {
+    std::unique_lock<std::mutex> lock(jobs_mutex);
+    jobs_cv.wait(lock, [] { return all_done(); });
+  }
+
+  reap();
+
+  ParallelDescriptor::Barrier();
+
+  mark_done();
+}
+
+std::string AsyncWriter::FinalDir(const std::string& dir)
+{
+  std::string final_dir = dir;
+
+  while (!final_dir.empty() && final_dir[final_dir.size()-1] == '/') {
+    final_dir.erase(final_dir.size()-1);
+  }
+
+  const std::size_t n = temp_suffix.size();
+  if (final_dir.size() > n &&
+      final_dir.compare(final_dir.size() - n, n, temp_suffix) == 0) {
+    final_dir.erase(final_dir.size() - n);
+  }
+
+  return final_dir;
+}
+
+std::string AsyncWriter::CompleteFile(const std::string& dir)
+{
+  return FinalDir(dir) + "/AsyncIOComplete";
+}
@@ -22,6 +22,8 @@
 #include <AMReX_TagBox.H>
 #include <AMReX_FillPatchUtil.H>
 #include <AMReX_ParmParse.H>
+#include "AsyncWriter.H"
+#include "FabCompress.H"
 
 #ifdef RADIATION
 #include "Radiation.H"
@@ -133,6 +135,10 @@ IntVect      Castro::hydro_tile_size(1024,16);
 IntVect      Castro::hydro_tile_size(1024,16,16);
 #endif
 
+Vector<std::string> Castro::compress_plot_vars;
+Vector<int>         Castro::compress_plot_modes;
+Vector<Real>        Castro::compress_plot_tols;
+
 // this will be reset upon restart
 Real         Castro::previousCPUTimeUsed = 0.0;
 
@@ -184,6 +190,9 @@ Castro::variableCleanUp ()
   TracerPC = 0;
 #endif
 
+    // finish writing the last plotfiles and checkpoints
+    AsyncWriter::Finalize();
+
     desc_lst.clear();
 
     ca_finalize_meth_params();
@@ -324,6 +333,16 @@ Castro::read_params ()
 	pp.add("ppm_trace_sources",ppm_trace_sources);
       }
 
+#ifdef SDC
+    // the convergence check compares two successive iterates before
+    // the last iteration, so it needs at least three iterations
+    if (sdc_tol > 0.0 && sdc_iters < 3)
+      {
+	if (ParallelDescriptor::IOProcessor())
+	    std::cout << "WARNING: castro.sdc_tol has no effect unless castro.sdc_iters >= 3" << std::endl;
+      }
+#endif
+
 
     if (hybrid_riemann == 1 && BL_SPACEDIM == 1)
       {
@@ -353,6 +372,34 @@ Castro::read_params ()
 	amrex::Error();
       }
 
+#ifdef REACTIONS
+#ifdef SDC
+    if (use_burn_cache)
+        amrex::Error("use_burn_cache is not supported with SDC");
+#endif
+
+    if (use_burn_cache && do_acc == 1)
+        amrex::Error("use_burn_cache is not supported with do_acc = 1");
+
+    if (use_burn_cache && (burn_cache_size <= 0 || burn_cache_dlogrho <= 0.0 ||
+                           burn_cache_dlogT <= 0.0 || burn_cache_dX <= 0.0))
+        amrex::Error("burn_cache_size and the burn cache quantization widths must be positive");
+#endif
+
+#ifdef DIFFUSION
+    if (diffusion_sts && diffusion_sts_max_stages < 2)
+        amrex::Error("diffusion_sts_max_stages must be at least 2");
+
+    if (diffusion_implicit < 0 || diffusion_implicit > 2)
+        amrex::Error("diffusion_implicit must be 0, 1 or 2");
+
+    if (diffusion_implicit && diffusion_sts)
+        amrex::Error("diffusion_implicit and diffusion_sts cannot both be used");
+
+    if (diffusion_implicit && diffuse_temp == 0 && diffuse_enth == 0)
+        amrex::Error("diffusion_implicit requires diffuse_temp or diffuse_enth");
+#endif
+
 #ifdef PARTICLES
     read_particle_params();
 #endif
@@ -397,6 +444,47 @@ Castro::read_params ()
 	for (int i=0; i<BL_SPACEDIM; i++) hydro_tile_size[i] = tilesize[i];
     }
 
+    if (async_io) {
+        if (async_io_max_outstanding < 1)
+            amrex::Error("async_io_max_outstanding must be at least 1");
+
+        AsyncWriter::Initialize(async_io_max_outstanding);
+
+        if (verbose && ParallelDescriptor::IOProcessor())
+            std::cout << "Writing plotfiles and checkpoints asynchronously, at most "
+                      << async_io_max_outstanding << " outstanding" << std::endl;
+    }
+
+    if (compress_plot_rel_tol < 0.0)
+        amrex::Error("compress_plot_rel_tol must be non-negative");
+
+    // per-variable error bounds for compressed plotfiles, e.g.
+    //   castro.compress_plot_vars      = density Temp
+    //   castro.compress_plot_tols      = 1.e-8   1.e-4
+    //   castro.compress_plot_tol_types = rel     abs
+    int nvars = pp.countval("compress_plot_vars");
+    if (nvars > 0)
+    {
+        Vector<std::string> tol_types;
+        pp.getarr("compress_plot_vars", compress_plot_vars, 0, nvars);
+        pp.getarr("compress_plot_tols", compress_plot_tols, 0, nvars);
+        pp.getarr("compress_plot_tol_types", tol_types, 0, nvars);
+
+        compress_plot_modes.resize(nvars);
+        for (int i = 0; i < nvars; i++) {
+            if (compress_plot_tols[i] < 0.0)
+                amrex::Error("compress_plot_tols must be non-negative");
+            if (compress_plot_tols[i] == 0.0)
+                compress_plot_modes[i] = FabCompress::Lossless;
+            else if (tol_types[i] == "abs")
+                compress_plot_modes[i] = FabCompress::Absolute;
+            else if (tol_types[i] == "rel")
+                compress_plot_modes[i] = FabCompress::Relative;
+            else
+                amrex::Error("compress_plot_tol_types must be abs or rel");
+        }
+    }
+
 }
 
 Castro::Castro ()
@@ -1164,42 +1252,18 @@ Castro::estTimeStep (Real dt_old)
 #ifdef DIFFUSION
 	// Diffusion-limited timestep
 	// Note that the diffusion uses the same CFL safety factor
-	// as the main hydrodynamics timestep limiter.
-	if (diffuse_temp)
+	// as the main hydrodynamics timestep limiter.  With
+	// super-time-stepping the diffusion update is stable up to the
+	// RKL2 stability factor of the largest allowed number of stages,
+	// and implicit diffusion does not limit the timestep.
+	if ((diffuse_temp or diffuse_enth) && !diffusion_implicit)
 	{
-#ifdef _OPENMP
-#pragma omp parallel reduction(min:estdt_hydro)
-#endif
-          {
-            Real dt = max_dt / cfl;
+	  Real dt = estdt_diffusion(stateMF);
 
-            for (MFIter mfi(stateMF,true); mfi.isValid(); ++mfi)
-              {
-                const Box& box = mfi.tilebox();
-                ca_estdt_temp_diffusion(ARLIM_3D(box.loVect()), ARLIM_3D(box.hiVect()),
-                                        BL_TO_FORTRAN_3D(stateMF[mfi]),
-                                        ZFILL(dx),&dt);
-              }
-            estdt_hydro = std::min(estdt_hydro, dt);
-          }
-	}
-	if (diffuse_enth)
-	{
-#ifdef _OPENMP
-#pragma omp parallel reduction(min:estdt_hydro)
-#endif
-          {
-            Real dt = max_dt / cfl;
-              
-            for (MFIter mfi(stateMF,true); mfi.isValid(); ++mfi)
-              {
-                const Box& box = mfi.tilebox();
-                ca_estdt_enth_diffusion(ARLIM_3D(box.loVect()), ARLIM_3D(box.hiVect()),
-                                        BL_TO_FORTRAN_3D(stateMF[mfi]),
-                                        ZFILL(dx),&dt);
-              }
-            estdt_hydro = std::min(estdt_hydro, dt);
-          }
+	  if (diffusion_sts)
+	    dt *= rkl2_stability_factor(diffusion_sts_max_stages);
+
+	  estdt_hydro = std::min(estdt_hydro, dt);
 	}
 #endif  // diffusion
 
@@ -1564,6 +1628,14 @@ Castro::post_timestep (int iteration)
 
     clean_state(S_new);
 
+#ifdef DIFFUSION
+    // With all levels at the new time, do the composite implicit
+    // thermal diffusion solve.
+
+    if (level == 0 && diffusion_implicit == 2)
+	implicit_diffusion_composite(state[State_Type].curTime(), parent->dtLevel(0));
+#endif
+
     // Flush Fortran output
 
     if (verbose)
@@ -2261,7 +2333,50 @@ Castro::reflux(int crse_level, int fine_level)
     Vector<std::unique_ptr<MultiFab> > drho(nlevs);
     Vector<std::unique_ptr<MultiFab> > dphi(nlevs);
 
-    if (do_grav && gravity->get_gravity_type() == "PoissonGrav" && gravity->NoSync() == 0)  {
+    bool do_grav_sync = do_grav && gravity->get_gravity_type() == "PoissonGrav" && gravity->NoSync() == 0;
+
+    if (do_grav_sync) {
+
+	// Fill the grad phi registers and decide whether the sync solve is
+	// needed at all, before building the sync RHS on every level.
+	// Note that the scaling by the area here is corrected for by dividing by the
+	// cell volume in the reflux. In this way we get a discrete divergence that
+	// is analogous to the divergence of the flux in the hydrodynamics. See Equation
+	// 37 in the Castro I paper. The dimensions of dphi are therefore actually
+	// phi / cm**2, which makes it correct for the RHS of the Poisson equation.
+
+	Vector<const FluxRegister*> mass_reg, grav_reg;
+
+	for (int lev = fine_level; lev > crse_level; --lev) {
+
+	    Castro& crse_lev = getLevel(lev-1);
+	    Castro& fine_lev = getLevel(lev);
+
+	    for (int i = 0; i < BL_SPACEDIM; ++i) {
+		fine_lev.phi_reg.CrseInit(*(gravity->get_grad_phi_curr(lev-1)[i]), crse_lev.area[i], i, 0, 0, 1, -1.0);
+		fine_lev.phi_reg.FineAdd(*(gravity->get_grad_phi_curr(lev)[i]), fine_lev.area[i], i, 0, 0, 1, 1.0);
+	    }
+
+	    fine_lev.flux_reg.ClearInternalBorders(crse_lev.geom);
+	    fine_lev.phi_reg.ClearInternalBorders(crse_lev.geom);
+
+	    mass_reg.push_back(&fine_lev.flux_reg);
+	    grav_reg.push_back(&fine_lev.phi_reg);
+
+	}
+
+	if (gravity->skip_sync(crse_level, mass_reg, grav_reg)) {
+
+	    do_grav_sync = false;
+
+	    for (int lev = fine_level; lev > crse_level; --lev)
+		getLevel(lev).phi_reg.setVal(0.0);
+
+	}
+
+    }
+
+    if (do_grav_sync) {
 
 	for (int lev = crse_level; lev <= fine_level; ++lev) {
 
@@ -2287,7 +2402,6 @@ Castro::reflux(int crse_level, int fine_level)
 	reg = &getLevel(lev).flux_reg;
 
 	Castro& crse_lev = getLevel(lev-1);
-	Castro& fine_lev = getLevel(lev);
 
 	MultiFab& state = crse_lev.get_new_data(State_Type);
 
@@ -2305,7 +2419,7 @@ Castro::reflux(int crse_level, int fine_level)
 #ifdef SELF_GRAVITY
 	int ilev = lev - crse_level - 1;
 
-	if (do_grav && gravity->get_gravity_type() == "PoissonGrav" && gravity->NoSync() == 0) {
+	if (do_grav_sync) {
 	    reg->Reflux(*drho[ilev], crse_lev.volume, 1.0, 0, Density, 1, crse_lev.geom);
 	    amrex::average_down(*drho[ilev + 1], *drho[ilev], 0, 1, getLevel(lev).crse_ratio);
 	}
@@ -2423,20 +2537,11 @@ Castro::reflux(int crse_level, int fine_level)
 #endif	
 
 #ifdef SELF_GRAVITY
-	if (do_grav && gravity->get_gravity_type() == "PoissonGrav" && gravity->NoSync() == 0)  {
+	if (do_grav_sync) {
 
-	    reg = &getLevel(lev).phi_reg;
-
-	    // Note that the scaling by the area here is corrected for by dividing by the
-	    // cell volume in the reflux. In this way we get a discrete divergence that
-	    // is analogous to the divergence of the flux in the hydrodynamics. See Equation
-	    // 37 in the Castro I paper. The dimensions of dphi are therefore actually
-	    // phi / cm**2, which makes it correct for the RHS of the Poisson equation.
+	    // The registers were filled above.
 
-	    for (int i = 0; i < BL_SPACEDIM; ++i) {
-		reg->CrseInit(*(gravity->get_grad_phi_curr(lev-1)[i]), crse_lev.area[i], i, 0, 0, 1, -1.0);
-		reg->FineAdd(*(gravity->get_grad_phi_curr(lev)[i]), fine_lev.area[i], i, 0, 0, 1, 1.0);
-	    }
+	    reg = &getLevel(lev).phi_reg;
 
 	    reg->Reflux(*dphi[ilev], crse_lev.volume, 1.0, 0, 0, 1, crse_lev.geom);
 
@@ -2452,7 +2557,7 @@ Castro::reflux(int crse_level, int fine_level)
     // Do the sync solve across all levels.
 
 #ifdef SELF_GRAVITY
-    if (do_grav && gravity->get_gravity_type() == "PoissonGrav" && gravity->NoSync() == 0)
+    if (do_grav_sync)
 	gravity->gravity_sync(crse_level, fine_level, amrex::GetVecOfPtrs(drho), amrex::GetVecOfPtrs(dphi));
 #endif
 
@@ -2948,6 +3053,149 @@ Castro::derive (const std::string& name,
     AmrLevel::derive(name,time,mf,dcomp);
 }
 
+void
+Castro::derive_plot_vars (const std::list<std::string>& names,
+                          Real                          time,
+                          MultiFab&                     mf,
+                          int                           dcomp)
+{
+    BL_PROFILE("Castro::derive_plot_vars()");
+
+    // A derive is done in the fused pass if it has the 3D interface,
+    // has one component, and reads only State_Type data on the same
+    // box, possibly grown by a few cells.  Anything else goes through
+    // derive() as before.
+
+    struct FusedDerive {
+        const DeriveRec* rec;
+        int comp;         // component of mf
+        int ng;           // ghost cells of the state it needs
+        int scomp;        // first state component, if the ranges are contiguous
+        bool contiguous;
+    };
+
+    std::vector<FusedDerive> fused;
+    std::vector<std::pair<std::string,int> > others;
+
+    const Box unit(IntVect::TheZeroVector(), IntVect::TheZeroVector());
+    int ng_max = 0;
+    int comp = dcomp;
+
+    for (std::list<std::string>::const_iterator it = names.begin();
+         it != names.end(); ++it, ++comp)
+    {
+        const DeriveRec* rec = derive_lst.get(*it);
+
+        bool fuse = rec->derFunc3D() != nullptr && rec->numDerive() == 1;
+#ifdef PARTICLES
+        if (*it == "particle_count" || *it == "total_particle_count") fuse = false;
+#endif
+
+        int ng = 0;
+        if (fuse) {
+            const Box bx = rec->boxMap()(unit);
+            ng = -bx.smallEnd(0);
+            fuse = ng >= 0 && bx == amrex::grow(unit, ng);
+        }
+
+        int scomp = 0;
+        int next = 0;
+        bool contiguous = true;
+
+        for (int k = 0; fuse && k < rec->numRange(); k++) {
+            int typ, sc, nc;
+            rec->getRange(k, typ, sc, nc);
+            if (typ != State_Type) {
+                fuse = false;
+            } else if (k == 0) {
+                scomp = sc;
+            } else if (sc != next) {
+                contiguous = false;
+            }
+            next = sc + nc;
+        }
+
+        if (fuse) {
+            fused.push_back({rec, comp, ng, scomp, contiguous});
+            ng_max = std::max(ng_max, ng);
+        } else {
+            others.push_back(std::make_pair(*it, comp));
+        }
+    }
+
+    if (fused.size() > 0)
+    {
+        MultiFab S(grids, dmap, NUM_STATE, ng_max);
+        FillPatch(*this, S, ng_max, time, State_Type, 0, NUM_STATE);
+
+        const Real* dx = geom.CellSize();
+        const int* dom_lo = geom.Domain().loVect();
+        const int* dom_hi = geom.Domain().hiVect();
+        const Real dt = parent->dtLevel(level);
+        const int one = 1;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            FArrayBox tmp;
+
+            for (MFIter mfi(mf, hydro_tile_size); mfi.isValid(); ++mfi)
+            {
+                const Box& bx = mfi.tilebox();
+                const RealBox pbx(bx, dx, geom.ProbLo());
+                int grid_no = mfi.index();
+
+                const FArrayBox& Sfab = S[mfi];
+                FArrayBox& der = mf[mfi];
+
+                for (const FusedDerive& d : fused)
+                {
+                    int nstate = d.rec->numState();
+                    const Real* sdat;
+                    const int* slo;
+                    const int* shi;
+
+                    if (d.contiguous) {
+                        sdat = Sfab.dataPtr(d.scomp);
+                        slo = Sfab.loVect();
+                        shi = Sfab.hiVect();
+                    } else {
+                        // gather the ranges into the order the derive expects
+                        const Box gbx = amrex::grow(bx, d.ng);
+                        tmp.resize(gbx, nstate);
+                        int dc = 0;
+                        for (int k = 0; k < d.rec->numRange(); k++) {
+                            int typ, sc, nc;
+                            d.rec->getRange(k, typ, sc, nc);
+                            tmp.copy(Sfab, gbx, sc, gbx, dc, nc);
+                            dc += nc;
+                        }
+                        sdat = tmp.dataPtr();
+                        slo = tmp.loVect();
+                        shi = tmp.hiVect();
+                    }
+
+                    d.rec->derFunc3D()(der.dataPtr(d.comp), ARLIM_3D(der.loVect()), ARLIM_3D(der.hiVect()), &one,
+                                       sdat, ARLIM_3D(slo), ARLIM_3D(shi), &nstate,
+                                       ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+                                       ARLIM_3D(dom_lo), ARLIM_3D(dom_hi),
+                                       ZFILL(dx), ZFILL(pbx.lo()),
+                                       &time, &dt, d.rec->getBC3D(),
+                                       &level, &grid_no);
+                }
+            }
+        }
+    }
+
+    for (std::vector<std::pair<std::string,int> >::const_iterator it = others.begin();
+         it != others.end(); ++it)
+    {
+        auto derive_dat = derive(it->first, time, 0);
+        MultiFab::Copy(mf, *derive_dat, 0, it->second, 1, 0);
+    }
+}
+
 void
 Castro::network_init ()
 {
@@ -3125,91 +3373,82 @@ Castro::make_radial_data(int is_new)
 
    int numpts_1d = get_numpts();
 
-   Vector<Real> radial_vol(numpts_1d,0);
-
    const Real* dx = geom.CellSize();
    Real  dr = dx[0];
 
-   if (is_new == 1) {
-      MultiFab& S = get_new_data(State_Type);
-      const int nc = S.nComp();
-      Vector<Real> radial_state(numpts_1d*nc,0);
-      for (MFIter mfi(S); mfi.isValid(); ++mfi)
-      {
-         Box bx(mfi.validbox());
-         ca_compute_avgstate(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),ZFILL(dx),&dr,&nc,
-			     BL_TO_FORTRAN_3D(     S[mfi]),radial_state.dataPtr(),
-			     BL_TO_FORTRAN_3D(volume[mfi]),radial_vol.dataPtr(),
-			     ZFILL(geom.ProbLo()),&numpts_1d);
-      }
-
-      ParallelDescriptor::ReduceRealSum(radial_vol.dataPtr(),numpts_1d);
-      ParallelDescriptor::ReduceRealSum(radial_state.dataPtr(),numpts_1d*nc);
+   const MultiFab& S = (is_new == 1) ? get_new_data(State_Type) : get_old_data(State_Type);
+   const int nc = S.nComp();
 
-      int first = 0;
-      int np_max = 0;
-      for (int i = 0; i < numpts_1d; i++) {
-         if (radial_vol[i] > 0.)
-         {
-            for (int j = 0; j < nc; j++) {
-              radial_state[nc*i+j] /= radial_vol[i];
-            }
-         } else if (first == 0) {
-            np_max = i;
-            first  = 1;
-         }
-      }
+   // The volume-weighted state and the volume in each radial bin are
+   // accumulated into one buffer, so they can be summed with a single
+   // reduction. Each thread bins its tiles into its own copy, and the
+   // copies are added in thread order so that the sum is reproducible.
 
-      Vector<Real> radial_state_short(np_max*nc,0);
+   Vector<Real> radial_data(numpts_1d*(nc+1),0);
 
-      for (int i = 0; i < np_max; i++) {
-         for (int j = 0; j < nc; j++) {
-           radial_state_short[nc*i+j] = radial_state[nc*i+j];
-         }
-      }
-
-      const Real new_time = state[State_Type].curTime();
-      set_new_outflow_data(radial_state_short.dataPtr(),&new_time,&np_max,&nc);
-   }
-   else
+#ifdef _OPENMP
+   int nthreads = omp_get_max_threads();
+   Vector< Vector<Real> > priv_radial_all(nthreads);
+   for (int i = 0; i < nthreads; i++)
+      priv_radial_all[i].resize(numpts_1d*(nc+1),0);
+#pragma omp parallel
+#endif
    {
-      MultiFab& S = get_old_data(State_Type);
-      const int nc = S.nComp();
-      Vector<Real> radial_state(numpts_1d*nc,0);
-      for (MFIter mfi(S); mfi.isValid(); ++mfi)
+#ifdef _OPENMP
+      Vector<Real>& priv_radial_data = priv_radial_all[omp_get_thread_num()];
+#else
+      Vector<Real>& priv_radial_data = radial_data;
+#endif
+
+      for (MFIter mfi(S,true); mfi.isValid(); ++mfi)
       {
-         Box bx(mfi.validbox());
+         const Box& bx = mfi.tilebox();
          ca_compute_avgstate(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),ZFILL(dx),&dr,&nc,
-			     BL_TO_FORTRAN_3D(     S[mfi]),radial_state.dataPtr(),
-			     BL_TO_FORTRAN_3D(volume[mfi]),radial_vol.dataPtr(),
+			     BL_TO_FORTRAN_3D(     S[mfi]),priv_radial_data.dataPtr(),
+			     BL_TO_FORTRAN_3D(volume[mfi]),priv_radial_data.dataPtr() + numpts_1d*nc,
 			     ZFILL(geom.ProbLo()),&numpts_1d);
       }
 
-      ParallelDescriptor::ReduceRealSum(radial_vol.dataPtr(),numpts_1d);
-      ParallelDescriptor::ReduceRealSum(radial_state.dataPtr(),numpts_1d*nc);
+#ifdef _OPENMP
+#pragma omp barrier
+#pragma omp for
+      for (int i = 0; i < numpts_1d*(nc+1); i++)
+         for (int it = 0; it < nthreads; it++)
+            radial_data[i] += priv_radial_all[it][i];
+#endif
+   }
 
-      int first = 0;
-      int np_max = 0;
-      for (int i = 0; i < numpts_1d; i++) {
-         if (radial_vol[i] > 0.)
-         {
-            for (int j = 0; j < nc; j++) {
-              radial_state[nc*i+j] /= radial_vol[i];
-            }
-         } else if (first == 0) {
-            np_max = i;
-            first  = 1;
-         }
-      }
+   ParallelDescriptor::ReduceRealSum(radial_data.dataPtr(),numpts_1d*(nc+1));
 
-      Vector<Real> radial_state_short(np_max*nc,0);
+   Real* radial_state = radial_data.dataPtr();
+   const Real* radial_vol = radial_data.dataPtr() + numpts_1d*nc;
 
-      for (int i = 0; i < np_max; i++) {
+   int first = 0;
+   int np_max = 0;
+   for (int i = 0; i < numpts_1d; i++) {
+      if (radial_vol[i] > 0.)
+      {
          for (int j = 0; j < nc; j++) {
-           radial_state_short[nc*i+j] = radial_state[nc*i+j];
+           radial_state[nc*i+j] /= radial_vol[i];
          }
+      } else if (first == 0) {
+         np_max = i;
+         first  = 1;
       }
+   }
+
+   Vector<Real> radial_state_short(np_max*nc,0);
+
+   for (int i = 0; i < np_max; i++) {
+      for (int j = 0; j < nc; j++) {
+        radial_state_short[nc*i+j] = radial_state[nc*i+j];
+      }
+   }
 
+   if (is_new == 1) {
+      const Real new_time = state[State_Type].curTime();
+      set_new_outflow_data(radial_state_short.dataPtr(),&new_time,&np_max,&nc);
+   } else {
       const Real old_time = state[State_Type].prevTime();
       set_old_outflow_data(radial_state_short.dataPtr(),&old_time,&np_max,&nc);
    }
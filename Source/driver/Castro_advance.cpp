@@ -1,6 +1,7 @@
 
 #include "Castro.H"
 #include "Castro_F.H"
+#include "AsyncWriter.H"
 
 #ifdef RADIATION
 #include "Radiation.H"
@@ -44,6 +45,11 @@ Castro::advance (Real time,
 
     Real dt_new = dt;
 
+    // Plotfiles and checkpoints queued since the last step are complete
+    // on the Amr side now, so their data can be written.
+    if (level == 0 && AsyncWriter::Active())
+        AsyncWriter::Release();
+
     initialize_advance(time, dt, amr_iteration, amr_ncycle);
 
     // Do the advance.
@@ -87,6 +93,35 @@ Castro::advance (Real time,
         if (ParallelDescriptor::IOProcessor())
 	    std::cout << "\nEnding SDC iteration " << n + 1 << " of " << sdc_iters << ".\n\n";
 
+        // Stop early if the new-time state has stopped changing between iterations.
+
+        if (sdc_tol > 0.0 && n < sdc_iters - 1) {
+
+            MultiFab& S_new = get_new_data(State_Type);
+
+            if (n > 0) {
+
+                Real change = sdc_state_change(S_new, sdc_prev_state);
+
+                if (ParallelDescriptor::IOProcessor())
+                    std::cout << "... relative change in state over SDC iteration " << n + 1 << ": " << change << "\n";
+
+                if (change < sdc_tol) {
+                    if (ParallelDescriptor::IOProcessor())
+                        std::cout << "... SDC converged after " << n + 1 << " iterations.\n\n";
+                    break;
+                }
+
+            }
+
+            // The last iterate that can still be compared before the
+            // final iteration is the one of iteration sdc_iters - 2.
+
+            if (n < sdc_iters - 2)
+                MultiFab::Copy(sdc_prev_state, S_new, 0, 0, NUM_STATE, 0);
+
+        }
+
     }
 
 #else
@@ -156,6 +191,38 @@ Castro::advance (Real time,
     return dt_new;
 }
 
+#ifdef SDC
+Real
+Castro::sdc_state_change (const MultiFab& S_new, const MultiFab& S_prev)
+{
+    // Return the maximum over all state components of the change
+    // between two iterates, relative to the magnitude of the component.
+    // Components that are identically zero are skipped.
+
+    MultiFab& diff = sdc_state_diff;
+
+    MultiFab::Copy(diff, S_new, 0, 0, NUM_STATE, 0);
+    MultiFab::Subtract(diff, S_prev, 0, 0, NUM_STATE, 0);
+
+    Vector<Real> norms(2 * NUM_STATE);
+
+    for (int n = 0; n < NUM_STATE; ++n) {
+        norms[n]             = diff.norm0(n, 0, true);
+        norms[NUM_STATE + n] = S_new.norm0(n, 0, true);
+    }
+
+    ParallelDescriptor::ReduceRealMax(norms.dataPtr(), 2 * NUM_STATE);
+
+    Real change = 0.0;
+
+    for (int n = 0; n < NUM_STATE; ++n)
+        if (norms[NUM_STATE + n] > 0.0)
+            change = std::max(change, norms[n] / norms[NUM_STATE + n]);
+
+    return change;
+}
+#endif
+
 Real
 Castro::do_advance (Real time,
                     Real dt,
@@ -295,6 +362,13 @@ Castro::do_advance (Real time,
 
       do_new_sources(cur_time, dt, amr_iteration, amr_ncycle);
 
+#ifdef DIFFUSION
+      // Implicit thermal diffusion is split from the rest of the update.
+
+      if (diffusion_implicit == 1)
+	implicit_diffusion_level(cur_time, dt);
+#endif
+
 
       // Do the second half of the reactions.
 
@@ -326,6 +400,11 @@ Castro::initialize_do_advance(Real time, Real dt, int amr_iteration, int amr_ncy
 
     int finest_level = parent->finestLevel();
 
+#ifdef DIFFUSION
+    // The transport coefficients are recomputed from the state of this step.
+    clear_transport_coeffs();
+#endif
+
 #ifdef RADIATION
     // make sure these are filled to avoid check/plot file errors:
     if (do_radiation) {
@@ -622,6 +701,23 @@ Castro::initialize_advance(Real time, Real dt, int amr_iteration, int amr_ncycle
 
     sources_for_hydro.define(grids,dmap,NUM_STATE,NUM_GROW);
 
+#ifdef SDC
+    // These are kept for all of the SDC iterations in this advance.
+
+    sdc_source_sum.define(grids, dmap, NUM_STATE, get_new_data(State_Type).nGrow());
+
+    // Two iterates can only be compared before the last iteration if
+    // there are at least three.
+
+    if (sdc_tol > 0.0 && sdc_iters >= 3) {
+        sdc_prev_state.define(grids, dmap, NUM_STATE, 0);
+        sdc_state_diff.define(grids, dmap, NUM_STATE, 0);
+    }
+
+#ifdef REACTIONS
+    sdc_q_old.define(grids, dmap, QVAR, 0);
+#endif
+#endif
 
     if (!do_ctu) {
       // if we are not doing CTU advection, then we are doing a method
@@ -700,6 +796,15 @@ Castro::finalize_advance(Real time, Real dt, int amr_iteration, int amr_ncycle)
 
     sources_for_hydro.clear();
 
+#ifdef SDC
+    sdc_source_sum.clear();
+    sdc_prev_state.clear();
+    sdc_state_diff.clear();
+#ifdef REACTIONS
+    sdc_q_old.clear();
+#endif
+#endif
+
     amrex::FillNull(prev_state);
 
     if (!do_ctu) {
@@ -7,11 +7,14 @@
 #include <iostream>
 #include <string>
 #include <ctime>
+#include <cstdlib>
 
 #include <AMReX_Utility.H>
 #include "Castro.H"
 #include "Castro_F.H"
 #include "Castro_io.H"
+#include "AsyncWriter.H"
+#include "FabCompress.H"
 #include <AMReX_ParmParse.H>
 
 #ifdef RADIATION
@@ -48,11 +51,19 @@ using namespace amrex;
 // 3: A ReactHeader file was generated and the maximum de/dt was stored there
 // 4: Reactions_Type added to checkpoint; ReactHeader functionality deprecated
 // 5: SDC_Source_Type and SDC_React_Type added to checkpoint
+//
+// A checkpoint whose state data are compressed (castro.compress_checkpoint)
+// has a line "Compressed: 1" in the CastroHeader.  One whose state data
+// are written by AsyncWriter (castro.async_io) has a line
+// "Asynchronous: 1", and is only complete once AsyncWriter has put its
+// completion marker in it.
 
 namespace
 {
     int input_version = -1;
     int current_version = 5;
+    int input_compressed = 0;
+    int input_async = 0;
 }
 
 // I/O routines for Castro
@@ -71,16 +82,39 @@ Castro::restart (Amr&     papa,
    	    FullPathCastroHeaderFile += "/CastroHeader";
    	    CastroHeaderFile.open(FullPathCastroHeaderFile.c_str(), std::ios::in);
    	    if (CastroHeaderFile.good()) {
-		char foo[256];
-		// first line: Checkpoint version: ?
-		CastroHeaderFile.getline(foo, 256, ':');  
-		CastroHeaderFile >> input_version;
+		// lines "key: value"; the first one is the checkpoint version
+		std::string line;
+		while (std::getline(CastroHeaderFile, line)) {
+		    const std::size_t colon = line.find(':');
+		    if (colon == std::string::npos)
+			continue;
+		    const std::string key = line.substr(0, colon);
+		    const int value = std::atoi(line.substr(colon+1).c_str());
+		    if (key == "Checkpoint version")
+			input_version = value;
+		    else if (key == "Compressed")
+			input_compressed = value;
+		    else if (key == "Asynchronous")
+			input_async = value;
+		}
    		CastroHeaderFile.close();
+		if (input_version < 0)
+		    input_version = 0;
   	    } else {
    		input_version = 0;
    	    }
+
+	    // the data of an asynchronous checkpoint may not all have been
+	    // written, e.g. if the run stopped while they were
+	    if (input_async) {
+		std::ifstream marker(AsyncWriter::CompleteFile(papa.theRestartFile()).c_str());
+		if (!marker.good())
+		    amrex::Error("Castro::restart: the data of the asynchronous checkpoint " +
+				 papa.theRestartFile() + " were not all written");
+	    }
    	}
   	ParallelDescriptor::Bcast(&input_version, 1, ParallelDescriptor::IOProcessorNumber());
+  	ParallelDescriptor::Bcast(&input_compressed, 1, ParallelDescriptor::IOProcessorNumber());
     }
  
     BL_ASSERT(input_version >= 0);
@@ -89,6 +123,10 @@ Castro::restart (Amr&     papa,
 
     AmrLevel::restart(papa,is,bReadSpecial);
 
+    if (input_compressed) {
+      restartCompressed(papa.theRestartFile(), is);
+    }
+
     if (input_version == 0) { // old checkpoint without PhiGrav_Type
 #ifdef SELF_GRAVITY
       state[PhiGrav_Type].restart(desc_lst[PhiGrav_Type], state[Gravity_Type]);
@@ -441,6 +479,14 @@ Castro::set_state_in_checkpoint (Vector<int>& state_in_checkpoint)
   for (int i=0; i<num_state_type; ++i)
     state_in_checkpoint[i] = 1;
 
+  if (input_compressed) {
+    // The state data come after the AmrLevel part of the Header and
+    // are read by restartCompressed.
+    for (int i=0; i<num_state_type; ++i)
+      state_in_checkpoint[i] = 0;
+    return;
+  }
+
   for (int i=0; i<num_state_type; ++i) {
 #ifdef SELF_GRAVITY
     if (input_version == 0 && i == PhiGrav_Type) {
@@ -479,7 +525,19 @@ Castro::checkPoint(const std::string& dir,
                    VisMF::How     how,
                    bool dump_old_default)
 {
-  AmrLevel::checkPoint(dir, os, how, dump_old);
+  if (AsyncWriter::Active() && level == 0) {
+      // a checkpoint is only complete once the previous ones are
+      AsyncWriter::Wait();
+      AsyncWriter::BeginFile();
+      if (!compress_checkpoint)
+          AsyncWriter::MarkWhenDone(dir);
+  }
+
+  if (AsyncWriter::Active() || compress_checkpoint) {
+      checkPointStates(dir, os, how, dump_old);
+  } else {
+      AmrLevel::checkPoint(dir, os, how, dump_old);
+  }
 
 #ifdef RADIATION
   if (do_radiation) {
@@ -500,6 +558,10 @@ Castro::checkPoint(const std::string& dir,
 	    CastroHeaderFile.open(FullPathCastroHeaderFile.c_str(), std::ios::out);
 
 	    CastroHeaderFile << "Checkpoint version: " << current_version << std::endl;
+	    if (compress_checkpoint)
+		CastroHeaderFile << "Compressed: " << 1 << std::endl;
+	    else if (AsyncWriter::Active())
+		CastroHeaderFile << "Asynchronous: " << 1 << std::endl;
 	    CastroHeaderFile.close();
 	}
 
@@ -549,6 +611,151 @@ Castro::checkPoint(const std::string& dir,
 
 }
 
+// A copy of the data for AsyncWriter, including the ghost cells.
+
+static std::unique_ptr<MultiFab>
+async_io_copy (const MultiFab& mf)
+{
+  std::unique_ptr<MultiFab> copy(new MultiFab(mf.boxArray(), mf.DistributionMap(),
+                                              mf.nComp(), mf.nGrow()));
+  MultiFab::Copy(*copy, mf, 0, 0, mf.nComp(), mf.nGrow());
+  return copy;
+}
+
+// AmrLevel::checkPoint with the state data handed to AsyncWriter or
+// compressed with FabCompress.  The Header entries are those of
+// AmrLevel::checkPoint and StateData::checkPoint; the start and end of
+// each time interval are the same since all our state types are Point
+// types.  In a compressed checkpoint the number of states AmrLevel reads
+// is 0 and the states follow, to be read by restartCompressed.
+
+void
+Castro::checkPointStates(const std::string& dir,
+                         std::ostream&  os,
+                         VisMF::How     how,
+                         bool dump_old_data)
+{
+  const int ndesc = desc_lst.size();
+
+  const std::string LevelDir = amrex::Concatenate("Level_", level, 1);
+
+  std::string FullPath = dir;
+  if (!FullPath.empty() && FullPath[FullPath.size()-1] != '/')
+      FullPath += '/';
+  FullPath += LevelDir;
+
+  if (ParallelDescriptor::IOProcessor())
+      if (!amrex::UtilCreateDirectory(FullPath, 0755))
+          amrex::CreateDirectoryFailed(FullPath);
+
+  ParallelDescriptor::Barrier();
+
+  // compressed data are written right away, into the directory Amr renames
+  const bool async = AsyncWriter::Active() && !compress_checkpoint;
+  const std::string FinalPath = async ? AsyncWriter::FinalDir(dir) + "/" + LevelDir : FullPath;
+
+  if (ParallelDescriptor::IOProcessor())
+  {
+      os << level << '\n' << geom << '\n';
+      grids.writeOn(os);
+      if (compress_checkpoint)
+          os << '\n' << 0;
+      os << '\n' << ndesc << '\n';
+  }
+
+  for (int i = 0; i < ndesc; i++)
+  {
+      BL_ASSERT(desc_lst[i].timeType() == StateDescriptor::Point);
+
+      StateData& sd = state[i];
+      const bool write_data = desc_lst[i].store_in_checkpoint();
+      const bool write_old = write_data && dump_old_data && sd.hasOldData();
+
+      const std::string PathNameInHdr = amrex::Concatenate(LevelDir  + "/SD_", i, 1);
+      const std::string FinalPathName = amrex::Concatenate(FinalPath + "/SD_", i, 1);
+
+      if (ParallelDescriptor::IOProcessor())
+      {
+          os << geom.Domain() << '\n';
+          grids.writeOn(os);
+          os << '\n';
+          os << sd.prevTime() << '\n' << sd.prevTime() << '\n';
+          os << sd.curTime()  << '\n' << sd.curTime()  << '\n';
+          if (write_old) {
+              os << 2 << '\n' << PathNameInHdr << "_New_MF" << '\n'
+                 << PathNameInHdr << "_Old_MF" << '\n';
+          } else if (write_data) {
+              os << 1 << '\n' << PathNameInHdr << "_New_MF" << '\n';
+          } else {
+              os << 0 << '\n';
+          }
+      }
+
+      if (!write_data)
+          continue;
+
+      if (async) {
+          AsyncWriter::Write(async_io_copy(sd.newData()), FinalPathName + "_New_MF", how);
+          if (write_old)
+              AsyncWriter::Write(async_io_copy(sd.oldData()), FinalPathName + "_Old_MF", how);
+      } else {
+          const int ncomp = desc_lst[i].nComp();
+          Vector<int> mode(ncomp, FabCompress::Lossless);
+          Vector<Real> tol(ncomp, 0.0);
+          Vector<std::string> names(ncomp);
+          for (int n = 0; n < ncomp; n++)
+              names[n] = desc_lst[i].name(n);
+
+          FabCompress::Write(sd.newData(), FinalPathName + "_New_MF", mode, tol, names, verbose);
+          if (write_old)
+              FabCompress::Write(sd.oldData(), FinalPathName + "_Old_MF", mode, tol, names, verbose);
+      }
+  }
+}
+
+// Read the state data of a compressed checkpoint, the part of the level
+// Header that follows what AmrLevel::restart read.  This is what
+// StateData::restart does for the other checkpoints.
+
+void
+Castro::restartCompressed(const std::string& chkfile, istream& is)
+{
+  int ndesc;
+  is >> ndesc;
+
+  if (ndesc != desc_lst.size())
+      amrex::Error("Castro::restartCompressed: the checkpoint has the wrong number of state types");
+
+  for (int i = 0; i < ndesc; i++)
+  {
+      Box domain;
+      BoxArray ba;
+      Real old_start, old_stop, new_start, new_stop;
+      int nsets;
+
+      is >> domain;
+      ba.readFrom(is);
+      is >> old_start >> old_stop >> new_start >> new_stop;
+      is >> nsets;
+
+      state[i].define(domain, grids, dmap, desc_lst[i], new_stop, parent->dtLevel(level));
+      state[i].setTimeLevel(new_stop, new_stop - old_stop, 0.0);
+
+      std::string mf_name;
+
+      if (nsets >= 1) {
+          is >> mf_name;
+          FabCompress::Read(state[i].newData(), chkfile + "/" + mf_name);
+      }
+
+      if (nsets == 2) {
+          is >> mf_name;
+          state[i].allocOldData();
+          FabCompress::Read(state[i].oldData(), chkfile + "/" + mf_name);
+      }
+  }
+}
+
 std::string
 Castro::thePlotFileType () const
 {
@@ -876,6 +1083,9 @@ Castro::plotFileOutput(const std::string& dir,
   ParticlePlotFile(dir);
 #endif
 
+    if (AsyncWriter::Active() && level == 0)
+        AsyncWriter::BeginFile();
+
     int i, n;
     //
     // The list of indices of State to write to plotfile.
@@ -1059,7 +1269,9 @@ Castro::plotFileOutput(const std::string& dir,
     // but a derived variable is allowed to have multiple components.
     int       cnt   = 0;
     const int nGrow = 0;
-    MultiFab  plotMF(grids,dmap,n_data_items,nGrow);
+    // With async_io this is also the staging buffer for the writer.
+    std::unique_ptr<MultiFab> plotMF_ptr(new MultiFab(grids,dmap,n_data_items,nGrow));
+    MultiFab& plotMF = *plotMF_ptr;
     MultiFab* this_dat = 0;
     //
     // Cull data from state variables -- use no ghost cells.
@@ -1077,13 +1289,8 @@ Castro::plotFileOutput(const std::string& dir,
     //
     if (derive_names.size() > 0)
     {
-	for (std::list<std::string>::iterator it = derive_names.begin();
-	     it != derive_names.end(); ++it)
-	{
-	    auto derive_dat = derive(*it,cur_time,nGrow);
-	    MultiFab::Copy(plotMF,*derive_dat,0,cnt,1,nGrow);
-	    cnt++;
-	}
+	derive_plot_vars(derive_names,cur_time,plotMF,cnt);
+	cnt += derive_names.size();
     }
 
 #ifdef RADIATION
@@ -1098,5 +1305,37 @@ Castro::plotFileOutput(const std::string& dir,
     //
     std::string TheFullPath = FullPath;
     TheFullPath += BaseName;
-    VisMF::Write(plotMF,TheFullPath,how,true);
+
+    if (compress_plotfile) {
+        // written right away, even with async_io
+        Vector<std::string> names;
+        for (i = 0; i < plot_var_map.size(); i++)
+            names.push_back(desc_lst[plot_var_map[i].first].name(plot_var_map[i].second));
+        for (std::list<std::string>::iterator it = derive_names.begin();
+             it != derive_names.end(); ++it)
+            names.push_back(derive_lst.get(*it)->variableName(0));
+#ifdef RADIATION
+        for (i = 0; i < Radiation::nplotvar; ++i)
+            names.push_back(Radiation::plotvar_names[i]);
+#endif
+
+        Vector<int> mode(n_data_items, compress_plot_rel_tol > 0.0 ? FabCompress::Relative
+                                                                   : FabCompress::Lossless);
+        Vector<Real> tol(n_data_items, compress_plot_rel_tol);
+        for (n = 0; n < n_data_items; n++) {
+            for (int k = 0; k < compress_plot_vars.size(); k++) {
+                if (names[n] == compress_plot_vars[k]) {
+                    mode[n] = compress_plot_modes[k];
+                    tol[n] = compress_plot_tols[k];
+                }
+            }
+        }
+
+        FabCompress::Write(plotMF, TheFullPath, mode, tol, names, verbose);
+    } else if (AsyncWriter::Active()) {
+        std::string TheFinalPath = AsyncWriter::FinalDir(dir) + "/" + Level + BaseName;
+        AsyncWriter::Write(std::move(plotMF_ptr), TheFinalPath, how);
+    } else {
+        VisMF::Write(plotMF,TheFullPath,how,true);
+    }
 }
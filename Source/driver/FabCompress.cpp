@@ -0,0 +1,520 @@
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Utility.H>
+#include <AMReX_VisMF.H>
+
+#include "FabCompress.H"
+
+#include <zlib.h>
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+using namespace amrex;
+
+namespace {
+
+  const std::string header_version("CastroCompressedMultiFab-V2");
+  const std::string fab_tag("CZFAB");
+
+  // Quantized values have to stay well inside the range where
+  // q * step is exact to within a small part of step.
+  const Real max_quantum = 1099511627776.0;  // 2^40
+
+  // Processor p writes its FABs to file p % nfiles, after the data of
+  // the processors before it in that file, as VisMF does with NFiles
+  // files.
+  int num_fab_files()
+  {
+    return std::max(1, std::min(VisMF::GetNOutFiles(), ParallelDescriptor::NProcs()));
+  }
+
+  std::string fab_file_name(const std::string& name, int n)
+  {
+    return amrex::Concatenate(name + "_Z_", n, 5);
+  }
+
+  std::string deflate_bytes(const std::string& in)
+  {
+    uLongf len = compressBound(in.size());
+    std::string out(len, '\0');
+    if (compress2(reinterpret_cast<Bytef*>(&out[0]), &len,
+                  reinterpret_cast<const Bytef*>(in.data()), in.size(),
+                  Z_DEFAULT_COMPRESSION) != Z_OK) {
+      amrex::Abort("FabCompress: zlib compression failed");
+    }
+    out.resize(len);
+    return out;
+  }
+
+  std::string inflate_bytes(const std::string& in, std::size_t raw_size)
+  {
+    std::string out(raw_size, '\0');
+    uLongf len = raw_size;
+    if (uncompress(reinterpret_cast<Bytef*>(&out[0]), &len,
+                   reinterpret_cast<const Bytef*>(in.data()), in.size()) != Z_OK ||
+        len != raw_size) {
+      amrex::Abort("FabCompress: corrupt compressed data");
+    }
+    return out;
+  }
+
+  // byte k of value i goes to k*n + i
+
+  std::string shuffle(const Real* p, long n)
+  {
+    const int nb = sizeof(Real);
+    const char* b = reinterpret_cast<const char*>(p);
+    std::string out(n * nb, '\0');
+    for (long i = 0; i < n; i++)
+      for (int k = 0; k < nb; k++)
+        out[k*n + i] = b[i*nb + k];
+    return out;
+  }
+
+  void unshuffle(const std::string& in, Real* p, long n)
+  {
+    const int nb = sizeof(Real);
+    char* b = reinterpret_cast<char*>(p);
+    for (long i = 0; i < n; i++)
+      for (int k = 0; k < nb; k++)
+        b[i*nb + k] = in[k*n + i];
+  }
+
+  // p[i] = q[i] * step with |p[i] - q[i] * step| <= tol; the q are
+  // stored as zigzag varints of their differences.  False if some
+  // value cannot be quantized.
+
+  bool quantize(const Real* p, long n, Real step, Real tol, std::string& out)
+  {
+    out.clear();
+    out.reserve(n);
+
+    long long prev = 0;
+    for (long i = 0; i < n; i++) {
+      const Real d = p[i] / step;
+      if (!(std::abs(d) < max_quantum)) return false;  // also catches NaN
+      const long long q = std::llround(d);
+      if (std::abs(p[i] - Real(q) * step) > tol) return false;
+
+      const long long dq = q - prev;
+      unsigned long long z = (static_cast<unsigned long long>(dq) << 1) ^
+                             static_cast<unsigned long long>(dq >> 63);
+      while (z >= 0x80) {
+        out.push_back(char((z & 0x7f) | 0x80));
+        z >>= 7;
+      }
+      out.push_back(char(z));
+      prev = q;
+    }
+
+    return true;
+  }
+
+  void dequantize(const std::string& in, Real step, Real* p, long n)
+  {
+    std::size_t pos = 0;
+    long long q = 0;
+    for (long i = 0; i < n; i++) {
+      unsigned long long z = 0;
+      int shift = 0;
+      for (;;) {
+        if (pos >= in.size()) amrex::Abort("FabCompress: truncated data");
+        const unsigned char c = in[pos++];
+        z |= static_cast<unsigned long long>(c & 0x7f) << shift;
+        if (c < 0x80) break;
+        shift += 7;
+      }
+      q += static_cast<long long>(z >> 1) ^ -static_cast<long long>(z & 1);
+      p[i] = Real(q) * step;
+    }
+  }
+
+  // one component of one FAB
+  struct Block {
+    int mode;             // Lossless or Absolute
+    Real step;
+    std::size_t raw_size;
+    std::string data;
+  };
+
+  // abs_tol is the absolute error bound, 0 for lossless
+
+  Block encode(const Real* p, long n, Real abs_tol)
+  {
+    Block b;
+
+    if (abs_tol > 0.0 && n > 0) {
+      // a little under 2 tol, so that rounding cannot push the error past tol
+      const Real step = 2.0 * abs_tol * (1.0 - 1.e-3);
+
+      std::string q;
+      if (quantize(p, n, step, abs_tol, q)) {
+        b.mode = FabCompress::Absolute;
+        b.step = step;
+        b.raw_size = q.size();
+        b.data = deflate_bytes(q);
+        return b;
+      }
+    }
+
+    const std::string s = shuffle(p, n);
+    b.mode = FabCompress::Lossless;
+    b.step = 0.0;
+    b.raw_size = s.size();
+    b.data = deflate_bytes(s);
+    return b;
+  }
+
+  void decode(const Block& b, Real* p, long n)
+  {
+    const std::string raw = inflate_bytes(b.data, b.raw_size);
+    if (b.mode == FabCompress::Lossless) {
+      if (raw.size() != n * sizeof(Real))
+        amrex::Abort("FabCompress: wrong size of lossless data");
+      unshuffle(raw, p, n);
+    } else {
+      dequantize(raw, b.step, p, n);
+    }
+  }
+
+  const char* mode_name(int mode)
+  {
+    if (mode == FabCompress::Absolute) return "abs tol";
+    if (mode == FabCompress::Relative) return "rel tol";
+    return "lossless";
+  }
+
+  // what a reader needs from name_ZH; fab_file are full paths
+  struct Header {
+    int ncomp;
+    int ngrow;
+    BoxArray ba;
+    Vector<std::string> fab_file;
+    Vector<long> offset;
+  };
+
+  void read_header(const std::string& name, Header& h)
+  {
+    const std::string hdr_file = name + "_ZH";
+    std::ifstream hdr(hdr_file.c_str(), std::ios::in);
+    if (!hdr.good()) {
+      amrex::FileOpenFailed(hdr_file);
+    }
+
+    std::string version;
+    hdr >> version;
+    if (version != header_version) {
+      amrex::Abort("FabCompress: " + hdr_file + " is not a compressed MultiFab header");
+    }
+    hdr >> h.ncomp >> h.ngrow;
+    h.ba.readFrom(hdr);
+
+    // the files and offsets of the FABs follow the components
+    for (int n = 0; n < h.ncomp; n++) {
+      std::string var_name;
+      int var_mode;
+      Real var_tol;
+      hdr >> var_name >> var_mode >> var_tol;
+    }
+    int nfabs;
+    hdr >> nfabs;
+    if (hdr.fail() || nfabs != h.ba.size()) {
+      amrex::Abort("FabCompress: corrupt header " + hdr_file);
+    }
+    const std::string dir = VisMF::DirName(name);
+    h.fab_file.resize(nfabs);
+    h.offset.resize(nfabs);
+    for (int i = 0; i < nfabs; i++) {
+      hdr >> h.fab_file[i] >> h.offset[i];
+      h.fab_file[i] = dir + h.fab_file[i];
+    }
+    if (hdr.fail()) {
+      amrex::Abort("FabCompress: corrupt header " + hdr_file);
+    }
+  }
+
+}
+
+void FabCompress::Write(const MultiFab& mf, const std::string& name,
+                        const Vector<int>& mode, const Vector<Real>& tol,
+                        const Vector<std::string>& var_names, int verbose)
+{
+  BL_PROFILE("FabCompress::Write()");
+
+  const int ncomp = mf.nComp();
+  BL_ASSERT(mode.size() == ncomp && tol.size() == ncomp && var_names.size() == ncomp);
+
+  Real strt_time = ParallelDescriptor::second();
+
+  // The FABs of this processor are compressed in parallel.
+  Vector<int> local;
+  for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+    local.push_back(mfi.index());
+  }
+  const int nlocal = local.size();
+
+  // The absolute bound of every component.  A relative bound is taken
+  // relative to the range of the component on the whole MultiFab, so
+  // that every grid is stored to the same accuracy.
+  Vector<Real> abs_tol(ncomp, 0.0);
+  {
+    Vector<Real> vmin(ncomp,  std::numeric_limits<Real>::max());
+    Vector<Real> vmax(ncomp, -std::numeric_limits<Real>::max());
+    for (int k = 0; k < nlocal; k++) {
+      const FArrayBox& fab = mf[local[k]];
+      for (int n = 0; n < ncomp; n++) {
+        if (mode[n] == Relative) {
+          vmin[n] = std::min(vmin[n], fab.min(n));
+          vmax[n] = std::max(vmax[n], fab.max(n));
+        }
+      }
+    }
+    ParallelDescriptor::ReduceRealMin(vmin.dataPtr(), ncomp);
+    ParallelDescriptor::ReduceRealMax(vmax.dataPtr(), ncomp);
+
+    for (int n = 0; n < ncomp; n++) {
+      if (mode[n] == Absolute) {
+        abs_tol[n] = tol[n];
+      } else if (mode[n] == Relative && vmax[n] >= vmin[n]) {
+        abs_tol[n] = tol[n] * (vmax[n] - vmin[n]);
+      }
+    }
+  }
+
+  // uncompressed and compressed bytes of every component
+  Vector<long> bytes(2*ncomp, 0);
+
+  // the compressed FABs of this processor
+  Vector<std::string> fab_data(nlocal);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    Vector<long> my_bytes(2*ncomp, 0);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (int k = 0; k < nlocal; k++) {
+      const int i = local[k];
+      const FArrayBox& fab = mf[i];
+      const long npts = fab.box().numPts();
+
+      std::ostringstream ofs(std::ios::out | std::ios::binary);
+      ofs << fab_tag << ' ' << fab.box() << ' ' << ncomp << ' ' << sizeof(Real) << '\n';
+      ofs << std::setprecision(std::numeric_limits<Real>::max_digits10);
+
+      for (int n = 0; n < ncomp; n++) {
+        const Block b = encode(fab.dataPtr(n), npts, abs_tol[n]);
+        ofs << b.mode << ' ' << b.step << ' ' << b.raw_size << ' ' << b.data.size() << '\n';
+        ofs.write(b.data.data(), b.data.size());
+
+        my_bytes[n] += npts * sizeof(Real);
+        my_bytes[ncomp+n] += b.data.size();
+      }
+
+      fab_data[k] = ofs.str();
+    }
+
+#ifdef _OPENMP
+#pragma omp critical (fab_compress_bytes)
+#endif
+    for (int n = 0; n < 2*ncomp; n++) {
+      bytes[n] += my_bytes[n];
+    }
+  }
+
+  // The FABs of processor p go to name_Z_(p % nfiles) in the order of
+  // their index, after those of the processors p - nfiles, p - 2 nfiles, ...
+  const int nprocs = ParallelDescriptor::NProcs();
+  const int myproc = ParallelDescriptor::MyProc();
+  const int nfiles = num_fab_files();
+
+  Vector<long> offset(mf.size(), 0L);
+  {
+    Vector<long> proc_bytes(nprocs, 0L);
+    for (int k = 0; k < nlocal; k++) {
+      offset[local[k]] = proc_bytes[myproc];
+      proc_bytes[myproc] += fab_data[k].size();
+    }
+
+    ParallelDescriptor::ReduceLongSum(proc_bytes.dataPtr(), nprocs);
+
+    long start = 0;
+    for (int p = myproc % nfiles; p < myproc; p += nfiles) {
+      start += proc_bytes[p];
+    }
+    for (int k = 0; k < nlocal; k++) {
+      offset[local[k]] += start;
+    }
+  }
+
+  if (nlocal > 0) {
+    const std::string file = fab_file_name(name, myproc % nfiles);
+
+    // The other processors of the file write to it at the same time,
+    // each to its own part, so it is created without truncating it.
+    {
+      std::ofstream create(file.c_str(), std::ios::out | std::ios::app | std::ios::binary);
+      if (!create.good()) {
+        amrex::FileOpenFailed(file);
+      }
+    }
+
+    std::fstream ofs(file.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    if (!ofs.good()) {
+      amrex::FileOpenFailed(file);
+    }
+    ofs.seekp(offset[local[0]]);
+    for (int k = 0; k < nlocal; k++) {
+      ofs.write(fab_data[k].data(), fab_data[k].size());
+    }
+    ofs.close();
+    if (ofs.fail()) {
+      amrex::Abort("FabCompress: failed writing " + file);
+    }
+  }
+
+  // The header holds the BoxArray, the settings of every component and
+  // the file and offset of every FAB.
+  ParallelDescriptor::ReduceLongSum(offset.dataPtr(), offset.size(),
+                                    ParallelDescriptor::IOProcessorNumber());
+
+  if (ParallelDescriptor::IOProcessor()) {
+    const std::string file = name + "_ZH";
+    std::ofstream ofs(file.c_str(), std::ios::out | std::ios::trunc);
+    if (!ofs.good()) {
+      amrex::FileOpenFailed(file);
+    }
+    ofs << header_version << '\n' << ncomp << ' ' << mf.nGrow() << '\n';
+    mf.boxArray().writeOn(ofs);
+    ofs << '\n';
+    ofs << std::setprecision(std::numeric_limits<Real>::max_digits10);
+    for (int n = 0; n < ncomp; n++) {
+      ofs << var_names[n] << ' ' << mode[n] << ' ' << tol[n] << '\n';
+    }
+    const std::string base = VisMF::BaseName(name);
+    const DistributionMapping& dm = mf.DistributionMap();
+    ofs << mf.size() << '\n';
+    for (int i = 0; i < mf.size(); i++) {
+      ofs << fab_file_name(base, dm[i] % nfiles) << ' ' << offset[i] << '\n';
+    }
+    ofs.close();
+    if (ofs.fail()) {
+      amrex::Abort("FabCompress: failed writing " + file);
+    }
+  }
+
+  if (verbose) {
+    ParallelDescriptor::ReduceLongSum(bytes.dataPtr(), 2*ncomp, ParallelDescriptor::IOProcessorNumber());
+
+    Real run_time = ParallelDescriptor::second() - strt_time;
+    ParallelDescriptor::ReduceRealMax(run_time, ParallelDescriptor::IOProcessorNumber());
+
+    if (ParallelDescriptor::IOProcessor()) {
+      long raw = 0, compressed = 0;
+      std::cout << "FabCompress: " << name << std::endl;
+      for (int n = 0; n < ncomp; n++) {
+        raw += bytes[n];
+        compressed += bytes[ncomp+n];
+        std::cout << "   " << std::setw(20) << std::left << var_names[n] << std::right
+                  << "  ratio " << std::setw(8) << std::setprecision(3)
+                  << Real(bytes[n]) / std::max(bytes[ncomp+n], 1L)
+                  << "  (" << mode_name(mode[n]);
+        if (mode[n] != Lossless) std::cout << " " << tol[n];
+        std::cout << ")" << std::endl;
+      }
+      std::cout << "   total ratio " << Real(raw) / std::max(compressed, 1L)
+                << ", written in " << run_time << " s" << std::endl;
+    }
+  }
+}
+
+void FabCompress::Read(MultiFab& mf, const std::string& name)
+{
+  BL_PROFILE("FabCompress::Read()");
+
+  Header h;
+  read_header(name, h);
+  const int ncomp = h.ncomp;
+  const BoxArray& ba = h.ba;
+
+  if (mf.empty()) {
+    mf.define(ba, DistributionMapping(ba), ncomp, h.ngrow);
+  } else if (mf.boxArray() != ba || mf.nComp() != ncomp) {
+    amrex::Abort("FabCompress: " + name + " does not match the MultiFab it is read into");
+  }
+
+  Vector<int> local;
+  for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+    local.push_back(mfi.index());
+  }
+  const int nlocal = local.size();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int k = 0; k < nlocal; k++) {
+    const int i = local[k];
+
+    const std::string& file = h.fab_file[i];
+    std::ifstream ifs(file.c_str(), std::ios::in | std::ios::binary);
+    if (!ifs.good()) {
+      amrex::FileOpenFailed(file);
+    }
+    ifs.seekg(h.offset[i]);
+
+    std::string tag;
+    Box bx;
+    int nc, real_size;
+    ifs >> tag >> bx >> nc >> real_size;
+    ifs.ignore(1);
+    if (tag != fab_tag || nc != ncomp || real_size != sizeof(Real)) {
+      amrex::Abort("FabCompress: " + file + " is not a compressed FAB of this precision");
+    }
+
+    // the file holds the FAB with the ghost cells it was written with
+    FArrayBox tmp(bx, ncomp);
+    const long npts = bx.numPts();
+
+    for (int n = 0; n < ncomp; n++) {
+      Block b;
+      std::size_t nbytes;
+      ifs >> b.mode >> b.step >> b.raw_size >> nbytes;
+      ifs.ignore(1);
+      b.data.resize(nbytes);
+      ifs.read(&b.data[0], nbytes);
+      if (ifs.fail()) {
+        amrex::Abort("FabCompress: failed reading " + file);
+      }
+      decode(b, tmp.dataPtr(n), npts);
+    }
+
+    FArrayBox& fab = mf[i];
+    const Box ovlp = fab.box() & bx;
+    fab.copy(tmp, ovlp, 0, ovlp, 0, ncomp);
+  }
+}
+
+Vector<std::string> FabCompress::Files(const std::string& name)
+{
+  Header h;
+  read_header(name, h);
+
+  Vector<std::string> files(h.fab_file);
+  std::sort(files.begin(), files.end());
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+  return files;
+}
+
+bool FabCompress::Exists(const std::string& name)
+{
+  std::ifstream hdr((name + "_ZH").c_str(), std::ios::in);
+  return hdr.good();
+}
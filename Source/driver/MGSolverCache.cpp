@@ -0,0 +1,106 @@
+#include <AMReX_FMultiGrid.H>
+
+#include "MGSolverCache.H"
+
+#include <array>
+
+using namespace amrex;
+
+namespace {
+
+  MLLinOp::BCType bc_type(int mg_bc)
+  {
+    if (mg_bc == MGT_BC_DIR) return MLLinOp::BCType::Dirichlet;
+    if (mg_bc == MGT_BC_NEU) return MLLinOp::BCType::Neumann;
+    return MLLinOp::BCType::Periodic;
+  }
+
+}
+
+MGSolverCache::Entry&
+MGSolverCache::get (int crse_level,
+                    const Vector<Geometry>& geom,
+                    const Vector<BoxArray>& grids,
+                    const Vector<DistributionMapping>& dmap,
+                    const int* mg_bc, int verbose, bool& built)
+{
+    const int nlevs = grids.size();
+
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        bool same = it->crse_level == crse_level && it->grids.size() == nlevs;
+
+        for (int n = 0; n < 2*BL_SPACEDIM && same; ++n)
+            same = it->bc[n] == mg_bc[n];
+
+        for (int ilev = 0; ilev < nlevs && same; ++ilev)
+            same = it->grids[ilev] == grids[ilev] && it->dmap[ilev] == dmap[ilev];
+
+        if (same) {
+            ++num_reuses;
+            built = false;
+            return *it;
+        }
+    }
+
+    entries.emplace_back();
+    Entry& e = entries.back();
+
+    e.crse_level = crse_level;
+    e.grids = grids;
+    e.dmap = dmap;
+    e.bc.assign(mg_bc, mg_bc + 2*BL_SPACEDIM);
+
+    // Castro applies the metric weights of non-Cartesian coordinates
+    // itself (applyMetricTerms), so the operator must not.
+    LPInfo info;
+    info.setMetricTerm(false);
+
+    e.op.reset(new MLABecLaplacian(geom, grids, dmap, info));
+
+    std::array<MLLinOp::BCType,BL_SPACEDIM> lobc, hibc;
+    for (int dir = 0; dir < BL_SPACEDIM; ++dir) {
+        lobc[dir] = bc_type(mg_bc[2*dir + 0]);
+        hibc[dir] = bc_type(mg_bc[2*dir + 1]);
+    }
+    e.op->setDomainBC(lobc, hibc);
+
+    // Start from div(grad phi): alpha = 0, beta = -1, a = 0 and b = 1.
+    e.op->setScalars(0.0, -1.0);
+    for (int ilev = 0; ilev < nlevs; ++ilev)
+    {
+        MultiFab acoef(grids[ilev], dmap[ilev], 1, 0);
+        acoef.setVal(0.0);
+        e.op->setACoeffs(ilev, acoef);
+
+        std::array<MultiFab,BL_SPACEDIM> bcoef;
+        std::array<MultiFab const*,BL_SPACEDIM> bptr;
+        for (int dir = 0; dir < BL_SPACEDIM; ++dir) {
+            bcoef[dir].define(amrex::convert(grids[ilev], IntVect::TheDimensionVector(dir)),
+                              dmap[ilev], 1, 0);
+            bcoef[dir].setVal(1.0);
+            bptr[dir] = &bcoef[dir];
+        }
+        e.op->setBCoeffs(ilev, bptr);
+    }
+
+    e.mlmg.reset(new MLMG(*e.op));
+    e.mlmg->setVerbose(verbose);
+
+    ++num_builds;
+    built = true;
+
+    return e;
+}
+
+void
+MGSolverCache::clear (int lev)
+{
+    for (auto it = entries.begin(); it != entries.end(); )
+    {
+        if (lev >= it->crse_level && lev < it->crse_level + int(it->grids.size()))
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+}
@@ -129,11 +129,11 @@ Castro::construct_new_gravity(int amr_iteration, int amr_ncycle, Real time)
     if (gravity->get_gravity_type() == "PoissonGrav")
     {
 
-	// Use the "old" phi from the current time step as a guess for this solve.
+	// Use the "old" phi from the current time step as a guess for this solve,
+	// or extrapolate in time from it and earlier solutions if
+	// gravity.phi_extrapolation_order > 0.
 
-	MultiFab& phi_old = get_old_data(PhiGrav_Type);
-
-	MultiFab::Copy(phi_new, phi_old, 0, 0, 1, phi_new.nGrow());
+	gravity->make_phi_guess(level, phi_new, time);
 
 	// Subtract off the (composite - level) contribution for the purposes
 	// of the level solve. We'll add it back later.
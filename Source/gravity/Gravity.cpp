@@ -1,5 +1,6 @@
 #include <cmath>
 #include <limits>
+#include <sstream>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -61,6 +62,14 @@ Gravity::Gravity(Amr* Parent, int _finest_level, BCRec* _phys_bc, int _Density)
     abs_tol(MAX_LEV),
     rel_tol(MAX_LEV),
     level_solver_resnorm(MAX_LEV),
+    multipole_table(MAX_LEV),
+    phi_history(MAX_LEV),
+    phi_history_time(MAX_LEV),
+#if (BL_SPACEDIM < 3)
+    metric_cc(MAX_LEV),
+    metric_coeffs(MAX_LEV),
+#endif
+    sync_skip_error(MAX_LEV, 0.0),
     volume(MAX_LEV),
     area(MAX_LEV),
     phys_bc(_phys_bc)
@@ -69,6 +78,26 @@ Gravity::Gravity(Amr* Parent, int _finest_level, BCRec* _phys_bc, int _Density)
      read_params();
      finest_level_allocated = -1;
      if (gravity_type == "PoissonGrav") make_mg_bc();
+#if (BL_SPACEDIM == 3)
+     if (gravity_type == "PoissonGrav" && fft_coarse_solve)
+         for (int n = 0; n < 2*BL_SPACEDIM; ++n)
+             if (mg_bc[n] != MGT_BC_DIR)
+                 amrex::Abort("gravity.fft_coarse_solve requires outflow boundaries on every face");
+     if (gravity_type == "PoissonGrav" && fft_coarse_solve)
+     {
+         // The whole transform is done on one processor; refuse coarse
+         // domains that would not fit there rather than run out of memory.
+         const Box& domain = parent->Geom(0).Domain();
+         Real mb = 0.0;
+         ca_fft_poisson_mb(ARLIM_3D(domain.loVect()), ARLIM_3D(domain.hiVect()), &mb);
+         if (mb > fft_max_mb) {
+             std::ostringstream msg;
+             msg << "gravity.fft_coarse_solve needs " << mb << " MB on one processor for the "
+                 << "coarse domain, more than gravity.fft_max_mb = " << fft_max_mb;
+             amrex::Abort(msg.str());
+         }
+     }
+#endif
 #if (BL_SPACEDIM > 1)
      if (gravity_type == "PoissonGrav") init_multipole_grav();
 #endif
@@ -124,6 +153,19 @@ Gravity::read_params ()
         }
 #endif
 
+#if (BL_SPACEDIM == 3)
+	if (treecode_bcs && treecode_theta <= 0.0)
+	  amrex::Abort("gravity.treecode_theta must be positive");
+#else
+	if (treecode_bcs)
+	  amrex::Abort("gravity.treecode_bcs is only implemented in 3-d");
+	if (fft_coarse_solve)
+	  amrex::Abort("gravity.fft_coarse_solve is only implemented in 3-d");
+#endif
+
+	if (phi_extrapolation_order < 0 || phi_extrapolation_order > 2)
+	  amrex::Abort("gravity.phi_extrapolation_order must be 0, 1, or 2");
+
 	if (pp.contains("get_g_from_phi") && !get_g_from_phi && gravity_type == "PoissonGrav")
 	  if (ParallelDescriptor::IOProcessor())
 	    std::cout << "Warning: gravity_type = PoissonGrav assumes get_g_from_phi is true" << std::endl;
@@ -271,6 +313,24 @@ Gravity::install_level (int                   level,
 
     level_solver_resnorm[level] = 0.0;
 
+    // The grids at this level have changed, so any cached multipole weights are stale.
+
+    multipole_table[level].reset();
+
+    // And so are the multigrid solvers that span it.
+
+    mg_cache.clear(level);
+
+    // Likewise the earlier solutions used to extrapolate the initial guess for phi.
+
+    phi_history[level].clear();
+    phi_history_time[level].clear();
+
+#if (BL_SPACEDIM < 3)
+    metric_cc[level].reset();
+    metric_coeffs[level].clear();
+#endif
+
     if (gravity_type == "PoissonGrav") {
 
        const DistributionMapping& dm = level_data->DistributionMap();
@@ -348,6 +408,80 @@ int Gravity::test_results_of_solves()
   return test_solves;
 }
 
+void
+Gravity::make_phi_guess (int level, MultiFab& phi, Real time)
+{
+    BL_PROFILE("Gravity::make_phi_guess()");
+
+    const MultiFab& phi_old = LevelData[level]->get_old_data(PhiGrav_Type);
+    const Real t_old = LevelData[level]->get_state_data(PhiGrav_Type).prevTime();
+
+    const int ng = phi.nGrow();
+
+    MultiFab::Copy(phi, phi_old, 0, 0, 1, ng);
+
+    if (phi_extrapolation_order == 0) return;
+
+    auto& hist = phi_history[level];
+    auto& hist_time = phi_history_time[level];
+
+    // Lagrange extrapolation in time through phi_old and the earlier solutions
+    // we have kept. The guess may be built more than once from the same phi_old
+    // (e.g. on a retry), so only use entries strictly older than it.
+
+    Vector<const MultiFab*> pts(1, &phi_old);
+    Vector<Real> t(1, t_old);
+
+    const Real eps = 1.e-12 * std::abs(time - t_old);
+
+    for (int i = 0; i < hist.size() && pts.size() <= phi_extrapolation_order; ++i) {
+        if (hist_time[i] < t.back() - eps) {
+            pts.push_back(hist[i].get());
+            t.push_back(hist_time[i]);
+        }
+    }
+
+    if (pts.size() > 1) {
+
+        for (int i = 0; i < pts.size(); ++i) {
+
+            Real w = 1.0;
+            for (int j = 0; j < pts.size(); ++j)
+                if (j != i)
+                    w *= (time - t[j]) / (t[i] - t[j]);
+
+            if (i == 0)
+                phi.mult(w, 0, 1, ng);
+            else
+                MultiFab::Saxpy(phi, w, *pts[i], 0, 0, 1, ng);
+
+        }
+
+    }
+
+    if (verbose && ParallelDescriptor::IOProcessor())
+        std::cout << " ... initial guess for phi at level " << level
+                  << " extrapolated from " << pts.size() << " solution(s)" << std::endl;
+
+    // Save phi_old for the steps to come, the first time we see it.
+
+    if (hist.empty() || hist_time[0] < t_old - eps) {
+
+        hist.insert(hist.begin(), std::unique_ptr<MultiFab>(new MultiFab(phi_old.boxArray(),
+                                                                          phi_old.DistributionMap(),
+                                                                          1, ng)));
+        hist_time.insert(hist_time.begin(), t_old);
+
+        MultiFab::Copy(*hist[0], phi_old, 0, 0, 1, ng);
+
+        const int nkeep = std::min(static_cast<int>(hist.size()), phi_extrapolation_order + 1);
+
+        hist.resize(nkeep);
+        hist_time.resize(nkeep);
+
+    }
+}
+
 Vector<std::unique_ptr<MultiFab> >&
 Gravity::get_grad_phi_prev(int level)
 {
@@ -423,6 +557,15 @@ Gravity::solve_for_phi (int               level,
 
       Vector<MultiFab*> res_null;
 
+      // Keep the initial guess so we can report how far the solve moved from it.
+
+      std::unique_ptr<MultiFab> phi_guess;
+
+      if (verbose && is_new == 1) {
+	  phi_guess.reset(new MultiFab(phi.boxArray(), phi.DistributionMap(), 1, 0));
+	  MultiFab::Copy(*phi_guess, phi, 0, 0, 1, 0);
+      }
+
       level_solver_resnorm[level] = solve_phi_with_fmg(level, level,
 						       phi_p,
 						       amrex::GetVecOfPtrs(rhs),
@@ -430,6 +573,20 @@ Gravity::solve_for_phi (int               level,
 						       res_null,
 						       time);
 
+      if (phi_guess) {
+
+	  MultiFab::Subtract(*phi_guess, phi, 0, 0, 1, 0);
+
+	  const Real guess_err = phi_guess->norm0();
+	  const Real phi_norm = phi.norm0();
+
+	  if (ParallelDescriptor::IOProcessor())
+	      std::cout << " ... level " << level << " initial guess error (relative) = "
+			<< (phi_norm > 0.0 ? guess_err / phi_norm : guess_err)
+			<< ", final resnorm = " << level_solver_resnorm[level] << std::endl;
+
+      }
+
     }
     else {
 
@@ -473,70 +630,126 @@ Gravity::solve_for_delta_phi (int                        crse_level,
       std::cout << "...                    up to fine_level = " << fine_level << std::endl;
     }
 
-    Vector<Geometry> geom(nlevs);
+    // delta_phi is zero on the domain boundary (its ghost cells hold
+    // zero) and at the coarse-fine interface.
 
-    for (int ilev = 0; ilev < nlevs; ++ilev) {
-	int amr_lev = ilev + crse_level;
-	geom[ilev] = parent->Geom(amr_lev);
+    MultiFab crse_zero;
+    if (crse_level > 0) {
+	crse_zero.define(grids[crse_level-1], dmap[crse_level-1], 1, 1);
+	crse_zero.setVal(0.0);
     }
 
-    IntVect crse_ratio = crse_level > 0 ? parent->refRatio(crse_level-1)
-                                        : IntVect::TheZeroVector();
+    MGSolverCache::Entry& mg = get_mg_solver(crse_level, fine_level, delta_phi, rhs,
+					     crse_level > 0 ? &crse_zero : nullptr);
 
-    FMultiGrid fmg(geom, crse_level, crse_ratio);
+    Real rel_eps = 0.0;
+    Real abs_eps = level_solver_resnorm[crse_level];
+    for (int lev = crse_level+1; lev <= fine_level; lev++)
+	abs_eps = std::max(abs_eps,level_solver_resnorm[lev]);
 
-    if (crse_level == 0 && !Geometry::isAllPeriodic()) {
-	fmg.set_bc(mg_bc, *delta_phi[0]);
-    } else {
-	fmg.set_bc(mg_bc);
-    }
+    Vector<const MultiFab*> crhs(rhs.begin(), rhs.end());
 
-    Vector<Vector<std::unique_ptr<MultiFab> > > coeffs(nlevs);
-#if (BL_SPACEDIM < 3)
-    if (Geometry::IsSPHERICAL() || Geometry::IsRZ() )
+    mg.mlmg->setAlwaysUseBNorm(Geometry::isAllPeriodic() ? 0 : 1);
+    mg.mlmg->solve(delta_phi, crhs, rel_eps, abs_eps);
+
+    // This is the gradient itself, so there is nothing to unweight in
+    // non-Cartesian coordinates.
+
+    Vector<std::array<MultiFab*,BL_SPACEDIM> > grad(nlevs);
+    for (int ilev = 0; ilev < nlevs; ++ilev)
+	for (int n = 0; n < BL_SPACEDIM; ++n)
+	    grad[ilev][n] = grad_delta_phi[ilev][n];
+
+    mg.mlmg->getGradSolution(grad);
+}
+
+int
+Gravity::skip_sync (int crse_level,
+		    const Vector<const FluxRegister*>& mass_reg,
+		    const Vector<const FluxRegister*>& phi_reg)
+{
+    if (sync_skip_tol <= 0.0) return 0;
+
+    BL_PROFILE("Gravity::skip_sync()");
+
+    // The RHS of the sync solve, divided by 4 pi G, is a density: the
+    // refluxed density plus the grad phi mismatch, both of which come from
+    // the flux registers of the levels above crse_level (with their
+    // internal borders cleared). The sum of the magnitudes of the register
+    // entries bounds the integral of |RHS| over the coarse level after the
+    // finer levels are averaged down, so compare that with the mass on the
+    // coarse level without building the RHS.
+
+    const MultiFab& S = LevelData[crse_level]->get_new_data(State_Type);
+    const MultiFab& vol = *volume[crse_level];
+
+    Real sync_mass = 0.0;
+    Real mass = 0.0;
+
+    for (int i = 0; i < mass_reg.size(); ++i)
     {
-	for (int ilev = 0; ilev < nlevs; ++ilev) {
-	    int amr_lev = ilev + crse_level;
-	    coeffs[ilev].resize(BL_SPACEDIM);
-	    for (int i = 0; i < BL_SPACEDIM ; i++) {
-		coeffs[ilev][i].reset(new MultiFab(amrex::convert(grids[amr_lev],
-                                                                  IntVect::TheDimensionVector(i)),
-                                                   dmap[amr_lev], 1, 0));
-						   
-		coeffs[ilev][i]->setVal(1.0);
-	    }
+	for (OrientationIter fi; fi; ++fi)
+	{
+	    const FabSet& fm = (*mass_reg[i])[fi()];
+	    const FabSet& fp = (*phi_reg[i])[fi()];
 
-	    applyMetricTerms(amr_lev, *rhs[ilev], amrex::GetVecOfPtrs(coeffs[ilev]));
-	}
+	    FArrayBox r;
+
+	    for (FabSetIter fsi(fm); fsi.isValid(); ++fsi)
+	    {
+		const Box& bx = fm[fsi].box();
 
-	fmg.set_gravity_coeffs(amrex::GetVecOfVecOfPtrs(coeffs));
+		r.resize(bx, 1);
+
+		r.copy(fp[fsi], bx, 0, bx, 0, 1);
+		r.mult(1.0 / Ggravity);
+		r.plus(fm[fsi], bx, Density, 0, 1);
+		r.abs();
+		sync_mass += r.sum(0);
+	    }
+	}
     }
-    else
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:mass)
 #endif
     {
-	fmg.set_const_gravity_coeffs();
+	FArrayBox r;
+
+	for (MFIter mfi(S, true); mfi.isValid(); ++mfi)
+	{
+	    const Box& bx = mfi.tilebox();
+
+	    r.resize(bx, 1);
+
+	    r.copy(S[mfi], bx, Density, bx, 0, 1);
+	    r.mult(vol[mfi], bx, 0, 0, 1);
+	    mass += r.sum(0);
+	}
     }
 
-    Real rel_eps = 0.0;
-    Real abs_eps = level_solver_resnorm[crse_level];
-    for (int lev = crse_level+1; lev <= fine_level; lev++)
-	abs_eps = std::max(abs_eps,level_solver_resnorm[lev]);
+    Real sums[2] = {sync_mass, mass};
 
-    int need_grad_phi = 1;
-    int always_use_bnorm = (Geometry::isAllPeriodic()) ? 0 : 1;
-    fmg.solve(delta_phi, rhs, rel_eps, abs_eps, always_use_bnorm, need_grad_phi);
+    ParallelDescriptor::ReduceRealSum(sums, 2);
 
-    fmg.get_fluxes(grad_delta_phi);
+    const Real change = sums[1] > 0.0 ? sums[0] / sums[1] : 0.0;
+
+    if (sync_skip_error[crse_level] + change < sync_skip_tol) {
+
+	sync_skip_error[crse_level] += change;
+
+	if (ParallelDescriptor::IOProcessor())
+	    std::cout << "Gravity: skipping sync solve at crse_level " << crse_level
+		      << ", relative change = " << change
+		      << ", accumulated = " << sync_skip_error[crse_level] << std::endl;
+
+	return 1;
 
-#if (BL_SPACEDIM < 3)
-    if (Geometry::IsSPHERICAL() || Geometry::IsRZ() ) {
-	for (int ilev = 0; ilev < nlevs; ++ilev)
-	{
-	    int amr_lev = ilev + crse_level;
-	    unweight_edges(amr_lev, grad_delta_phi[ilev]);
-	}
     }
-#endif
+
+    sync_skip_error[crse_level] = 0.0;
+
+    return 0;
 }
 
 void
@@ -545,6 +758,7 @@ Gravity::gravity_sync (int crse_level, int fine_level, const Vector<MultiFab*>&
     BL_PROFILE("Gravity::gravity_sync()");
 
     BL_ASSERT(parent->finestLevel()>crse_level);
+
     if (verbose && ParallelDescriptor::IOProcessor()) {
           std::cout << " ... gravity_sync at crse_level " << crse_level << '\n';
           std::cout << " ...     up to finest_level     " << fine_level << '\n';
@@ -604,7 +818,9 @@ Gravity::gravity_sync (int crse_level, int fine_level, const Vector<MultiFab*>&
          std::cout << " ... Making bc's for delta_phi at crse_level 0"  << std::endl;
 
 #if (BL_SPACEDIM == 3)
-      if ( direct_sum_bcs )
+      if ( fft_coarse_solve )
+          fill_fft_phi(*rhs[0],*delta_phi[crse_level],0);
+      else if ( direct_sum_bcs || treecode_bcs )
           fill_direct_sum_BCs(crse_level,fine_level,amrex::GetVecOfPtrs(rhs),*delta_phi[crse_level]);
       else {
           fill_multipole_BCs(crse_level,fine_level,amrex::GetVecOfPtrs(rhs),*delta_phi[crse_level]);
@@ -1543,44 +1759,31 @@ Gravity::fill_multipole_BCs(int crse_level, int fine_level, const Vector<MultiFa
     const int npts = 1;
 #endif
 
-    // Storage arrays for the multipole moments.
-    // We will initialize them to zero, and then
-    // sum up the results over grids.
-    // Note that since Boxes are defined with
-    // BL_SPACEDIM dimensions, we cannot presently
-    // use this array to fill the interior of the
-    // domain in 2D, since we can only have one
-    // radial index for calculating the multipole moments.
-
-    Box boxq0( IntVect(D_DECL(0, 0, 0)), IntVect(D_DECL(lnum, 0,    npts-1)) );
-    Box boxqC( IntVect(D_DECL(0, 0, 0)), IntVect(D_DECL(lnum, lnum, npts-1)) );
-    Box boxqS( IntVect(D_DECL(0, 0, 0)), IntVect(D_DECL(lnum, lnum, npts-1)) );
+    // We only need the moments for the outermost radial bin, since
+    // we are only constructing boundary conditions. They are stored
+    // in one contiguous buffer, laid out as qL0(0:lnum), qLC(0:lnum,0:lnum),
+    // and qLS(0:lnum,0:lnum), so that a single reduction sums them up
+    // across processors. Note that since we only have one radial bin,
+    // we cannot presently use this to fill the interior of the domain.
 
-    FArrayBox qL0(boxq0);
-    FArrayBox qLC(boxqC);
-    FArrayBox qLS(boxqS);
+    const int nq  = (lnum+1) * (lnum+1);
+    const int nq0 = lnum+1;
+    const int nqCS = (lnum+1) * (lnum+1);
 
-    FArrayBox qU0(boxq0);
-    FArrayBox qUC(boxqC);
-    FArrayBox qUS(boxqS);
+    const int nqtot = nq0 + 2 * nqCS;
 
-    qL0.setVal(0.0);
-    qLC.setVal(0.0);
-    qLS.setVal(0.0);
+    Vector<Real> q(nqtot, 0.0);
 
-    qU0.setVal(0.0);
-    qUC.setVal(0.0);
-    qUS.setVal(0.0);
+    Real* qL0 = q.dataPtr();
+    Real* qLC = q.dataPtr() + nq0;
+    Real* qLS = q.dataPtr() + nq0 + nqCS;
 
-    // This section needs to be generalized for computing
-    // full multipole gravity, not just BCs. At present this
-    // does nothing.
+    // The contribution of each zone to the moments is its density times
+    // a weight that only depends on the geometry (see ca_compute_multipole_table).
+    // With max_multipole_table_mb > 0 we keep these weights around from one
+    // solve to the next, as long as the grids do not change and they fit.
 
-#if (BL_SPACEDIM == 3)
-    int boundary_only = 1;
-#else
-    const int boundary_only = 1;
-#endif
+    Real table_mb = 0.0;
 
     // Use all available data in constructing the boundary conditions,
     // unless the user has indicated that a maximum level at which
@@ -1600,122 +1803,111 @@ Gravity::fill_multipole_BCs(int crse_level, int fine_level, const Vector<MultiFa
 	    MultiFab::Multiply(source, mask, 0, 0, 1, 0);
 	}
 
-        // Loop through the grids and compute the individual contributions
-        // to the various moments. The multipole moment constructor
-        // is coded to only add to the moment arrays, so it is safe
-        // to directly hand the arrays to them.
-
         const Box& domain = parent->Geom(lev).Domain();
 	const Real* dx = parent->Geom(lev).CellSize();
 
+	if (multipole_table[lev] &&
+	    (multipole_table[lev]->nComp() != nq ||
+	     multipole_table[lev]->boxArray() != source.boxArray() ||
+	     multipole_table[lev]->DistributionMap() != source.DistributionMap()))
+	    multipole_table[lev].reset();
+
+	long npts_local = 0;
+	for (MFIter mfi(source); mfi.isValid(); ++mfi)
+	    npts_local += mfi.validbox().numPts();
+
+	const Real mb = Real(npts_local) * nq * sizeof(Real) / (1024.0 * 1024.0);
+
+	if (!multipole_table[lev] && max_multipole_table_mb > 0.0 &&
+	    table_mb + mb <= max_multipole_table_mb) {
+
+	    multipole_table[lev].reset(new MultiFab(source.boxArray(), source.DistributionMap(), nq, 0));
+
 #ifdef _OPENMP
-	int nthreads = omp_get_max_threads();
-	Vector<std::unique_ptr<FArrayBox> > priv_qL0(nthreads);
-	Vector<std::unique_ptr<FArrayBox> > priv_qLC(nthreads);
-	Vector<std::unique_ptr<FArrayBox> > priv_qLS(nthreads);
-	Vector<std::unique_ptr<FArrayBox> > priv_qU0(nthreads);
-	Vector<std::unique_ptr<FArrayBox> > priv_qUC(nthreads);
-	Vector<std::unique_ptr<FArrayBox> > priv_qUS(nthreads);
-	for (int i=0; i<nthreads; i++) {
-	    priv_qL0[i].reset(new FArrayBox(boxq0));
-	    priv_qLC[i].reset(new FArrayBox(boxqC));
-	    priv_qLS[i].reset(new FArrayBox(boxqS));
-	    priv_qU0[i].reset(new FArrayBox(boxq0));
-	    priv_qUC[i].reset(new FArrayBox(boxqC));
-	    priv_qUS[i].reset(new FArrayBox(boxqS));
+#pragma omp parallel
+#endif
+	    for (MFIter mfi(*multipole_table[lev], true); mfi.isValid(); ++mfi)
+	    {
+		const Box& bx = mfi.tilebox();
+
+		ca_compute_multipole_table(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+					   ARLIM_3D(domain.loVect()), ARLIM_3D(domain.hiVect()),
+					   ZFILL(dx),
+					   BL_TO_FORTRAN_3D((*volume[lev])[mfi]),
+					   BL_TO_FORTRAN_3D((*multipole_table[lev])[mfi]), &nq,
+					   &lnum, &npts);
+	    }
+
+	    if (verbose > 1 && ParallelDescriptor::IOProcessor())
+		std::cout << "Gravity: built multipole table at level " << lev << std::endl;
+
 	}
+
+	if (multipole_table[lev])
+	    table_mb += mb;
+
+        // Loop through the grids and compute the individual contributions
+        // to the moments, which are only ever added to. Without a table
+        // the weights are computed tile by tile into scratch space.
+        // The thread sums are added in thread order, so that the moments
+        // do not depend on which thread finishes first.
+
+#ifdef _OPENMP
+	int nthreads = omp_get_max_threads();
+	Vector< Vector<Real> > priv_q_all(nthreads);
+	for (int i=0; i<nthreads; i++)
+	    priv_q_all[i].resize(nqtot, 0.0);
 #pragma omp parallel
 #endif
 	{
 #ifdef _OPENMP
-	    int tid = omp_get_thread_num();
-	    priv_qL0[tid]->setVal(0.0);
-	    priv_qLC[tid]->setVal(0.0);
-	    priv_qLS[tid]->setVal(0.0);
-	    priv_qU0[tid]->setVal(0.0);
-	    priv_qUC[tid]->setVal(0.0);
-	    priv_qUS[tid]->setVal(0.0);
+	    Vector<Real>& priv_q = priv_q_all[omp_get_thread_num()];
+#else
+	    Vector<Real>& priv_q = q;
 #endif
+
+	    FArrayBox tab_scratch;
+
 	    for (MFIter mfi(source,true); mfi.isValid(); ++mfi)
 	    {
 	        const Box& bx = mfi.tilebox();
 
-		ca_compute_multipole_moments(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
-		                             ARLIM_3D(domain.loVect()), ARLIM_3D(domain.hiVect()),
-					     ZFILL(dx),BL_TO_FORTRAN_3D(source[mfi]),
-					     BL_TO_FORTRAN_3D((*volume[lev])[mfi]),
-					     &lnum,
-#ifdef _OPENMP
-					     priv_qL0[tid]->dataPtr(),
-					     priv_qLC[tid]->dataPtr(),priv_qLS[tid]->dataPtr(),
-					     priv_qU0[tid]->dataPtr(),
-					     priv_qUC[tid]->dataPtr(),priv_qUS[tid]->dataPtr(),
-#else
-					     qL0.dataPtr(),qLC.dataPtr(),qLS.dataPtr(),
-					     qU0.dataPtr(),qUC.dataPtr(),qUS.dataPtr(),
-#endif
-					     &npts,&boundary_only);
-	}
+		const FArrayBox* tab;
+
+		if (multipole_table[lev]) {
+
+		    tab = &(*multipole_table[lev])[mfi];
+
+		} else {
+
+		    tab_scratch.resize(bx, nq);
+
+		    ca_compute_multipole_table(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+					       ARLIM_3D(domain.loVect()), ARLIM_3D(domain.hiVect()),
+					       ZFILL(dx),
+					       BL_TO_FORTRAN_3D((*volume[lev])[mfi]),
+					       BL_TO_FORTRAN_3D(tab_scratch), &nq,
+					       &lnum, &npts);
+
+		    tab = &tab_scratch;
 
-#ifdef _OPENMP
-	    int np0 = boxq0.numPts();
-	    int npC = boxqC.numPts();
-	    int npS = boxqS.numPts();
-	    Real* pL0 = qL0.dataPtr();
-	    Real* pLC = qLC.dataPtr();
-	    Real* pLS = qLS.dataPtr();
-	    Real* pU0 = qU0.dataPtr();
-	    Real* pUC = qUC.dataPtr();
-	    Real* pUS = qUS.dataPtr();
-#pragma omp barrier
-#pragma omp for nowait
-	    for (int i=0; i<np0; ++i)
-	    {
-	        for (int it=0; it<nthreads; it++) {
-		    const Real* pp = priv_qL0[it]->dataPtr();
-		    pL0[i] += pp[i];
-		}
-	    }
-#pragma omp for nowait
-	    for (int i=0; i<npC; ++i)
-	    {
-	        for (int it=0; it<nthreads; it++) {
-		    const Real* pp = priv_qLC[it]->dataPtr();
-		    pLC[i] += pp[i];
-		}
-	    }
-#pragma omp for nowait
-	    for (int i=0; i<npS; ++i)
-	    {
-	        for (int it=0; it<nthreads; it++) {
-		    const Real* pp = priv_qLS[it]->dataPtr();
-		    pLS[i] += pp[i];
-		}
-	    }
-#pragma omp for nowait
-	    for (int i=0; i<np0; ++i)
-	    {
-	        for (int it=0; it<nthreads; it++) {
-		  const Real* pp = priv_qU0[it]->dataPtr();
-		  pU0[i] += pp[i];
-		}
-	    }
-#pragma omp for nowait
-	    for (int i=0; i<npC; ++i)
-	    {
-	        for (int it=0; it<nthreads; it++) {
-		  const Real* pp = priv_qUC[it]->dataPtr();
-		  pUC[i] += pp[i];
-		}
-	    }
-#pragma omp for nowait
-	    for (int i=0; i<npS; ++i)
-	    {
-	        for (int it=0; it<nthreads; it++) {
-		    const Real* pp = priv_qUS[it]->dataPtr();
-		    pUS[i] += pp[i];
 		}
+
+		ca_compute_multipole_moments_table(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+						   BL_TO_FORTRAN_3D(source[mfi]),
+						   BL_TO_FORTRAN_3D(*tab), &nq,
+						   &lnum,
+						   priv_q.dataPtr(),
+						   priv_q.dataPtr() + nq0,
+						   priv_q.dataPtr() + nq0 + nqCS);
 	    }
+
+#ifdef _OPENMP
+#pragma omp barrier
+#pragma omp for
+	    for (int i = 0; i < nqtot; ++i)
+		for (int it = 0; it < nthreads; ++it)
+		    q[i] += priv_q_all[it][i];
 #endif
 
 	} // end OpenMP parallel loop
@@ -1724,23 +1916,20 @@ Gravity::fill_multipole_BCs(int crse_level, int fine_level, const Vector<MultiFa
 
     // Now, do a global reduce over all processes.
 
-    ParallelDescriptor::ReduceRealSum(qL0.dataPtr(),boxq0.numPts());
-    ParallelDescriptor::ReduceRealSum(qLC.dataPtr(),boxqC.numPts());
-    ParallelDescriptor::ReduceRealSum(qLS.dataPtr(),boxqS.numPts());
-
-    if (boundary_only != 1) {
-      ParallelDescriptor::ReduceRealSum(qU0.dataPtr(),boxq0.numPts());
-      ParallelDescriptor::ReduceRealSum(qUC.dataPtr(),boxqC.numPts());
-      ParallelDescriptor::ReduceRealSum(qUS.dataPtr(),boxqS.numPts());
-    }
+    ParallelDescriptor::ReduceRealSum(q.dataPtr(), nqtot);
 
     // Finally, construct the boundary conditions using the
     // complete multipole moments, for all points on the
-    // boundary that are held on this process.
+    // boundary that are held on this process. The moments
+    // only have the outermost radial bin, so we pass npts = 1.
+    // The qU arrays are not used when constructing boundary values.
 
     const Box& domain = parent->Geom(crse_level).Domain();
     const Real* dx = parent->Geom(crse_level).CellSize();
 
+    const int npts_bc = 1;
+    const int boundary_only = 1;
+
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -1751,9 +1940,9 @@ Gravity::fill_multipole_BCs(int crse_level, int fine_level, const Vector<MultiFa
 			     ARLIM_3D(domain.loVect()), ARLIM_3D(domain.hiVect()),
 			     ZFILL(dx), BL_TO_FORTRAN_3D(phi[mfi]),
 			     &lnum,
-			     qL0.dataPtr(),qLC.dataPtr(),qLS.dataPtr(),
-			     qU0.dataPtr(),qUC.dataPtr(),qUS.dataPtr(),
-			     &npts,&boundary_only);
+			     qL0,qLC,qLS,
+			     qL0,qLC,qLS,
+			     &npts_bc,&boundary_only);
     }
 
     if (verbose)
@@ -1797,7 +1986,7 @@ Gravity::fill_direct_sum_BCs(int crse_level, int fine_level, const Vector<MultiF
     const int hiVectXZ[3] = {domhi[0]+1, 0         , domhi[2]+1};
 
     const int loVectYZ[3] = {0         , domlo[1]-1, domlo[2]-1};
-    const int hiVectYZ[3] = {0         , domhi[1]+1, domhi[1]+1};
+    const int hiVectYZ[3] = {0         , domhi[1]+1, domhi[2]+1};
 
     const int bclo[3] = {domlo[0]-1, domlo[1]-1, domlo[2]-1};
     const int bchi[3] = {domhi[0]+1, domhi[1]+1, domhi[2]+1};
@@ -1848,6 +2037,9 @@ Gravity::fill_direct_sum_BCs(int crse_level, int fine_level, const Vector<MultiF
 
     int symmetry_type = Symmetry;
 
+    if (treecode_bcs)
+        ca_treecode_reset();
+
     for (int lev = crse_level; lev <= fine_level; ++lev) {
 
 	// Create a local copy of the RHS so that we can mask it.
@@ -1865,6 +2057,27 @@ Gravity::fill_direct_sum_BCs(int crse_level, int fine_level, const Vector<MultiF
 
 	const Real* dx = parent->Geom(lev).CellSize();
 
+	// For the treecode we only gather the zones on this processor
+	// here; the tree is built and evaluated once all levels are in.
+
+	if (treecode_bcs) {
+
+	    for (MFIter mfi(source,true); mfi.isValid(); ++mfi)
+	    {
+		const Box bx = mfi.tilebox();
+
+		const FArrayBox& r = source[mfi];
+		const FArrayBox& v = (*volume[lev])[mfi];
+
+		ca_treecode_add_grid(bx.loVect(), bx.hiVect(), dx,
+				     r.dataPtr(), ARLIM_3D(r.loVect()), ARLIM_3D(r.hiVect()),
+				     v.dataPtr(), ARLIM_3D(v.loVect()), ARLIM_3D(v.hiVect()),
+				     crse_geom.ProbLo());
+	    }
+
+	    continue;
+	}
+
 #ifdef _OPENMP
 	int nthreads = omp_get_max_threads();
 	Vector<std::unique_ptr<FArrayBox> > priv_bcXYLo(nthreads);
@@ -1960,6 +2173,14 @@ Gravity::fill_direct_sum_BCs(int crse_level, int fine_level, const Vector<MultiF
 
     } // end loop over levels
 
+    if (treecode_bcs)
+        ca_treecode_bc(&treecode_theta, &symmetry_type, lo_bc, hi_bc,
+                       crse_geom.ProbLo(), crse_geom.ProbHi(),
+                       bcXYLo.dataPtr(), bcXYHi.dataPtr(),
+                       bcXZLo.dataPtr(), bcXZHi.dataPtr(),
+                       bcYZLo.dataPtr(), bcYZHi.dataPtr(),
+                       bclo, bchi, bcdx);
+
     // because the number of elments in mpi_reduce is int
     BL_ASSERT(nPtsXY <= std::numeric_limits<int>::max());
     BL_ASSERT(nPtsXZ <= std::numeric_limits<int>::max());
@@ -2006,9 +2227,104 @@ Gravity::fill_direct_sum_BCs(int crse_level, int fine_level, const Vector<MultiF
     }
 
 }
+
+void
+Gravity::fill_fft_phi (const MultiFab& Rhs, MultiFab& phi, int fill_interior)
+{
+    BL_PROFILE("Gravity::fill_fft_phi()");
+
+    const Real strt = ParallelDescriptor::second();
+
+    const Geometry& geom = parent->Geom(0);
+    const Box& domain = geom.Domain();
+    const Real* dx = geom.CellSize();
+
+    // The transform is done by the I/O processor alone, threaded with
+    // OpenMP. The coarse RHS is gathered there, and only the potential
+    // that phi needs is sent back: the ghost zones just outside the
+    // domain, plus the interior if fill_interior == 1.
+
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+
+    BoxArray rho_ba(domain);
+    MultiFab rho(rho_ba, DistributionMapping(Vector<int>(1, IOProc)), 1, 0);
+    rho.copy(Rhs, 0, 0, 1);
+
+    const Box gdomain = amrex::grow(domain, 1);
+
+    BoxArray phi_ba = fill_interior ? BoxArray(gdomain)
+                                    : BoxArray(amrex::boxDiff(gdomain, domain));
+    MultiFab phi_fft(phi_ba, DistributionMapping(Vector<int>(phi_ba.size(), IOProc)), 1, 0);
+
+    Real resnorm = 0.0;
+
+    for (MFIter mfi(rho); mfi.isValid(); ++mfi)
+        ca_fft_poisson_solve(ARLIM_3D(domain.loVect()), ARLIM_3D(domain.hiVect()), ZFILL(dx),
+                             BL_TO_FORTRAN_3D(rho[mfi]), &resnorm);
+
+    for (MFIter mfi(phi_fft); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.validbox();
+
+        ca_fft_put_phi(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+                       ARLIM_3D(domain.loVect()), ARLIM_3D(domain.hiVect()),
+                       BL_TO_FORTRAN_3D(phi_fft[mfi]), &fill_interior);
+    }
+
+    phi.copy(phi_fft, 0, 0, 1, 0, phi.nGrow());
+
+    if (verbose)
+    {
+        Real      end    = ParallelDescriptor::second() - strt;
+
+#ifdef BL_LAZY
+	Lazy::QueueReduction( [=] () mutable {
+#endif
+        ParallelDescriptor::ReduceRealMax(end,IOProc);
+        if (ParallelDescriptor::IOProcessor())
+            std::cout << "Gravity::fill_fft_phi() time = " << end
+                      << ", resnorm = " << resnorm << std::endl;
+#ifdef BL_LAZY
+	});
+#endif
+    }
+}
 #endif
 
 #if (BL_SPACEDIM < 3)
+Vector<MultiFab*>
+Gravity::applyMetricTerms(int level, MultiFab& Rhs)
+{
+    BL_ASSERT(Rhs.boxArray() == grids[level]);
+
+    // The metric weights only depend on the grids, so we build them once
+    // (by applying the metric to unit data) and keep them until the next
+    // regrid. The cell-centered weight multiplies the RHS, and the edge
+    // weights are the coefficients for the solver.
+
+    if (!metric_cc[level] ||
+	metric_cc[level]->boxArray() != grids[level] ||
+	metric_cc[level]->DistributionMap() != dmap[level])
+    {
+	metric_cc[level].reset(new MultiFab(grids[level], dmap[level], 1, 0));
+	metric_cc[level]->setVal(1.0);
+
+	metric_coeffs[level].resize(BL_SPACEDIM);
+	for (int i = 0; i < BL_SPACEDIM ; i++) {
+	    metric_coeffs[level][i].reset(new MultiFab(amrex::convert(grids[level],
+								      IntVect::TheDimensionVector(i)),
+						       dmap[level], 1, 0));
+	    metric_coeffs[level][i]->setVal(1.0);
+	}
+
+	applyMetricTerms(level, *metric_cc[level], amrex::GetVecOfPtrs(metric_coeffs[level]));
+    }
+
+    MultiFab::Multiply(Rhs, *metric_cc[level], 0, 0, 1, 0);
+
+    return amrex::GetVecOfPtrs(metric_coeffs[level]);
+}
+
 void
 Gravity::applyMetricTerms(int level, MultiFab& Rhs, const Vector<MultiFab*>& coeffs)
 {
@@ -2055,24 +2371,6 @@ Gravity::unweight_cc(int level, MultiFab& cc)
     }
 }
 
-void
-Gravity::unweight_edges(int level, const Vector<MultiFab*>& edges)
-{
-    const Real* dx = parent->Geom(level).CellSize();
-    const int coord_type = Geometry::Coord();
-#ifdef _OPENMP
-#pragma omp parallel
-#endif
-    for (int idir=0; idir<BL_SPACEDIM; ++idir) {
-	for (MFIter mfi(*edges[idir],true); mfi.isValid(); ++mfi)
-	{
-	    const Box& bx = mfi.tilebox();
-	    ca_unweight_edges(bx.loVect(), bx.hiVect(),
-			      BL_TO_FORTRAN((*edges[idir])[mfi]),
-			      dx,&coord_type,&idir);
-	}
-    }
-}
 #endif
 
 void
@@ -2239,10 +2537,23 @@ Gravity::make_radial_gravity(int level, Real time, Vector<Real>& radial_grav)
         const Real t_new = LevelData[lev]->get_state_data(State_Type).curTime();
         const Real eps   = (t_new - t_old) * 1.e-6;
 
-	const int NUM_STATE = LevelData[lev]->get_new_data(State_Type).nComp();
+	const MultiFab& S_old = LevelData[lev]->get_old_data(State_Type);
+	const MultiFab& S_new = LevelData[lev]->get_new_data(State_Type);
+
+	// The monopole approximation only needs the density, so that is all
+	// we copy, and only if it has to be interpolated in time or masked.
+	// The GR correction also needs the pressure, and so the full state.
+
+#ifdef GR_GRAV
+	const int scomp = 0;
+	const int ncomp = S_new.nComp();
+#else
+	const int scomp = Density;
+	const int ncomp = 1;
+#endif
 
-        // Create MultiFab with NUM_STATE components and no ghost cells
-        MultiFab S(grids[lev],dmap[lev],NUM_STATE,0);
+	const MultiFab* S_src = nullptr;
+	Real alpha = 0.0;
 
 	if ( eps == 0.0 )
 	{
@@ -2250,29 +2561,19 @@ Gravity::make_radial_gravity(int level, Real time, Vector<Real>& radial_grav)
             // dt is smaller than roundoff compared to the current time,
             // in which case we're probably in trouble anyway,
             // but we will still handle it gracefully here.
-            S.copy(LevelData[lev]->get_new_data(State_Type),0,0,NUM_STATE);
+            S_src = &S_new;
 	}
         else if ( std::abs(time-t_old) < eps)
         {
-            S.copy(LevelData[lev]->get_old_data(State_Type),0,0,NUM_STATE);
+            S_src = &S_old;
         }
         else if ( std::abs(time-t_new) < eps)
         {
-            S.copy(LevelData[lev]->get_new_data(State_Type),0,0,NUM_STATE);
+            S_src = &S_new;
         }
         else if (time > t_old && time < t_new)
         {
-            Real alpha   = (time - t_old)/(t_new - t_old);
-            Real omalpha = 1.0 - alpha;
-
-            S.copy(LevelData[lev]->get_old_data(State_Type),0,0,NUM_STATE);
-            S.mult(omalpha);
-
-            MultiFab S_new(grids[lev],dmap[lev],NUM_STATE,0);
-            S_new.copy(LevelData[lev]->get_new_data(State_Type),0,0,NUM_STATE);
-            S_new.mult(alpha);
-
-            S.plus(S_new,0,NUM_STATE,0);
+            alpha = (time - t_old)/(t_new - t_old);
         }
         else
         {
@@ -2281,70 +2582,79 @@ Gravity::make_radial_gravity(int level, Real time, Vector<Real>& radial_grav)
       	    amrex::Abort("Problem in Gravity::make_radial_gravity");
         }
 
-        if (lev < level)
-        {
-	    Castro* fine_level = dynamic_cast<Castro*>(&(parent->getLevel(lev+1)));
-	    const MultiFab& mask = fine_level->build_fine_mask();
-	    for (int n = 0; n < NUM_STATE; ++n)
-		MultiFab::Multiply(S, mask, 0, n, 1, 0);
-        }
+	MultiFab S;
+	const MultiFab* S_ptr = S_src;
+	int rcomp = Density;
 
-        int n1d = radial_mass[lev].size();
+	if (S_src == nullptr || lev < level)
+	{
+	    S.define(grids[lev], dmap[lev], ncomp, 0);
 
-#ifdef GR_GRAV
-        for (int i = 0; i < n1d; i++) radial_pres[lev][i] = 0.;
-#endif
-        for (int i = 0; i < n1d; i++) radial_vol[lev][i] = 0.;
-        for (int i = 0; i < n1d; i++) radial_mass[lev][i] = 0.;
+	    if (S_src != nullptr)
+		MultiFab::Copy(S, *S_src, scomp, 0, ncomp, 0);
+	    else
+		MultiFab::LinComb(S, 1.0 - alpha, S_old, scomp, alpha, S_new, scomp, 0, ncomp, 0);
+
+	    if (lev < level)
+	    {
+		Castro* fine_level = dynamic_cast<Castro*>(&(parent->getLevel(lev+1)));
+		const MultiFab& mask = fine_level->build_fine_mask();
+		for (int n = 0; n < ncomp; ++n)
+		    MultiFab::Multiply(S, mask, 0, n, 1, 0);
+	    }
+
+	    S_ptr = &S;
+	    rcomp = Density - scomp;
+	}
+
+        int n1d = radial_mass[lev].size();
 
         const Geometry& geom = parent->Geom(lev);
         const Real* dx   = geom.CellSize();
         Real dr = dx[0] / double(drdxfac);
 
-#ifdef _OPENMP
-	int nthreads = omp_get_max_threads();
-#ifdef GR_GRAV
-	Vector< Vector<Real> > priv_radial_pres(nthreads);
-#endif
-	Vector< Vector<Real> > priv_radial_mass(nthreads);
-	Vector< Vector<Real> > priv_radial_vol (nthreads);
-	for (int i=0; i<nthreads; i++) {
+	// The mass, volume (and for GR, pressure) profiles are accumulated
+	// into one buffer so that they can be summed with a single reduction.
+	// Each thread bins its tiles into its own copy of the buffer, and the
+	// copies are added in thread order so that the sum is reproducible.
+
 #ifdef GR_GRAV
-	    priv_radial_pres[i].resize(n1d,0.0);
+	const int nprof = 3;
+#else
+	const int nprof = 2;
 #endif
-	    priv_radial_mass[i].resize(n1d,0.0);
-	    priv_radial_vol [i].resize(n1d,0.0);
-	}
+
+	Vector<Real> radial_data(nprof * n1d, 0.0);
+
+#ifdef _OPENMP
+	int nthreads = omp_get_max_threads();
+	Vector< Vector<Real> > priv_radial_all(nthreads);
+	for (int i = 0; i < nthreads; i++)
+	    priv_radial_all[i].resize(nprof * n1d, 0.0);
 #pragma omp parallel
 #endif
 	{
 #ifdef _OPENMP
-	    int tid = omp_get_thread_num();
+	    Vector<Real>& priv_radial_data = priv_radial_all[omp_get_thread_num()];
+#else
+	    Vector<Real>& priv_radial_data = radial_data;
 #endif
-	    for (MFIter mfi(S,true); mfi.isValid(); ++mfi)
+
+	    for (MFIter mfi(*S_ptr,true); mfi.isValid(); ++mfi)
 	    {
 	        const Box& bx = mfi.tilebox();
-		FArrayBox& fab = S[mfi];
+		const FArrayBox& fab = (*S_ptr)[mfi];
 
 		ca_compute_radial_mass(bx.loVect(), bx.hiVect(), dx, &dr,
-				       BL_TO_FORTRAN(fab),
-#ifdef _OPENMP
-				       priv_radial_mass[tid].dataPtr(),
-				       priv_radial_vol[tid].dataPtr(),
-#else
-				       radial_mass[lev].dataPtr(),
-				       radial_vol[lev].dataPtr(),
-#endif
+				       BL_TO_FORTRAN_N(fab, rcomp),
+				       priv_radial_data.dataPtr(),
+				       priv_radial_data.dataPtr() + n1d,
 				       geom.ProbLo(),&n1d,&drdxfac,&lev);
 
 #ifdef GR_GRAV
 		ca_compute_avgpres(bx.loVect(), bx.hiVect(), dx, &dr,
 				   BL_TO_FORTRAN(fab),
-#ifdef _OPENMP
-				   priv_radial_pres[tid].dataPtr(),
-#else
-				   radial_pres[lev].dataPtr(),
-#endif
+				   priv_radial_data.dataPtr() + 2 * n1d,
 				   geom.ProbLo(),&n1d,&drdxfac,&lev);
 #endif
 	    }
@@ -2352,23 +2662,21 @@ Gravity::make_radial_gravity(int level, Real time, Vector<Real>& radial_grav)
 #ifdef _OPENMP
 #pragma omp barrier
 #pragma omp for
-	    for (int i=0; i<n1d; i++) {
-		for (int it=0; it<nthreads; it++) {
-#ifdef GR_GRAV
-	            radial_pres[lev][i] += priv_radial_pres[it][i];
-#endif
-	            radial_mass[lev][i] += priv_radial_mass[it][i];
-		    radial_vol [lev][i] += priv_radial_vol [it][i];
-		}
-	    }
+	    for (int i = 0; i < nprof * n1d; i++)
+		for (int it = 0; it < nthreads; it++)
+		    radial_data[i] += priv_radial_all[it][i];
 #endif
 	}
 
-        ParallelDescriptor::ReduceRealSum(radial_mass[lev].dataPtr() ,n1d);
-        ParallelDescriptor::ReduceRealSum(radial_vol[lev].dataPtr()  ,n1d);
+        ParallelDescriptor::ReduceRealSum(radial_data.dataPtr(), nprof * n1d);
+
+        for (int i = 0; i < n1d; i++) {
+	    radial_mass[lev][i] = radial_data[i];
+	    radial_vol [lev][i] = radial_data[n1d + i];
 #ifdef GR_GRAV
-        ParallelDescriptor::ReduceRealSum(radial_pres[lev].dataPtr()  ,n1d);
+	    radial_pres[lev][i] = radial_data[2 * n1d + i];
 #endif
+	}
 
         if (do_diag > 0)
         {
@@ -2522,7 +2830,16 @@ Gravity::solve_phi_with_fmg (int crse_level, int fine_level,
 	    std::cout << " ... Making bc's for phi at level 0 " << std::endl;
 
 #if (BL_SPACEDIM == 3)
-	if ( direct_sum_bcs ) {
+	if ( fft_coarse_solve ) {
+
+	    // The FFT gives the boundary values and the initial guess on the
+	    // coarse level. It does not satisfy the discrete (seven-point)
+	    // operator exactly, so multigrid still does the solve, which then
+	    // usually takes only one or two V-cycles.
+
+	    fill_fft_phi(*rhs[0], *phi[0], 1);
+
+	} else if ( direct_sum_bcs || treecode_bcs ) {
 	    fill_direct_sum_BCs(crse_level, fine_level, rhs, *phi[0]);
         } else {
 	    fill_multipole_BCs(crse_level, fine_level, rhs, *phi[0]);
@@ -2559,50 +2876,15 @@ Gravity::solve_phi_with_fmg (int crse_level, int fine_level,
         rhs[ilev]->mult(Ggravity);
     }
 
-    Vector<Geometry> geom(nlevs);
-    for (int ilev = 0; ilev < nlevs; ++ilev) {
-	int amr_lev = ilev + crse_level;
-	geom[ilev] = parent->Geom(amr_lev);
-    }
-
-    IntVect crse_ratio = crse_level > 0 ? parent->refRatio(crse_level-1)
-                                        : IntVect::TheZeroVector();
-
-    FMultiGrid fmg(geom, crse_level, crse_ratio);
-
     MultiFab CPhi;  // need to be here so that it is still alive when solve is called.
-    if (crse_level == 0) {
-	fmg.set_bc(mg_bc, *phi[0]);
-    } else {
+    if (crse_level > 0) {
         GetCrsePhi(crse_level, CPhi, time);
-	fmg.set_bc(mg_bc, CPhi, *phi[0]);
     }
 
-    Vector<Vector<std::unique_ptr<MultiFab> > > coeffs(nlevs);
-#if (BL_SPACEDIM < 3)
-    if (Geometry::IsSPHERICAL() || Geometry::IsRZ() )
-    {
-	for (int ilev = 0; ilev < nlevs; ++ilev) {
-	    int amr_lev = ilev + crse_level;
-	    coeffs[ilev].resize(BL_SPACEDIM);
-	    for (int i = 0; i < BL_SPACEDIM ; i++) {
-                coeffs[ilev][i].reset(new MultiFab(amrex::convert(grids[amr_lev],
-                                                                  IntVect::TheDimensionVector(i)),
-                                                   dmap[amr_lev], 1, 0));
-						   
-		coeffs[ilev][i]->setVal(1.0);
-	    }
+    MGSolverCache::Entry& mg = get_mg_solver(crse_level, fine_level, phi, rhs,
+					     crse_level > 0 ? &CPhi : nullptr);
 
-	    applyMetricTerms(amr_lev, *rhs[ilev], amrex::GetVecOfPtrs(coeffs[ilev]));
-	}
-
-	fmg.set_gravity_coeffs(amrex::GetVecOfVecOfPtrs(coeffs));
-    }
-    else
-#endif
-    {
-	fmg.set_const_gravity_coeffs();
-    }
+    Vector<const MultiFab*> crhs(rhs.begin(), rhs.end());
 
     Real final_resnorm = -1.0;
 
@@ -2620,28 +2902,23 @@ Gravity::solve_phi_with_fmg (int crse_level, int fine_level,
 
 	Real abs_eps = abs_tol[fine_level] * max_rhs;
 
-	int need_grad_phi = 1;
-	int always_use_bnorm = (Geometry::isAllPeriodic()) ? 0 : 1;
-	final_resnorm = fmg.solve(phi, rhs, rel_eps, abs_eps,
-				  always_use_bnorm, need_grad_phi);
+	mg.mlmg->setAlwaysUseBNorm(Geometry::isAllPeriodic() ? 0 : 1);
+	final_resnorm = mg.mlmg->solve(phi, crhs, rel_eps, abs_eps);
 
-	fmg.get_fluxes(grad_phi);
+	// This is the gradient itself, so there is nothing to unweight
+	// in non-Cartesian coordinates.
 
-#if (BL_SPACEDIM < 3)
-	if (Geometry::IsSPHERICAL() || Geometry::IsRZ()) {
-	    for (int ilev = 0; ilev < nlevs; ++ilev)
-	    {
-		int amr_lev = ilev + crse_level;
-		//    Need to un-weight the fluxes
-		unweight_edges(amr_lev, grad_phi[ilev]);
-	    }
-	}
-#endif
+	Vector<std::array<MultiFab*,BL_SPACEDIM> > grad(nlevs);
+	for (int ilev = 0; ilev < nlevs; ++ilev)
+	    for (int n = 0; n < BL_SPACEDIM; ++n)
+		grad[ilev][n] = grad_phi[ilev][n];
+
+	mg.mlmg->getGradSolution(grad);
     }
 
     if (res.size() > 0)
     {
-	fmg.compute_residual(phi, rhs, res);
+	mg.mlmg->compResidual(res, phi, crhs);
 
 #if (BL_SPACEDIM < 3)
 	// unweight the residual
@@ -2658,6 +2935,60 @@ Gravity::solve_phi_with_fmg (int crse_level, int fine_level,
     return final_resnorm;
 }
 
+MGSolverCache::Entry&
+Gravity::get_mg_solver (int crse_level, int fine_level,
+			const Vector<MultiFab*>& phi,
+			const Vector<MultiFab*>& rhs,
+			const MultiFab* crse_phi)
+{
+    int nlevs = fine_level - crse_level + 1;
+
+    Vector<Geometry> geom(nlevs);
+    Vector<BoxArray> ba(nlevs);
+    Vector<DistributionMapping> dm(nlevs);
+    for (int ilev = 0; ilev < nlevs; ++ilev) {
+	int amr_lev = ilev + crse_level;
+	geom[ilev] = parent->Geom(amr_lev);
+	ba[ilev] = rhs[ilev]->boxArray();
+	dm[ilev] = rhs[ilev]->DistributionMap();
+    }
+
+    bool built;
+    MGSolverCache::Entry& mg = mg_cache.get(crse_level, geom, ba, dm, mg_bc,
+					    std::max(verbose - 1, 0), built);
+
+    if (verbose > 1 && ParallelDescriptor::IOProcessor())
+	std::cout << "... " << (built ? "built" : "reused")
+		  << " the multigrid solver for levels " << crse_level
+		  << " to " << fine_level << std::endl;
+
+#if (BL_SPACEDIM < 3)
+    // The metric weights of the coefficients only change with the grids,
+    // so they are set when the solver is built.
+    if (Geometry::IsSPHERICAL() || Geometry::IsRZ() )
+    {
+	for (int ilev = 0; ilev < nlevs; ++ilev) {
+	    int amr_lev = ilev + crse_level;
+	    Vector<MultiFab*> coeffs = applyMetricTerms(amr_lev, *rhs[ilev]);
+	    if (built) {
+		std::array<MultiFab const*,BL_SPACEDIM> b;
+		for (int n = 0; n < BL_SPACEDIM; ++n)
+		    b[n] = coeffs[n];
+		mg.op->setBCoeffs(ilev, b);
+	    }
+	}
+    }
+#endif
+
+    if (crse_level > 0)
+	mg.op->setCoarseFineBC(crse_phi, parent->refRatio(crse_level-1)[0]);
+
+    for (int ilev = 0; ilev < nlevs; ++ilev)
+	mg.op->setLevelBC(ilev, phi[ilev]);
+
+    return mg;
+}
+
 Vector<std::unique_ptr<MultiFab> >
 Gravity::get_rhs (int crse_level, int nlevs, int is_new)
 {
@@ -2750,25 +3081,8 @@ Gravity::update_max_rhs()
 #if (BL_SPACEDIM < 3)
     if (Geometry::IsSPHERICAL() || Geometry::IsRZ() )
     {
-	Vector<Vector<std::unique_ptr<MultiFab> > > coeffs(nlevs);
-
-	for (int lev = 0; lev < nlevs; ++lev) {
-
-	    // We need to include this bit about the coefficients because
-	    // it's required by applyMetricTerms.
-
-	    coeffs[lev].resize(BL_SPACEDIM);
-
-	    for (int i = 0; i < BL_SPACEDIM ; i++) {
-		coeffs[lev][i].reset(new MultiFab(amrex::convert(grids[lev],
-                                                                 IntVect::TheDimensionVector(i)),                                   
-                                                  dmap[lev], 1, 0));
-						  
-		coeffs[lev][i]->setVal(1.0);
-	    }
-
-	    applyMetricTerms(lev, *rhs[lev], amrex::GetVecOfPtrs(coeffs[lev]));
-	}
+	for (int lev = 0; lev < nlevs; ++lev)
+	    applyMetricTerms(lev, *rhs[lev]);
     }
 #endif
 
@@ -74,13 +74,12 @@ contains
 
 
   subroutine ca_compute_radial_mass (lo,hi,dx,dr,&
-       state,r_l1,r_l2,r_h1,r_h2, &
+       rho,r_l1,r_l2,r_h1,r_h2, &
        radial_mass,radial_vol,problo, &
        n1d,drdxfac,level) bind(C, name="ca_compute_radial_mass")
     
     use bl_constants_module
     use prob_params_module, only: center
-    use meth_params_module, only: NVAR, URHO
 
     use amrex_fort_module, only : rt => amrex_real
     implicit none
@@ -94,7 +93,7 @@ contains
     real(rt), intent(inout) :: radial_vol (0:n1d-1)
 
     integer , intent(in   ) :: r_l1,r_l2,r_h1,r_h2
-    real(rt), intent(in   ) :: state(r_l1:r_h1,r_l2:r_h2,NVAR)
+    real(rt), intent(in   ) :: rho(r_l1:r_h1,r_l2:r_h2)
 
     integer          :: i,j,index
     integer          :: ii,jj
@@ -150,7 +149,7 @@ contains
                    r = sqrt(xx**2  + yy**2)
                    index = int(r/dr)
                    if (index .le. n1d-1) then
-                      radial_mass(index) = radial_mass(index) + vol_frac*state(i,j,URHO)
+                      radial_mass(index) = radial_mass(index) + vol_frac*rho(i,j)
                       radial_vol (index) = radial_vol (index) + vol_frac
                    end if
                 end do
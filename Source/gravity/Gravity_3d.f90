@@ -49,13 +49,12 @@ contains
 
 
   subroutine ca_compute_radial_mass (lo,hi,dx,dr,&
-       state,r_l1,r_l2,r_l3,r_h1,r_h2,r_h3,&
+       rho,r_l1,r_l2,r_l3,r_h1,r_h2,r_h3,&
        radial_mass,radial_vol,problo,&
        n1d,drdxfac,level) bind(C, name="ca_compute_radial_mass")
 
     use bl_constants_module
     use prob_params_module, only: center
-    use meth_params_module, only: NVAR, URHO
 
     use amrex_fort_module, only : rt => amrex_real
     implicit none
@@ -69,7 +68,7 @@ contains
     real(rt), intent(inout) :: radial_vol (0:n1d-1)
 
     integer , intent(in   ) :: r_l1,r_l2,r_l3,r_h1,r_h2,r_h3
-    real(rt), intent(in   ) :: state(r_l1:r_h1,r_l2:r_h2,r_l3:r_h3,NVAR)
+    real(rt), intent(in   ) :: rho(r_l1:r_h1,r_l2:r_h2,r_l3:r_h3)
 
     integer          :: i,j,k,index
     integer          :: ii,jj,kk
@@ -136,7 +135,7 @@ contains
                          index = int(r*drinv)
 
                          if (index .le. n1d-1) then
-                            radial_mass(index) = radial_mass(index) + vol_frac * state(i,j,k,URHO)
+                            radial_mass(index) = radial_mass(index) + vol_frac * rho(i,j,k)
                             radial_vol (index) = radial_vol (index) + vol_frac
                          end if
                       end do
@@ -447,7 +446,7 @@ contains
                    if (l .eq. bclo(1)) then
                       locb(1) = problo(1)
                    else if (l .eq. bchi(1)) then
-                      locb(1) = probhi(2)
+                      locb(1) = probhi(1)
                    else
                       locb(1) = problo(1) + (dble(l)+HALF) * bcdx(1)
                    endif
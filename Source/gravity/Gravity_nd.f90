@@ -570,12 +570,22 @@ contains
 
 
 
-  subroutine ca_compute_multipole_moments (lo,hi,domlo,domhi, &
-                                           dx,rho,r_lo,r_hi, &
-                                           vol,v_lo,v_hi, &
-                                           lnum,qL0,qLC,qLS,qU0,qUC,qUS, &
-                                           npts,boundary_only) &
-                                           bind(C, name="ca_compute_multipole_moments")
+  subroutine ca_compute_multipole_table (lo,hi,domlo,domhi,dx, &
+                                         vol,v_lo,v_hi, &
+                                         tab,t_lo,t_hi,nq, &
+                                         lnum,npts) &
+                                         bind(C, name="ca_compute_multipole_table")
+
+    ! For the boundary-only multipole moments, each zone contributes
+    ! rho * w to every moment, where the weight w only depends on the
+    ! geometry: the zone volume, its position, the Legendre and
+    ! associated Legendre polynomials, cos(m phi) and sin(m phi), and
+    ! the images behind any symmetric boundaries. Store these weights
+    ! so that the moments reduce to a weighted sum over the density.
+    !
+    ! The nq = (lnum+1)**2 components are ordered as q0(l) for
+    ! l = 0, lnum, followed by the pairs qC(l,m), qS(l,m) for
+    ! l = 1, lnum and m = 1, l.
 
     use prob_params_module, only: problo, center, probhi, dim, coord_type
     use bl_constants_module
@@ -583,42 +593,32 @@ contains
     use amrex_fort_module, only : rt => amrex_real
     implicit none
 
-    integer , intent(in   ) :: lo(3),hi(3)
-    integer , intent(in   ) :: domlo(3),domhi(3)
+    integer , intent(in   ) :: lo(3), hi(3)
+    integer , intent(in   ) :: domlo(3), domhi(3)
     real(rt), intent(in   ) :: dx(3)
-    integer , intent(in   ) :: boundary_only, npts, lnum
-
-    real(rt), intent(inout) :: qL0(0:lnum,0:npts-1), qLC(0:lnum,0:lnum,0:npts-1), qLS(0:lnum,0:lnum,0:npts-1)
-    real(rt), intent(inout) :: qU0(0:lnum,0:npts-1), qUC(0:lnum,0:lnum,0:npts-1), qUS(0:lnum,0:lnum,0:npts-1)
-
-    integer          :: r_lo(3), r_hi(3)
-    integer          :: v_lo(3), v_hi(3)
-    real(rt)         :: rho(r_lo(1):r_hi(1),r_lo(2):r_hi(2),r_lo(3):r_hi(3))
-    real(rt)         :: vol(v_lo(1):v_hi(1),v_lo(2):v_hi(2),v_lo(3):v_hi(3))
+    integer , intent(in   ) :: v_lo(3), v_hi(3)
+    integer , intent(in   ) :: t_lo(3), t_hi(3)
+    integer , intent(in   ) :: nq, lnum, npts
 
-    integer          :: i, j, k
-    integer          :: nlo, index
-
-    real(rt)         :: x, y, z, r, drInv, cosTheta, phiAngle
+    real(rt), intent(in   ) :: vol(v_lo(1):v_hi(1),v_lo(2):v_hi(2),v_lo(3):v_hi(3))
+    real(rt), intent(inout) :: tab(t_lo(1):t_hi(1),t_lo(2):t_hi(2),t_lo(3):t_hi(3),0:nq-1)
 
-    ! If we're using this to construct boundary values, then only fill
-    ! the outermost bin.
+    integer          :: i, j, k, b, c, index
+    real(rt)         :: x, y, z, r, drInv, cosTheta, phiAngle, dV
+    real(rt)         :: loc(3), img(3), w(0:nq-1)
+    real(rt)         :: ones0(0:lnum), onesCS(0:lnum,0:lnum)
+    logical          :: use_lo, use_hi
 
-    if (boundary_only .eq. 1) then
-       nlo = npts-1
-    else
-       nlo = 0
+    if (lnum > lnum_max) then
+       call bl_error("Error: ca_compute_multipole_table: requested more multipole moments than we allocated data for.")
     endif
 
     ! Note that we don't currently support dx != dy != dz, so this is acceptable.
 
     drInv = rmax / dx(1)
 
-    ! Sanity check
-
-    if (lnum > lnum_max) then
-       call bl_error("Error: ca_compute_multipole_moments: requested more multipole moments than we allocated data for.")
-    endif
+    ones0  = ONE
+    onesCS = ONE
 
     do k = lo(3), hi(3)
        z = ( problo(3) + (dble(k)+HALF) * dx(3) - center(3) ) / rmax
@@ -629,6 +629,8 @@ contains
           do i = lo(1), hi(1)
              x = ( problo(1) + (dble(i)+HALF) * dx(1) - center(1) ) / rmax
 
+             w = ZERO
+
              r = sqrt( x**2 + y**2 + z**2 )
 
              if (dim .eq. 3) then
@@ -636,34 +638,134 @@ contains
                 cosTheta = z / r
                 phiAngle = atan2(y, x)
              else if (dim .eq. 2 .and. coord_type .eq. 1) then
-                index = nlo ! We only do the boundary potential in 2D.
+                index = npts-1 ! We only do the boundary potential in 2D.
                 cosTheta = y / r
                 phiAngle = z
              endif
 
-             ! Now, compute the multipole moments.
+             ! Only zones inside the outermost radial bin contribute to
+             ! the moments used for the boundary conditions.
+
+             if (index .gt. npts-1) then
+                tab(i,j,k,:) = ZERO
+                cycle
+             endif
+
+             dV = vol(i,j,k) / rmax**3
+
+             call multipole_weights_add(cosTheta, phiAngle, r, dV, lnum, nq, w, &
+                                        parity_q0, parity_qC_qS)
+
+             ! Images of this zone behind symmetric boundaries: every
+             ! nonempty combination of the symmetric lower faces, and
+             ! likewise for the upper faces.
+
+             if ( doSymmetricAdd .and. dim .eq. 3 ) then
+
+                loc = [x, y, z]
 
-             call multipole_add(cosTheta, phiAngle, r, rho(i,j,k), vol(i,j,k) / rmax**3, &
-                                qL0, qLC, qLS, qU0, qUC, qUS, lnum, npts, nlo, index, .true.)
+                do c = 1, 7
 
-             ! Now add in contributions if we have any symmetric boundaries in 3D.
-             ! The symmetric boundary in 2D axisymmetric is handled separately.
+                   use_lo = .true.
+                   use_hi = .true.
 
-             if ( doSymmetricAdd ) then
+                   do b = 1, 3
+                      if (btest(c, b-1)) then
+                         use_lo = use_lo .and. doSymmetricAddLo(b)
+                         use_hi = use_hi .and. doSymmetricAddHi(b)
+                      endif
+                   enddo
+
+                   if (use_lo) then
+                      img = loc
+                      do b = 1, 3
+                         if (btest(c, b-1)) img(b) = TWO * (problo(b) - center(b)) / rmax - loc(b)
+                      enddo
+                      r = sqrt( img(1)**2 + img(2)**2 + img(3)**2 )
+                      call multipole_weights_add(img(3) / r, atan2(img(2), img(1)), r, dV, lnum, nq, w, &
+                                                 ones0, onesCS)
+                   endif
+
+                   if (use_hi) then
+                      img = loc
+                      do b = 1, 3
+                         if (btest(c, b-1)) img(b) = TWO * (probhi(b) - center(b)) / rmax - loc(b)
+                      enddo
+                      r = sqrt( img(1)**2 + img(2)**2 + img(3)**2 )
+                      call multipole_weights_add(img(3) / r, atan2(img(2), img(1)), r, dV, lnum, nq, w, &
+                                                 ones0, onesCS)
+                   endif
 
-                call multipole_symmetric_add(doSymmetricAddLo, doSymmetricAddHi, &
-                                             x, y, z, problo, probhi, &
-                                             rho(i,j,k), vol(i,j,k) / rmax**3, &
-                                             qL0, qLC, qLS, qU0, qUC, qUS, &
-                                             lnum, npts, nlo, index)
+                enddo
 
              endif
 
+             tab(i,j,k,:) = w
+
+          enddo
+       enddo
+    enddo
+
+  end subroutine ca_compute_multipole_table
+
+
+
+  subroutine ca_compute_multipole_moments_table (lo,hi, &
+                                                 rho,r_lo,r_hi, &
+                                                 tab,t_lo,t_hi,nq, &
+                                                 lnum,q0,qC,qS) &
+                                                 bind(C, name="ca_compute_multipole_moments_table")
+
+    ! Add this box's contribution to the boundary-only multipole
+    ! moments, using the weights from ca_compute_multipole_table.
+
+    use bl_constants_module
+
+    use amrex_fort_module, only : rt => amrex_real
+    implicit none
+
+    integer , intent(in   ) :: lo(3), hi(3)
+    integer , intent(in   ) :: r_lo(3), r_hi(3)
+    integer , intent(in   ) :: t_lo(3), t_hi(3)
+    integer , intent(in   ) :: nq, lnum
+
+    real(rt), intent(in   ) :: rho(r_lo(1):r_hi(1),r_lo(2):r_hi(2),r_lo(3):r_hi(3))
+    real(rt), intent(in   ) :: tab(t_lo(1):t_hi(1),t_lo(2):t_hi(2),t_lo(3):t_hi(3),0:nq-1)
+
+    real(rt), intent(inout) :: q0(0:lnum), qC(0:lnum,0:lnum), qS(0:lnum,0:lnum)
+
+    integer          :: i, j, k, l, m, n
+    real(rt)         :: qsum(0:nq-1)
+
+    ! Each moment is a dot product of the density with one component
+    ! of the table, which is contiguous in memory.
+
+    do n = 0, nq-1
+       qsum(n) = ZERO
+       do k = lo(3), hi(3)
+          do j = lo(2), hi(2)
+             do i = lo(1), hi(1)
+                qsum(n) = qsum(n) + rho(i,j,k) * tab(i,j,k,n)
+             enddo
           enddo
        enddo
     enddo
 
-  end subroutine ca_compute_multipole_moments
+    n = lnum + 1
+
+    do l = 0, lnum
+
+       q0(l) = q0(l) + qsum(l)
+
+       do m = 1, l
+          qC(l,m) = qC(l,m) + qsum(n)
+          qS(l,m) = qS(l,m) + qsum(n+1)
+          n = n + 2
+       enddo
+
+    enddo
+
+  end subroutine ca_compute_multipole_moments_table
 
 
 
@@ -772,187 +874,46 @@ contains
 
 
 
-  subroutine multipole_symmetric_add(doSymmetricAddLo, doSymmetricAddHi, &
-                                     x, y, z, problo, probhi, &
-                                     rho, vol, &
-                                     qU0, qUC, qUS, qL0, qLC, qLS, &
-                                     lnum, npts, nlo, index)
+  subroutine multipole_weights_add(cosTheta, phiAngle, r, vol, lnum, nq, w, p0, pCS)
 
-    use prob_params_module, only: center
-    use bl_constants_module
+    ! The geometric part of the boundary-only multipole moments of a zone,
+    ! accumulated into a packed weight vector (see ca_compute_multipole_table).
 
     use amrex_fort_module, only : rt => amrex_real
     implicit none
 
-    integer,          intent(in) :: lnum, npts, nlo, index
-    real(rt)        , intent(in) :: x, y, z
-    real(rt)        , intent(in) :: problo(3), probhi(3)
-    real(rt)        , intent(in) :: rho, vol
-
-    logical,          intent(in) :: doSymmetricAddLo(3), doSymmetricAddHi(3)
-
-    real(rt)        , intent(inout) :: qL0(0:lnum,0:npts-1)
-    real(rt)        , intent(inout) :: qLC(0:lnum,0:lnum,0:npts-1), qLS(0:lnum,0:lnum,0:npts-1)
-
-    real(rt)        , intent(inout) :: qU0(0:lnum,0:npts-1)
-    real(rt)        , intent(inout) :: qUC(0:lnum,0:lnum,0:npts-1), qUS(0:lnum,0:lnum,0:npts-1)
-
-    real(rt)         :: cosTheta, phiAngle, r
-    real(rt)         :: xLo, yLo, zLo, xHi, yHi, zHi
-
-    xLo = ( TWO * (problo(1) - center(1)) ) / rmax - x
-    xHi = ( TWO * (probhi(1) - center(1)) ) / rmax - x
-
-    yLo = ( TWO * (problo(2) - center(2)) ) / rmax - y
-    yHi = ( TWO * (probhi(2) - center(2)) ) / rmax - y
-
-    zLo = ( TWO * (problo(3) - center(3)) ) / rmax - z
-    zHi = ( TWO * (probhi(3) - center(3)) ) / rmax - z
-
-    if ( doSymmetricAddLo(1) ) then
-
-       r        = sqrt( xLo**2 + y**2 + z**2 )
-       phiAngle = atan2(y, xLo)
-       cosTheta = z / r
-
-       call multipole_add(cosTheta, phiAngle, r, rho, vol, qL0, qLC, qLS, qU0, qUC, qUS, lnum, npts, nlo, index)
-
-       if ( doSymmetricAddLo(2) ) then
-
-          r        = sqrt( xLo**2 + yLo**2 + z**2 )
-          phiAngle = atan2(yLo, xLo)
-          cosTheta = z / r
-
-          call multipole_add(cosTheta, phiAngle, r, rho, vol, qL0, qLC, qLS, qU0, qUC, qUS, lnum, npts, nlo, index)
-
-       endif
-
-       if ( doSymmetricAddLo(3) ) then
-
-          r        = sqrt( xLo**2 + y**2 + zLo**2 )
-          phiAngle = atan2(y, xLo)
-          cosTheta = zLo / r
-
-          call multipole_add(cosTheta, phiAngle, r, rho, vol, qL0, qLC, qLS, qU0, qUC, qUS, lnum, npts, nlo, index)
-
-       endif
-
-       if ( doSymmetricAddLo(2) .and. doSymmetricAddLo(3) ) then
-
-          r        = sqrt( xLo**2 + yLo**2 + zLo**2 )
-          phiAngle = atan2(yLo, xLo)
-          cosTheta = zLo / r
-
-          call multipole_add(cosTheta, phiAngle, r, rho, vol, qL0, qLC, qLS, qU0, qUC, qUS, lnum, npts, nlo, index)
-
-       endif
-
-    endif
-
-    if ( doSymmetricAddLo(2) ) then
-
-       r        = sqrt( x**2 + yLo**2 + z**2 )
-       phiAngle = atan2(yLo, x)
-       cosTheta = z / r
-
-       call multipole_add(cosTheta, phiAngle, r, rho, vol, qL0, qLC, qLS, qU0, qUC, qUS, lnum, npts, nlo, index)
-
-       if ( doSymmetricAddLo(3) ) then
-
-          r        = sqrt( x**2 + yLo**2 + zLo**2 )
-          phiAngle = atan2(yLo, x)
-          cosTheta = zLo / r
-
-          call multipole_add(cosTheta, phiAngle, r, rho, vol, qL0, qLC, qLS, qU0, qUC, qUS, lnum, npts, nlo, index)
-
-       endif
-
-    endif
-
-    if ( doSymmetricAddLo(3) ) then
-
-       r        = sqrt( x**2 + y**2 + zLo**2 )
-       phiAngle = atan2(y, x)
-       cosTheta = zLo / r
-
-       call multipole_add(cosTheta, phiAngle, r, rho, vol, qL0, qLC, qLS, qU0, qUC, qUS, lnum, npts, nlo, index)
-
-    endif
-
-  end subroutine multipole_symmetric_add
-
-
-
-  subroutine multipole_add(cosTheta, phiAngle, r, rho, vol, &
-                           qL0, qLC, qLS, qU0, qUC, qUS, &
-                           lnum, npts, nlo, index, do_parity)
-
-    use bl_constants_module, only: ONE
-
-    use amrex_fort_module, only : rt => amrex_real
-    implicit none
-
-    integer,          intent(in)    :: lnum, npts, nlo, index
-    real(rt)        , intent(in)    :: cosTheta, phiAngle, r, rho, vol
-
-    real(rt)        , intent(inout) :: qL0(0:lnum,0:npts-1), qLC(0:lnum,0:lnum,0:npts-1), qLS(0:lnum,0:lnum,0:npts-1)
-    real(rt)        , intent(inout) :: qU0(0:lnum,0:npts-1), qUC(0:lnum,0:lnum,0:npts-1), qUS(0:lnum,0:lnum,0:npts-1)
-
-    logical, optional, intent(in)   :: do_parity
+    integer,          intent(in)    :: lnum, nq
+    real(rt)        , intent(in)    :: cosTheta, phiAngle, r, vol
+    real(rt)        , intent(in)    :: p0(0:lnum), pCS(0:lnum,0:lnum)
+    real(rt)        , intent(inout) :: w(0:nq-1)
 
     integer :: l, m, n
 
     real(rt)         :: legPolyArr(0:lnum), assocLegPolyArr(0:lnum,0:lnum)
 
-    real(rt)         :: rho_r_L, rho_r_U
-
-    real(rt)         :: p0(0:lnum), pCS(0:lnum,0:lnum)
+    real(rt)         :: r_L
 
     call fill_legendre_arrays(legPolyArr, assocLegPolyArr, cosTheta, lnum)
 
-    ! Absorb factorial terms into associated Legendre polynomials
-
-    assocLegPolyArr = assocLegPolyArr * factArray
-
-    p0 = ONE
-    pCS = ONE
-
-    if (present(do_parity)) then
-       if (do_parity) then
-          p0 = parity_q0
-          pCS = parity_qC_qS
-       endif
-    endif
-
-    do n = nlo, npts-1
+    n = lnum + 1
 
-       do l = 0, lnum
+    do l = 0, lnum
 
-          rho_r_L = rho * (r ** dble( l  ))
-          rho_r_U = rho * (r ** dble(-l-1))
+       r_L = r ** dble(l)
 
-          if (index .le. n) then
-             qL0(l,n) = qL0(l,n) + legPolyArr(l) * rho_r_L * vol * volumeFactor * p0(l)
-          else
-             qU0(l,n) = qU0(l,n) + legPolyArr(l) * rho_r_U * vol * volumeFactor * p0(l)
-          endif
+       w(l) = w(l) + legPolyArr(l) * r_L * vol * volumeFactor * p0(l)
 
-          do m = 1, l
+       do m = 1, l
 
-             if (index .le. n) then
-                qLC(l,m,n) = qLC(l,m,n) + assocLegPolyArr(l,m) * cos(m * phiAngle) * rho_r_L * vol * pCS(l,m)
-                qLS(l,m,n) = qLS(l,m,n) + assocLegPolyArr(l,m) * sin(m * phiAngle) * rho_r_L * vol * pCS(l,m)
-             else
-                qUC(l,m,n) = qUC(l,m,n) + assocLegPolyArr(l,m) * cos(m * phiAngle) * rho_r_U * vol * pCS(l,m)
-                qUS(l,m,n) = qUS(l,m,n) + assocLegPolyArr(l,m) * sin(m * phiAngle) * rho_r_U * vol * pCS(l,m)
-             endif
+          w(n  ) = w(n  ) + factArray(l,m) * assocLegPolyArr(l,m) * cos(m * phiAngle) * r_L * vol * pCS(l,m)
+          w(n+1) = w(n+1) + factArray(l,m) * assocLegPolyArr(l,m) * sin(m * phiAngle) * r_L * vol * pCS(l,m)
 
-          enddo
+          n = n + 2
 
        enddo
 
     enddo
 
-  end subroutine multipole_add
+  end subroutine multipole_weights_add
 
 end module gravity_module
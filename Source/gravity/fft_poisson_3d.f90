@@ -0,0 +1,708 @@
+module fft_poisson_module
+
+  ! An FFT solver for the Poisson equation with isolated boundary
+  ! conditions on the coarse level (Hockney's method). The density
+  ! is zero-padded to at least twice the domain in every direction, so
+  ! that the circular convolution with the free-space Green's function
+  ! -G / r, done with FFTs, is exactly the sum over the zones of the
+  ! domain. The potential is kept at the zone centers of the domain and
+  ! of one layer of ghost zones around it.
+  !
+  ! One processor (the caller gathers the density there) does the
+  ! whole transform of the coarse domain, threaded over lines of the
+  ! transform, so this is meant for coarse grids whose transform fits
+  ! in the memory of a node.
+
+  use amrex_fort_module, only : rt => amrex_real
+
+  implicit none
+
+  private
+
+  ! Largest radix used by the FFT.
+
+  integer, parameter :: max_radix = 5
+
+  ! Mixed radix FFT of length n; w(j) = exp(-2 pi i j / n).
+
+  type fft_plan
+     integer :: n = 0
+     integer :: nf = 0
+     integer :: f(64)
+     complex(rt), allocatable :: w(:)
+  end type fft_plan
+
+  type(fft_plan), save :: plan(3)
+
+  ! Number of zones in the domain, length of the padded transform and the
+  ! zone size that the transformed Green's function was computed for.
+
+  integer,  save :: n(3) = 0, m(3) = 0
+  real(rt), save :: dx_g(3) = 0.0e0_rt
+
+  ! Transform of the Green's function on the non-redundant half of the
+  ! spectrum in x, including the normalization of the inverse transform.
+  ! It is real because the Green's function is real and even.
+
+  real(rt), allocatable, save :: ghat(:,:,:)
+
+  ! Potential at the zone centers, indexed from -1 to n(:) relative to
+  ! the low corner of the domain.
+
+  real(rt), allocatable, save :: phi_fft(:,:,:)
+
+  public :: ca_fft_poisson_solve, ca_fft_put_phi, ca_fft_poisson_mb
+
+contains
+
+  subroutine ca_fft_poisson_solve(domlo, domhi, dx, &
+                                  rho, r_lo, r_hi, &
+                                  resnorm) bind(C, name="ca_fft_poisson_solve")
+
+    ! Compute the potential of the density on the whole coarse domain,
+    ! which has been gathered into rho on this processor. resnorm is the
+    ! max norm of the residual of the standard seven-point Laplacian
+    ! applied to the result.
+
+    use fundamental_constants_module, only: Gconst
+    use bl_constants_module, only: ZERO, TWO, M_PI
+
+    implicit none
+
+    integer , intent(in   ) :: domlo(3), domhi(3)
+    integer , intent(in   ) :: r_lo(3), r_hi(3)
+    real(rt), intent(in   ) :: dx(3)
+    real(rt), intent(in   ) :: rho(r_lo(1):r_hi(1),r_lo(2):r_hi(2),r_lo(3):r_hi(3))
+    real(rt), intent(inout) :: resnorm
+
+    complex(rt), allocatable :: c(:,:,:)
+
+    integer  :: i, j, k
+    real(rt) :: lap
+
+    if (any(domhi - domlo + 1 /= n) .or. any(dx /= dx_g)) then
+       call fft_poisson_init(domhi - domlo + 1, dx)
+    endif
+
+    allocate(c(0:m(1)/2,0:m(2)-1,0:m(3)-1))
+
+    call forward_transform(c, .false., rho)
+
+    !$omp parallel do private(i, j, k) collapse(2)
+    do k = 0, m(3)-1
+       do j = 0, m(2)-1
+          do i = 0, m(1)/2
+             c(i,j,k) = c(i,j,k) * ghat(i,j,k)
+          enddo
+       enddo
+    enddo
+    !$omp end parallel do
+
+    call inverse_transform(c)
+
+    deallocate(c)
+
+    resnorm = ZERO
+
+    !$omp parallel do private(i, j, k, lap) reduction(max:resnorm) collapse(2)
+    do k = 0, n(3)-1
+       do j = 0, n(2)-1
+          do i = 0, n(1)-1
+
+             lap = (phi_fft(i+1,j,k) - TWO * phi_fft(i,j,k) + phi_fft(i-1,j,k)) / dx(1)**2 + &
+                   (phi_fft(i,j+1,k) - TWO * phi_fft(i,j,k) + phi_fft(i,j-1,k)) / dx(2)**2 + &
+                   (phi_fft(i,j,k+1) - TWO * phi_fft(i,j,k) + phi_fft(i,j,k-1)) / dx(3)**2
+
+             resnorm = max(resnorm, abs(lap - 4.0e0_rt * M_PI * Gconst * &
+                                        rho(domlo(1)+i,domlo(2)+j,domlo(3)+k)))
+
+          enddo
+       enddo
+    enddo
+    !$omp end parallel do
+
+  end subroutine ca_fft_poisson_solve
+
+
+
+  subroutine ca_fft_poisson_mb(domlo, domhi, mb) bind(C, name="ca_fft_poisson_mb")
+
+    ! The memory (in MB) that the processor doing the transform needs for
+    ! a domain of domlo:domhi: the gathered density, the transformed
+    ! Green's function, the complex work array of the padded transform
+    ! and the potential, in this module and in the caller's copy.
+
+    implicit none
+
+    integer , intent(in   ) :: domlo(3), domhi(3)
+    real(rt), intent(inout) :: mb
+
+    integer  :: d, nz(3), mz(3)
+    real(rt) :: nhalf
+
+    do d = 1, 3
+       nz(d) = domhi(d) - domlo(d) + 1
+       mz(d) = good_size(2 * nz(d))
+    enddo
+
+    nhalf = real(mz(1)/2 + 1, rt) * real(mz(2), rt) * real(mz(3), rt)
+
+    mb = (3.0e0_rt * nhalf + &
+          real(nz(1), rt) * real(nz(2), rt) * real(nz(3), rt) + &
+          2.0e0_rt * real(nz(1)+2, rt) * real(nz(2)+2, rt) * real(nz(3)+2, rt)) * &
+          storage_size(mb) / 8 / 1024.0e0_rt**2
+
+  end subroutine ca_fft_poisson_mb
+
+
+
+  subroutine ca_fft_put_phi(lo, hi, domlo, domhi, &
+                            phi, p_lo, p_hi, &
+                            fill_interior) bind(C, name="ca_fft_put_phi")
+
+    ! Copy the potential into the zones of lo:hi. Ghost zones outside the
+    ! domain get the potential on the domain boundary, as the multigrid
+    ! solver expects for Dirichlet conditions; zones inside the domain are
+    ! only filled if fill_interior == 1.
+
+    use bl_constants_module, only: ZERO
+
+    implicit none
+
+    integer , intent(in   ) :: lo(3), hi(3)
+    integer , intent(in   ) :: domlo(3), domhi(3)
+    integer , intent(in   ) :: p_lo(3), p_hi(3)
+    real(rt), intent(inout) :: phi(p_lo(1):p_hi(1),p_lo(2):p_hi(2),p_lo(3):p_hi(3))
+    integer , intent(in   ) :: fill_interior
+
+    integer  :: i, j, k, ii, jj, kk, ilo, ihi, jlo, jhi, klo, khi
+    real(rt) :: p
+
+    do k = max(lo(3), domlo(3)-1), min(hi(3), domhi(3)+1)
+       call face_range(k - domlo(3), n(3), klo, khi)
+
+       do j = max(lo(2), domlo(2)-1), min(hi(2), domhi(2)+1)
+          call face_range(j - domlo(2), n(2), jlo, jhi)
+
+          do i = max(lo(1), domlo(1)-1), min(hi(1), domhi(1)+1)
+             call face_range(i - domlo(1), n(1), ilo, ihi)
+
+             if (ilo == ihi .and. jlo == jhi .and. klo == khi) then
+
+                if (fill_interior == 1) then
+                   phi(i,j,k) = phi_fft(ilo,jlo,klo)
+                endif
+
+             else
+
+                ! Average the zones on either side of the boundary.
+
+                p = ZERO
+                do kk = klo, khi
+                   do jj = jlo, jhi
+                      do ii = ilo, ihi
+                         p = p + phi_fft(ii,jj,kk)
+                      enddo
+                   enddo
+                enddo
+
+                phi(i,j,k) = p / ((ihi - ilo + 1) * (jhi - jlo + 1) * (khi - klo + 1))
+
+             endif
+
+          enddo
+       enddo
+    enddo
+
+  end subroutine ca_fft_put_phi
+
+
+
+  subroutine face_range(i, nz, ilo, ihi)
+
+    ! The zones (relative to the domain) whose potential makes up the value
+    ! in zone i: i itself inside the domain, or the zones on either side of
+    ! the domain face for a ghost zone.
+
+    implicit none
+
+    integer, intent(in ) :: i, nz
+    integer, intent(out) :: ilo, ihi
+
+    if (i < 0) then
+       ilo = -1
+       ihi = 0
+    else if (i > nz-1) then
+       ilo = nz-1
+       ihi = nz
+    else
+       ilo = i
+       ihi = i
+    endif
+
+  end subroutine face_range
+
+
+
+  subroutine fft_poisson_init(nz, dx)
+
+    ! Choose the padded transform size and compute the transform of the
+    ! Green's function for a domain of nz zones of size dx.
+
+    implicit none
+
+    integer,  intent(in) :: nz(3)
+    real(rt), intent(in) :: dx(3)
+
+    complex(rt), allocatable :: c(:,:,:)
+
+    integer :: d
+
+    n = nz
+    dx_g = dx
+
+    ! The outputs span offsets of -n to n from the zones with mass, so a
+    ! transform of length 2n does not alias: offsets n and -n pick up the
+    ! same value of the (even) Green's function.
+
+    do d = 1, 3
+       m(d) = good_size(2 * n(d))
+       call make_plan(plan(d), m(d))
+    enddo
+
+    if (allocated(ghat)) deallocate(ghat)
+    if (allocated(phi_fft)) deallocate(phi_fft)
+
+    allocate(ghat(0:m(1)/2,0:m(2)-1,0:m(3)-1))
+    allocate(phi_fft(-1:n(1),-1:n(2),-1:n(3)))
+
+    allocate(c(0:m(1)/2,0:m(2)-1,0:m(3)-1))
+
+    call forward_transform(c, .true.)
+
+    ghat = real(c, rt) / (dble(m(1)) * dble(m(2)) * dble(m(3)))
+
+    deallocate(c)
+
+  end subroutine fft_poisson_init
+
+
+
+  function green(i, j, k) result(g)
+
+    ! The Green's function for a zone offset by (i, j, k) zones, at the
+    ! index (i, j, k) of the padded, periodic transform. The self term is
+    ! the exact integral of 1/r over the zone.
+
+    use fundamental_constants_module, only: Gconst
+    use bl_constants_module, only: HALF
+
+    implicit none
+
+    integer, intent(in) :: i, j, k
+    real(rt) :: g
+
+    real(rt) :: x, y, z
+
+    x = min(i, m(1)-i) * dx_g(1)
+    y = min(j, m(2)-j) * dx_g(2)
+    z = min(k, m(3)-k) * dx_g(3)
+
+    if (i == 0 .and. j == 0 .and. k == 0) then
+       g = -Gconst * 8.0e0_rt * inv_r_integral(HALF * dx_g(1), HALF * dx_g(2), HALF * dx_g(3))
+    else
+       g = -Gconst * dx_g(1) * dx_g(2) * dx_g(3) / sqrt(x**2 + y**2 + z**2)
+    endif
+
+  end function green
+
+
+
+  function inv_r_integral(a, b, c) result(f)
+
+    ! The integral of 1/r over the box [0,a] x [0,b] x [0,c].
+
+    use bl_constants_module, only: HALF
+
+    implicit none
+
+    real(rt), intent(in) :: a, b, c
+    real(rt) :: f
+
+    real(rt) :: r
+
+    r = sqrt(a**2 + b**2 + c**2)
+
+    f = a * b * log(c + r) + b * c * log(a + r) + c * a * log(b + r) &
+         - HALF * a**2 * atan(b * c / (a * r)) &
+         - HALF * b**2 * atan(c * a / (b * r)) &
+         - HALF * c**2 * atan(a * b / (c * r)) &
+         - a * b * log(sqrt(a**2 + b**2)) - b * c * log(sqrt(b**2 + c**2)) - c * a * log(sqrt(c**2 + a**2))
+
+    ! The last line is the antiderivative evaluated on the faces through
+    ! the origin; it vanishes at the origin and on the axes.
+
+  end function inv_r_integral
+
+
+
+  subroutine forward_transform(c, kernel, rho)
+
+    ! Transform either the zero-padded density (rho is on the domain) or,
+    ! if kernel is true, the Green's function. The first (x) transform
+    ! handles two real lines at once as the real and imaginary parts of
+    ! one complex line.
+
+    use bl_constants_module, only: HALF
+
+    implicit none
+
+    complex(rt), intent(inout) :: c(0:m(1)/2,0:m(2)-1,0:m(3)-1)
+    logical,     intent(in   ) :: kernel
+    real(rt),    intent(in   ), optional :: rho(0:n(1)-1,0:n(2)-1,0:n(3)-1)
+
+    complex(rt), allocatable :: a(:), b(:)
+
+    integer :: i, j, k, l, nl, l1, l2, j1, k1, j2, k2, ny, nz, h
+
+    h = m(1)/2
+
+    if (kernel) then
+       ny = m(2)
+       nz = m(3)
+    else
+       ny = n(2)
+       nz = n(3)
+    endif
+
+    nl = ny * nz
+
+    !$omp parallel private(a, b, i, j, k, l, l1, l2, j1, k1, j2, k2)
+
+    allocate(a(0:maxval(m)-1), b(0:maxval(m)-1))
+
+    ! x: lines l1 and l2 of the (y,z) planes that hold data.
+
+    !$omp do
+    do l = 0, (nl+1)/2 - 1
+
+       l1 = 2*l
+       l2 = 2*l + 1
+
+       j1 = mod(l1, ny)
+       k1 = l1 / ny
+       j2 = mod(l2, ny)
+       k2 = l2 / ny
+
+       a(0:m(1)-1) = (0.0e0_rt, 0.0e0_rt)
+
+       if (kernel) then
+          do i = 0, m(1)-1
+             a(i) = green(i, j1, k1)
+             if (l2 < nl) a(i) = a(i) + (0.0e0_rt, 1.0e0_rt) * green(i, j2, k2)
+          enddo
+       else
+          do i = 0, n(1)-1
+             a(i) = rho(i, j1, k1)
+             if (l2 < nl) a(i) = a(i) + (0.0e0_rt, 1.0e0_rt) * rho(i, j2, k2)
+          enddo
+       endif
+
+       call fft(plan(1), a, b, .false.)
+
+       ! Separate the transforms of the two real lines.
+
+       do i = 0, h
+          c(i,j1,k1) = HALF * (b(i) + conjg(b(mod(m(1)-i, m(1)))))
+          if (l2 < nl) then
+             c(i,j2,k2) = (0.0e0_rt, -0.5e0_rt) * (b(i) - conjg(b(mod(m(1)-i, m(1)))))
+          endif
+       enddo
+
+    enddo
+    !$omp end do
+
+    ! The padding in y is zero.
+
+    if (.not. kernel) then
+       !$omp do collapse(2)
+       do k = 0, nz-1
+          do j = ny, m(2)-1
+             c(:,j,k) = (0.0e0_rt, 0.0e0_rt)
+          enddo
+       enddo
+       !$omp end do
+    endif
+
+    ! y
+
+    !$omp do collapse(2)
+    do k = 0, nz-1
+       do i = 0, h
+          a(0:m(2)-1) = c(i,:,k)
+          call fft(plan(2), a, b, .false.)
+          c(i,:,k) = b(0:m(2)-1)
+       enddo
+    enddo
+    !$omp end do
+
+    ! z, with the padding in z being zero.
+
+    !$omp do collapse(2)
+    do j = 0, m(2)-1
+       do i = 0, h
+          a(0:m(3)-1) = (0.0e0_rt, 0.0e0_rt)
+          a(0:nz-1) = c(i,j,0:nz-1)
+          call fft(plan(3), a, b, .false.)
+          c(i,j,:) = b(0:m(3)-1)
+       enddo
+    enddo
+    !$omp end do
+
+    deallocate(a, b)
+
+    !$omp end parallel
+
+  end subroutine forward_transform
+
+
+
+  subroutine inverse_transform(c)
+
+    ! Transform back and store the potential in phi_fft. Only the lines that
+    ! reach the zones of phi_fft are transformed in y and x.
+
+    implicit none
+
+    complex(rt), intent(inout) :: c(0:m(1)/2,0:m(2)-1,0:m(3)-1)
+
+    complex(rt), allocatable :: a(:), b(:)
+
+    integer :: i, j, k, l, nl, l1, l2, j1, k1, j2, k2, h
+
+    h = m(1)/2
+
+    nl = (n(2) + 2) * (n(3) + 2)
+
+    !$omp parallel private(a, b, i, j, k, l, l1, l2, j1, k1, j2, k2)
+
+    allocate(a(0:maxval(m)-1), b(0:maxval(m)-1))
+
+    ! z
+
+    !$omp do collapse(2)
+    do j = 0, m(2)-1
+       do i = 0, h
+          a(0:m(3)-1) = c(i,j,:)
+          call fft(plan(3), a, b, .true.)
+          do k = -1, n(3)
+             c(i,j,modulo(k, m(3))) = b(modulo(k, m(3)))
+          enddo
+       enddo
+    enddo
+    !$omp end do
+
+    ! y
+
+    !$omp do collapse(2)
+    do k = -1, n(3)
+       do i = 0, h
+          a(0:m(2)-1) = c(i,:,modulo(k, m(3)))
+          call fft(plan(2), a, b, .true.)
+          do j = -1, n(2)
+             c(i,modulo(j, m(2)),modulo(k, m(3))) = b(modulo(j, m(2)))
+          enddo
+       enddo
+    enddo
+    !$omp end do
+
+    ! x, two real lines at once: the full spectrum of each line follows
+    ! from the half we keep by conjugate symmetry.
+
+    !$omp do
+    do l = 0, (nl+1)/2 - 1
+
+       l1 = 2*l
+       l2 = 2*l + 1
+
+       j1 = mod(l1, n(2)+2) - 1
+       k1 = l1 / (n(2)+2) - 1
+       j2 = mod(l2, n(2)+2) - 1
+       k2 = l2 / (n(2)+2) - 1
+
+       do i = 0, h
+          a(i) = c(i,modulo(j1, m(2)),modulo(k1, m(3)))
+          if (l2 < nl) a(i) = a(i) + (0.0e0_rt, 1.0e0_rt) * c(i,modulo(j2, m(2)),modulo(k2, m(3)))
+       enddo
+
+       do i = h+1, m(1)-1
+          a(i) = conjg(c(m(1)-i,modulo(j1, m(2)),modulo(k1, m(3))))
+          if (l2 < nl) a(i) = a(i) + (0.0e0_rt, 1.0e0_rt) * conjg(c(m(1)-i,modulo(j2, m(2)),modulo(k2, m(3))))
+       enddo
+
+       call fft(plan(1), a, b, .true.)
+
+       do i = -1, n(1)
+          phi_fft(i,j1,k1) = real(b(modulo(i, m(1))), rt)
+          if (l2 < nl) phi_fft(i,j2,k2) = aimag(b(modulo(i, m(1))))
+       enddo
+
+    enddo
+    !$omp end do
+
+    deallocate(a, b)
+
+    !$omp end parallel
+
+  end subroutine inverse_transform
+
+
+
+  function good_size(nmin) result(nn)
+
+    ! The smallest length >= nmin with no prime factors other than 2, 3 and 5.
+
+    implicit none
+
+    integer, intent(in) :: nmin
+    integer :: nn, r
+
+    nn = nmin
+
+    do
+       r = nn
+       do while (mod(r, 2) == 0)
+          r = r / 2
+       enddo
+       do while (mod(r, 3) == 0)
+          r = r / 3
+       enddo
+       do while (mod(r, 5) == 0)
+          r = r / 5
+       enddo
+       if (r == 1) exit
+       nn = nn + 1
+    enddo
+
+  end function good_size
+
+
+
+  subroutine make_plan(p, nn)
+
+    use bl_constants_module, only: M_PI
+
+    implicit none
+
+    type(fft_plan), intent(inout) :: p
+    integer,        intent(in   ) :: nn
+
+    integer :: j, r
+
+    p % n = nn
+    p % nf = 0
+
+    r = nn
+    do while (r > 1)
+       p % nf = p % nf + 1
+       if (mod(r, 4) == 0) then
+          p % f(p % nf) = 4
+       else if (mod(r, 2) == 0) then
+          p % f(p % nf) = 2
+       else if (mod(r, 3) == 0) then
+          p % f(p % nf) = 3
+       else
+          p % f(p % nf) = 5
+       endif
+       r = r / p % f(p % nf)
+    enddo
+
+    if (allocated(p % w)) deallocate(p % w)
+    allocate(p % w(0:nn-1))
+
+    do j = 0, nn-1
+       p % w(j) = cmplx(cos(2.0e0_rt * M_PI * j / nn), -sin(2.0e0_rt * M_PI * j / nn), rt)
+    enddo
+
+  end subroutine make_plan
+
+
+
+  subroutine fft(p, x, y, inverse)
+
+    ! y = the unnormalized discrete Fourier transform of x (of length p % n),
+    ! or its inverse.
+
+    implicit none
+
+    type(fft_plan), intent(in   ) :: p
+    complex(rt),    intent(in   ) :: x(0:)
+    complex(rt),    intent(inout) :: y(0:)
+    logical,        intent(in   ) :: inverse
+
+    if (p % n == 1) then
+       y(0) = x(0)
+    else
+       call fft_step(p, inverse, p % n, 1, x, 0, 1, y, 0)
+    endif
+
+  end subroutine fft
+
+
+
+  recursive subroutine fft_step(p, inverse, len, lev, x, xoff, xstride, y, yoff)
+
+    ! Decimation in time: the transform of length len = r * len / r of
+    ! x(xoff::xstride) is built from the r transforms of length len / r of
+    ! its subsequences, which are stored one after another in y.
+
+    implicit none
+
+    type(fft_plan), intent(in   ) :: p
+    logical,        intent(in   ) :: inverse
+    integer,        intent(in   ) :: len, lev, xoff, xstride, yoff
+    complex(rt),    intent(in   ) :: x(0:)
+    complex(rt),    intent(inout) :: y(0:)
+
+    complex(rt) :: t(0:max_radix-1), s, w
+    integer     :: r, ml, q, k, o
+
+    r = p % f(lev)
+    ml = len / r
+
+    if (ml > 1) then
+       do q = 0, r-1
+          call fft_step(p, inverse, ml, lev+1, x, xoff + q*xstride, xstride*r, y, yoff + q*ml)
+       enddo
+    endif
+
+    do k = 0, ml-1
+
+       if (ml > 1) then
+          t(0) = y(yoff + k)
+          do q = 1, r-1
+             w = p % w(mod(q * k * (p % n / len), p % n))
+             if (inverse) w = conjg(w)
+             t(q) = w * y(yoff + q*ml + k)
+          enddo
+       else
+          do q = 0, r-1
+             t(q) = x(xoff + q*xstride)
+          enddo
+       endif
+
+       do o = 0, r-1
+          s = t(0)
+          do q = 1, r-1
+             w = p % w(mod(q * o, r) * (p % n / r))
+             if (inverse) w = conjg(w)
+             s = s + w * t(q)
+          enddo
+          y(yoff + k + o*ml) = s
+       enddo
+
+    enddo
+
+  end subroutine fft_step
+
+end module fft_poisson_module
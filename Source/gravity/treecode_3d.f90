@@ -0,0 +1,522 @@
+module treecode_module
+
+  ! A Barnes-Hut treecode for the gravitational potential on the
+  ! boundary of the coarse domain. This is an alternative to the
+  ! brute force direct summation in ca_compute_direct_sum_bc: the
+  ! zones on this processor are collected into a kd-tree, and every
+  ! boundary point then interacts with distant groups of zones through
+  ! their monopole and quadrupole moments instead of zone by zone.
+  ! The cost drops from O(N_zones * N_bc) to O(N_bc log N_zones).
+  !
+  ! Each processor builds a tree out of only the zones it owns, so the
+  ! boundary values are summed across processors by the caller exactly
+  ! as they are for the direct sum.
+
+  use amrex_fort_module, only : rt => amrex_real
+
+  implicit none
+
+  private
+
+  ! Maximum number of zones in a leaf of the tree.
+
+  integer, parameter :: leaf_size = 16
+
+  ! Zones (point masses) contributing to the potential.
+
+  integer, save :: npart = 0
+  real(rt), allocatable, save :: part_pos(:,:)
+  real(rt), allocatable, save :: part_mass(:)
+
+  ! The tree. Node n holds the zones part_idx(node_start(n):node_end(n)),
+  ! and node_child(:,n) = 0 marks a leaf. The moments are taken about
+  ! node_cen(:,n), and the quadrupole moment is stored as
+  ! (xx, yy, zz, xy, xz, yz). The root is at depth 0 and the deepest
+  ! leaf at depth tree_depth.
+
+  integer, save :: nnodes = 0
+  integer, save :: tree_depth = 0
+  integer,  allocatable, save :: part_idx(:)
+  integer,  allocatable, save :: node_start(:), node_end(:), node_child(:,:)
+  real(rt), allocatable, save :: node_mass(:), node_cen(:,:), node_dip(:,:), node_quad(:,:), node_rmax(:)
+
+  public :: ca_treecode_reset, ca_treecode_add_grid, ca_treecode_bc
+
+contains
+
+  subroutine ca_treecode_reset() bind(C, name="ca_treecode_reset")
+
+    implicit none
+
+    npart = 0
+    nnodes = 0
+
+  end subroutine ca_treecode_reset
+
+
+
+  subroutine ca_treecode_add_grid(lo, hi, dx, &
+                                  rho, r_lo, r_hi, &
+                                  vol, v_lo, v_hi, &
+                                  problo) bind(C, name="ca_treecode_add_grid")
+
+    ! Append the zones in lo:hi with nonzero mass. Zones covered by a
+    ! finer level are expected to have been masked out of rho already.
+
+    use bl_constants_module, only: ZERO, HALF
+
+    implicit none
+
+    integer , intent(in   ) :: lo(3), hi(3)
+    integer , intent(in   ) :: r_lo(3), r_hi(3)
+    integer , intent(in   ) :: v_lo(3), v_hi(3)
+    real(rt), intent(in   ) :: dx(3), problo(3)
+    real(rt), intent(in   ) :: rho(r_lo(1):r_hi(1),r_lo(2):r_hi(2),r_lo(3):r_hi(3))
+    real(rt), intent(in   ) :: vol(v_lo(1):v_hi(1),v_lo(2):v_hi(2),v_lo(3):v_hi(3))
+
+    integer  :: i, j, k, nnew
+    real(rt) :: mass
+
+    nnew = count(rho(lo(1):hi(1),lo(2):hi(2),lo(3):hi(3)) .ne. ZERO)
+
+    if (nnew == 0) return
+
+    call grow_particles(npart + nnew)
+
+    do k = lo(3), hi(3)
+       do j = lo(2), hi(2)
+          do i = lo(1), hi(1)
+
+             mass = rho(i,j,k) * vol(i,j,k)
+
+             if (mass .ne. ZERO) then
+                npart = npart + 1
+                part_pos(1,npart) = problo(1) + (dble(i)+HALF) * dx(1)
+                part_pos(2,npart) = problo(2) + (dble(j)+HALF) * dx(2)
+                part_pos(3,npart) = problo(3) + (dble(k)+HALF) * dx(3)
+                part_mass(npart) = mass
+             endif
+
+          enddo
+       enddo
+    enddo
+
+  end subroutine ca_treecode_add_grid
+
+
+
+  subroutine grow_particles(nmin)
+
+    implicit none
+
+    integer, intent(in) :: nmin
+
+    integer :: cap
+    real(rt), allocatable :: tmp_pos(:,:), tmp_mass(:)
+
+    if (allocated(part_mass)) then
+       if (size(part_mass) >= nmin) return
+       cap = max(nmin, 2 * size(part_mass))
+    else
+       cap = max(nmin, 1024)
+    endif
+
+    allocate(tmp_pos(3,cap))
+    allocate(tmp_mass(cap))
+
+    if (npart > 0) then
+       tmp_pos(:,1:npart) = part_pos(:,1:npart)
+       tmp_mass(1:npart)  = part_mass(1:npart)
+    endif
+
+    call move_alloc(tmp_pos, part_pos)
+    call move_alloc(tmp_mass, part_mass)
+
+  end subroutine grow_particles
+
+
+
+  subroutine build_tree()
+
+    ! Build the kd-tree breadth first. A node is split at the midpoint
+    ! of the longest side of the bounding box of its zones; the moments
+    ! are computed directly from the zones of each node.
+
+    use bl_constants_module, only: ZERO
+
+    implicit none
+
+    integer  :: n, p, q, s, e, d, mid, max_nodes, nodes_done
+    real(rt) :: bmin(3), bmax(3), split, dr(3), r2, m
+    integer  :: itmp
+    integer, allocatable :: node_depth(:)
+
+    if (allocated(node_start)) deallocate(part_idx, node_start, node_end, node_child, &
+                                          node_mass, node_cen, node_dip, node_quad, node_rmax)
+
+    max_nodes = max(2 * npart - 1, 1)
+
+    allocate(part_idx(npart))
+    allocate(node_start(max_nodes), node_end(max_nodes), node_child(2,max_nodes))
+    allocate(node_mass(max_nodes), node_cen(3,max_nodes), node_dip(3,max_nodes))
+    allocate(node_quad(6,max_nodes), node_rmax(max_nodes))
+    allocate(node_depth(max_nodes))
+
+    do p = 1, npart
+       part_idx(p) = p
+    enddo
+
+    nnodes = 1
+    node_start(1) = 1
+    node_end(1) = npart
+    node_depth(1) = 0
+    tree_depth = 0
+
+    nodes_done = 0
+
+    do while (nodes_done < nnodes)
+
+       nodes_done = nodes_done + 1
+       n = nodes_done
+
+       s = node_start(n)
+       e = node_end(n)
+
+       ! Multipole moments about the center of the bounding box. The
+       ! masses may have either sign (the sync solve works with a
+       ! density change), so we cannot expand about the center of mass
+       ! and keep the dipole term instead.
+
+       bmin(:) = part_pos(:,part_idx(s))
+       bmax(:) = bmin(:)
+
+       do p = s, e
+          q = part_idx(p)
+          bmin(:) = min(bmin(:), part_pos(:,q))
+          bmax(:) = max(bmax(:), part_pos(:,q))
+       enddo
+
+       node_cen(:,n) = 0.5e0_rt * (bmin(:) + bmax(:))
+
+       node_mass(n) = ZERO
+       node_dip(:,n) = ZERO
+       node_quad(:,n) = ZERO
+       node_rmax(n) = ZERO
+
+       do p = s, e
+          q = part_idx(p)
+          m = part_mass(q)
+          dr(:) = part_pos(:,q) - node_cen(:,n)
+          r2 = dr(1)**2 + dr(2)**2 + dr(3)**2
+
+          node_mass(n) = node_mass(n) + m
+
+          node_dip(:,n) = node_dip(:,n) + m * dr(:)
+
+          node_quad(1,n) = node_quad(1,n) + m * (3.0e0_rt * dr(1) * dr(1) - r2)
+          node_quad(2,n) = node_quad(2,n) + m * (3.0e0_rt * dr(2) * dr(2) - r2)
+          node_quad(3,n) = node_quad(3,n) + m * (3.0e0_rt * dr(3) * dr(3) - r2)
+          node_quad(4,n) = node_quad(4,n) + m * 3.0e0_rt * dr(1) * dr(2)
+          node_quad(5,n) = node_quad(5,n) + m * 3.0e0_rt * dr(1) * dr(3)
+          node_quad(6,n) = node_quad(6,n) + m * 3.0e0_rt * dr(2) * dr(3)
+
+          node_rmax(n) = max(node_rmax(n), sqrt(r2))
+       enddo
+
+       node_child(:,n) = 0
+
+       if (e - s + 1 <= leaf_size) cycle
+
+       ! Partition the zones about the midpoint of the longest side.
+
+       d = maxloc(bmax - bmin, dim=1)
+       split = 0.5e0_rt * (bmin(d) + bmax(d))
+
+       mid = s
+       do p = s, e
+          if (part_pos(d,part_idx(p)) < split) then
+             itmp = part_idx(p)
+             part_idx(p) = part_idx(mid)
+             part_idx(mid) = itmp
+             mid = mid + 1
+          endif
+       enddo
+
+       ! Zones that all sit at the same point cannot be separated
+       ! spatially; split them by count instead.
+
+       if (mid == s .or. mid > e) mid = (s + e + 1) / 2
+
+       node_child(1,n) = nnodes + 1
+       node_child(2,n) = nnodes + 2
+
+       node_start(nnodes+1) = s
+       node_end(nnodes+1)   = mid - 1
+       node_start(nnodes+2) = mid
+       node_end(nnodes+2)   = e
+
+       node_depth(nnodes+1:nnodes+2) = node_depth(n) + 1
+       tree_depth = max(tree_depth, node_depth(n) + 1)
+
+       nnodes = nnodes + 2
+
+    enddo
+
+    deallocate(node_depth)
+
+  end subroutine build_tree
+
+
+
+  function tree_potential(x, theta) result(pot)
+
+    ! Sum of m / r over all zones, as seen from the point x.
+
+    use bl_constants_module, only: ZERO, HALF
+
+    implicit none
+
+    real(rt), intent(in) :: x(3), theta
+    real(rt) :: pot
+
+    ! Every node popped pushes at most its two children, one level
+    ! deeper, so the stack never holds more than tree_depth + 1 nodes.
+
+    integer  :: stack(tree_depth+1), nstack, n, p, q
+    real(rt) :: dr(3), r2, r, dp, qr
+
+    pot = ZERO
+
+    if (nnodes == 0) return
+
+    nstack = 1
+    stack(1) = 1
+
+    do while (nstack > 0)
+
+       n = stack(nstack)
+       nstack = nstack - 1
+
+       dr(:) = x(:) - node_cen(:,n)
+       r2 = dr(1)**2 + dr(2)**2 + dr(3)**2
+       r = sqrt(r2)
+
+       if (r * theta > node_rmax(n)) then
+
+          ! Far enough away: expand to quadrupole order.
+
+          qr = node_quad(1,n) * dr(1) * dr(1) + &
+               node_quad(2,n) * dr(2) * dr(2) + &
+               node_quad(3,n) * dr(3) * dr(3) + &
+               2.0e0_rt * (node_quad(4,n) * dr(1) * dr(2) + &
+                           node_quad(5,n) * dr(1) * dr(3) + &
+                           node_quad(6,n) * dr(2) * dr(3))
+
+          dp = node_dip(1,n) * dr(1) + node_dip(2,n) * dr(2) + node_dip(3,n) * dr(3)
+
+          pot = pot + node_mass(n) / r + dp / (r2 * r) + HALF * qr / (r2 * r2 * r)
+
+       else if (node_child(1,n) == 0) then
+
+          do p = node_start(n), node_end(n)
+             q = part_idx(p)
+             dr(:) = x(:) - part_pos(:,q)
+             pot = pot + part_mass(q) / sqrt(dr(1)**2 + dr(2)**2 + dr(3)**2)
+          enddo
+
+       else
+
+          if (nstack + 2 > size(stack)) then
+             call bl_error("Error: tree_potential: traversal stack overflow")
+          endif
+
+          stack(nstack+1) = node_child(1,n)
+          stack(nstack+2) = node_child(2,n)
+          nstack = nstack + 2
+
+       endif
+
+    enddo
+
+  end function tree_potential
+
+
+
+  function bc_potential(locb, theta, problo, probhi, &
+                        doSymmetricAddLo, doSymmetricAddHi) result(phi)
+
+    ! The potential at the boundary point locb, including the mass
+    ! hidden behind symmetric boundaries. Reflecting the boundary point
+    ! rather than each zone gives the same images as
+    ! direct_sum_symmetric_add: every nonempty combination of the
+    ! symmetric lower faces, and likewise for the upper faces.
+
+    use fundamental_constants_module, only: Gconst
+    use bl_constants_module, only: TWO
+
+    implicit none
+
+    real(rt), intent(in) :: locb(3), theta, problo(3), probhi(3)
+    logical,  intent(in) :: doSymmetricAddLo(3), doSymmetricAddHi(3)
+    real(rt) :: phi
+
+    integer  :: c, b
+    real(rt) :: x(3), pot
+    logical  :: use_image
+
+    pot = tree_potential(locb, theta)
+
+    do c = 1, 7
+
+       use_image = .true.
+       x(:) = locb(:)
+       do b = 1, 3
+          if (btest(c, b-1)) then
+             use_image = use_image .and. doSymmetricAddLo(b)
+             x(b) = TWO * problo(b) - locb(b)
+          endif
+       enddo
+       if (use_image) pot = pot + tree_potential(x, theta)
+
+       use_image = .true.
+       x(:) = locb(:)
+       do b = 1, 3
+          if (btest(c, b-1)) then
+             use_image = use_image .and. doSymmetricAddHi(b)
+             x(b) = TWO * probhi(b) - locb(b)
+          endif
+       enddo
+       if (use_image) pot = pot + tree_potential(x, theta)
+
+    enddo
+
+    phi = -Gconst * pot
+
+  end function bc_potential
+
+
+
+  function bc_loc(l, b, bclo, bchi, problo, probhi, bcdx) result(x)
+
+    ! Location of boundary index l along direction b. As in
+    ! ca_compute_direct_sum_bc, the outermost points sit on the
+    ! domain edges and the rest at coarse cell centers.
+
+    use bl_constants_module, only: HALF
+
+    implicit none
+
+    integer,  intent(in) :: l, b, bclo(3), bchi(3)
+    real(rt), intent(in) :: problo(3), probhi(3), bcdx(3)
+    real(rt) :: x
+
+    if (l .eq. bclo(b)) then
+       x = problo(b)
+    else if (l .eq. bchi(b)) then
+       x = probhi(b)
+    else
+       x = problo(b) + (dble(l)+HALF) * bcdx(b)
+    endif
+
+  end function bc_loc
+
+
+
+  subroutine ca_treecode_bc(theta, symmetry_type, lo_bc, hi_bc, &
+                            problo, probhi, &
+                            bcXYLo, bcXYHi, &
+                            bcXZLo, bcXZHi, &
+                            bcYZLo, bcYZHi, &
+                            bclo, bchi, bcdx) bind(C, name="ca_treecode_bc")
+
+    ! Build the tree out of the zones added since the last reset and
+    ! add their potential to the boundary arrays, which have the same
+    ! layout as in ca_compute_direct_sum_bc.
+
+    implicit none
+
+    real(rt), intent(in   ) :: theta
+    integer , intent(in   ) :: symmetry_type
+    integer , intent(in   ) :: lo_bc(3), hi_bc(3)
+    integer , intent(in   ) :: bclo(3), bchi(3)
+    real(rt), intent(in   ) :: problo(3), probhi(3), bcdx(3)
+
+    real(rt), intent(inout) :: bcXYLo(bclo(1):bchi(1),bclo(2):bchi(2))
+    real(rt), intent(inout) :: bcXYHi(bclo(1):bchi(1),bclo(2):bchi(2))
+    real(rt), intent(inout) :: bcXZLo(bclo(1):bchi(1),bclo(3):bchi(3))
+    real(rt), intent(inout) :: bcXZHi(bclo(1):bchi(1),bclo(3):bchi(3))
+    real(rt), intent(inout) :: bcYZLo(bclo(2):bchi(2),bclo(3):bchi(3))
+    real(rt), intent(inout) :: bcYZHi(bclo(2):bchi(2),bclo(3):bchi(3))
+
+    integer  :: l, m, n
+    real(rt) :: locb(3)
+    logical  :: doSymmetricAddLo(3), doSymmetricAddHi(3)
+
+    if (npart == 0) return
+
+    doSymmetricAddLo(:) = lo_bc(:) .eq. symmetry_type
+    doSymmetricAddHi(:) = hi_bc(:) .eq. symmetry_type
+
+    call build_tree()
+
+    ! Every boundary point is independent, so the evaluation
+    ! is threaded over the outer index of each face.
+
+    !$omp parallel private(l, m, n, locb)
+
+    !$omp do schedule(dynamic)
+    do m = bclo(2), bchi(2)
+       locb(2) = bc_loc(m, 2, bclo, bchi, problo, probhi, bcdx)
+       do l = bclo(1), bchi(1)
+          locb(1) = bc_loc(l, 1, bclo, bchi, problo, probhi, bcdx)
+
+          locb(3) = problo(3)
+          bcXYLo(l,m) = bcXYLo(l,m) + bc_potential(locb, theta, problo, probhi, &
+                                                   doSymmetricAddLo, doSymmetricAddHi)
+
+          locb(3) = probhi(3)
+          bcXYHi(l,m) = bcXYHi(l,m) + bc_potential(locb, theta, problo, probhi, &
+                                                   doSymmetricAddLo, doSymmetricAddHi)
+       enddo
+    enddo
+    !$omp end do nowait
+
+    !$omp do schedule(dynamic)
+    do n = bclo(3), bchi(3)
+       locb(3) = bc_loc(n, 3, bclo, bchi, problo, probhi, bcdx)
+       do l = bclo(1), bchi(1)
+          locb(1) = bc_loc(l, 1, bclo, bchi, problo, probhi, bcdx)
+
+          locb(2) = problo(2)
+          bcXZLo(l,n) = bcXZLo(l,n) + bc_potential(locb, theta, problo, probhi, &
+                                                   doSymmetricAddLo, doSymmetricAddHi)
+
+          locb(2) = probhi(2)
+          bcXZHi(l,n) = bcXZHi(l,n) + bc_potential(locb, theta, problo, probhi, &
+                                                   doSymmetricAddLo, doSymmetricAddHi)
+       enddo
+    enddo
+    !$omp end do nowait
+
+    !$omp do schedule(dynamic)
+    do n = bclo(3), bchi(3)
+       locb(3) = bc_loc(n, 3, bclo, bchi, problo, probhi, bcdx)
+       do m = bclo(2), bchi(2)
+          locb(2) = bc_loc(m, 2, bclo, bchi, problo, probhi, bcdx)
+
+          locb(1) = problo(1)
+          bcYZLo(m,n) = bcYZLo(m,n) + bc_potential(locb, theta, problo, probhi, &
+                                                   doSymmetricAddLo, doSymmetricAddHi)
+
+          locb(1) = probhi(1)
+          bcYZHi(m,n) = bcYZHi(m,n) + bc_potential(locb, theta, problo, probhi, &
+                                                   doSymmetricAddLo, doSymmetricAddHi)
+       enddo
+    enddo
+    !$omp end do
+
+    !$omp end parallel
+
+  end subroutine ca_treecode_bc
+
+end module treecode_module
@@ -78,15 +78,23 @@ Castro::construct_hydro_source(Real time, Real dt)
       amrex::Abort("Castro::construct_hydro_source -- we don't implement a mode where we have radiation, but it is not coupled to hydro");
     }
 
-    FillPatchIterator fpi_rad(*this, Er_new, NUM_GROW, time, Rad_Type, 0, Radiation::nGroups);
+    // Unless it is filtered, the flux limiter is computed tile by tile
+    // below, which needs one more ghost cell of Er.
+    const bool tile_limiter = !radiation->pure_hydro && !Radiation::filter_lambda_T;
+
+    FillPatchIterator fpi_rad(*this, Er_new, tile_limiter ? NUM_GROW+1 : NUM_GROW,
+			      time, Rad_Type, 0, Radiation::nGroups);
     MultiFab& Erborder = fpi_rad.get_mf();
 
-    MultiFab lamborder(grids, dmap, Radiation::nGroups, NUM_GROW);
-    if (radiation->pure_hydro) {
-      lamborder.setVal(0.0, NUM_GROW);
-    }
-    else {
-      radiation->compute_limiter(level, grids, Sborder, Erborder, lamborder);
+    MultiFab lamborder;
+    if (!tile_limiter) {
+      lamborder.define(grids, dmap, Radiation::nGroups, NUM_GROW);
+      if (radiation->pure_hydro) {
+	lamborder.setVal(0.0, NUM_GROW);
+      }
+      else {
+	radiation->compute_limiter(level, grids, Sborder, Erborder, lamborder);
+      }
     }
 
     int nstep_fsp = -1;
@@ -121,6 +129,7 @@ Castro::construct_hydro_source(Real time, Real dt)
 #endif
 #ifdef RADIATION
       FArrayBox rad_flux[BL_SPACEDIM];
+      FArrayBox lam_tile, kpr_tile, Er_wide_tile;
 #endif
       FArrayBox q, qaux, src_q;
 
@@ -147,9 +156,15 @@ Castro::construct_hydro_source(Real time, Real dt)
 
 #ifdef RADIATION
 	  FArrayBox &Er = Erborder[mfi];
-	  FArrayBox &lam = lamborder[mfi];
 	  FArrayBox &Erout = Er_new[mfi];
 
+	  if (tile_limiter) {
+	    lam_tile.resize(qbx, Radiation::nGroups);
+	    radiation->compute_limiter(level, grids, mfi.validbox(), statein, Er,
+				       lam_tile, kpr_tile, Er_wide_tile);
+	  }
+	  FArrayBox &lam = tile_limiter ? lam_tile : lamborder[mfi];
+
 	  q.resize(qbx, QRADVAR);
 #else
 	  q.resize(qbx, QVAR);
@@ -401,15 +416,23 @@ Castro::construct_mol_hydro_source(Real time, Real dt)
     amrex::Abort("Castro::construct_mol_hydro_source -- we don't implement a mode where we have radiation, but it is not coupled to hydro");
   }
 
-  FillPatchIterator fpi_rad(*this, Er_new, NUM_GROW, time, Rad_Type, 0, Radiation::nGroups);
+  // Unless it is filtered, the flux limiter is computed tile by tile
+  // below, which needs one more ghost cell of Er.
+  const bool tile_limiter = !radiation->pure_hydro && !Radiation::filter_lambda_T;
+
+  FillPatchIterator fpi_rad(*this, Er_new, tile_limiter ? NUM_GROW+1 : NUM_GROW,
+			    time, Rad_Type, 0, Radiation::nGroups);
   MultiFab& Erborder = fpi_rad.get_mf();
 
-  MultiFab lamborder(grids, dmap, Radiation::nGroups, NUM_GROW);
-  if (radiation->pure_hydro) {
-    lamborder.setVal(0.0, NUM_GROW);
-  }
-  else {
-    radiation->compute_limiter(level, grids, Sborder, Erborder, lamborder);
+  MultiFab lamborder;
+  if (!tile_limiter) {
+    lamborder.define(grids, dmap, Radiation::nGroups, NUM_GROW);
+    if (radiation->pure_hydro) {
+      lamborder.setVal(0.0, NUM_GROW);
+    }
+    else {
+      radiation->compute_limiter(level, grids, Sborder, Erborder, lamborder);
+    }
   }
 
   int nstep_fsp = -1;
@@ -432,6 +455,7 @@ Castro::construct_mol_hydro_source(Real time, Real dt)
 #endif
 #ifdef RADIATION
     FArrayBox rad_flux[BL_SPACEDIM];
+    FArrayBox lam_tile, kpr_tile, Er_wide_tile;
 #endif
     FArrayBox q, qaux;
 
@@ -461,8 +485,14 @@ Castro::construct_mol_hydro_source(Real time, Real dt)
 
 #ifdef RADIATION
 	FArrayBox &Er = Erborder[mfi];
-	FArrayBox &lam = lamborder[mfi];
 	FArrayBox &Erout = Er_new[mfi];
+
+	if (tile_limiter) {
+	  lam_tile.resize(qbx, Radiation::nGroups);
+	  radiation->compute_limiter(level, grids, mfi.validbox(), statein, Er,
+				     lam_tile, kpr_tile, Er_wide_tile);
+	}
+	FArrayBox &lam = tile_limiter ? lam_tile : lamborder[mfi];
 #endif
 
 	FArrayBox& vol = volume[mfi];
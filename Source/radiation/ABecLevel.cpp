@@ -0,0 +1,325 @@
+#include <AMReX_ParmParse.H>
+#include <AMReX_LO_BCTYPES.H>
+
+#include "ABecLevel.H"
+#include "HABEC_F.H"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace amrex;
+
+Real ABecLevel::flux_factor = 1.0;
+
+ABecLevel::ABecLevel(const BoxArray& grids,
+                     const DistributionMapping& dmap,
+                     const Geometry& _geom)
+  : geom(_geom), reltol(0.0), abstol(0.0), bdp(0), bdcomp(0)
+{
+  ParmParse pp("habec");
+
+  verbose = 0; pp.query("v", verbose); pp.query("verbose", verbose);
+  verbose_threshold = 0; pp.query("verbose_threshold", verbose_threshold);
+
+  bho = 0; // higher order boundaries don't work with symmetric matrices
+
+  setup_reuse_tol = -1.0;
+  setup_group = -1;
+  setup_time = 0.0;
+  num_setups = 0;
+  num_setup_reuses = 0;
+  num_iterations_last = 0;
+
+  for (int i = 0; i < BL_SPACEDIM; i++) {
+    dx[i] = geom.CellSize(i);
+  }
+
+  int ncomp=1;
+  int ngrow=0;
+  acoefs.reset(new MultiFab(grids, dmap, ncomp, ngrow));
+  acoefs->setVal(0.0);
+
+  for (int i = 0; i < BL_SPACEDIM; i++) {
+    BoxArray edge_boxes(grids);
+    edge_boxes.surroundingNodes(i);
+    bcoefs[i].reset(new MultiFab(edge_boxes, dmap, ncomp, ngrow));
+  }
+}
+
+void ABecLevel::setScalars(Real Alpha, Real Beta)
+{
+  alpha = Alpha;
+  beta  = Beta;
+}
+
+void ABecLevel::aCoefficients(const MultiFab &a)
+{
+  BL_ASSERT( a.ok() );
+  BL_ASSERT( a.boxArray() == acoefs->boxArray() );
+  if (a.DistributionMap() == acoefs->DistributionMap()) {
+    MultiFab::Copy(*acoefs, a, 0, 0, 1, 0);
+  }
+  else {
+    acoefs->copy(a, 0, 0, 1);
+  }
+}
+
+void ABecLevel::bCoefficients(const MultiFab &b, int dir)
+{
+  BL_ASSERT( b.ok() );
+  BL_ASSERT( b.boxArray() == bcoefs[dir]->boxArray() );
+  if (b.DistributionMap() == bcoefs[dir]->DistributionMap()) {
+    MultiFab::Copy(*bcoefs[dir], b, 0, 0, 1, 0);
+  }
+  else {
+    bcoefs[dir]->copy(b, 0, 0, 1);
+  }
+}
+
+void ABecLevel::SPalpha(const MultiFab& a)
+{
+  BL_ASSERT( a.ok() );
+  if (SPa == 0) {
+    const BoxArray& grids = acoefs->boxArray();
+    const DistributionMapping& dmap = acoefs->DistributionMap();
+    SPa.reset(new MultiFab(grids,dmap,1,0));
+  }
+  if (a.DistributionMap() == SPa->DistributionMap()) {
+    MultiFab::Copy(*SPa, a, 0, 0, 1, 0);
+  }
+  else {
+    SPa->copy(a, 0, 0, 1);
+  }
+}
+
+void ABecLevel::buildMatrix(const MFIter& ai, Vector<Real>& mat)
+{
+  const int size = BL_SPACEDIM + 1;
+  int i = ai.index();
+  int idim;
+  const Box &reg = acoefs->boxArray()[i];
+
+  Vector<Real> r;
+  Real foo=1.e200;
+
+  mat.resize(size*reg.numPts());
+
+  // build matrix interior
+
+  hacoef(mat.dataPtr(),
+	 BL_TO_FORTRAN((*acoefs)[ai]),
+	 ARLIM(reg.loVect()), ARLIM(reg.hiVect()), alpha);
+
+  for (idim = 0; idim < BL_SPACEDIM; idim++) {
+    hbcoef(mat.dataPtr(),
+	   BL_TO_FORTRAN((*bcoefs[idim])[ai]),
+	   ARLIM(reg.loVect()), ARLIM(reg.hiVect()), beta, dx, idim);
+  }
+
+  // add b.c.'s to matrix diagonal, and
+  // zero out offdiag values at low domain boundaries (high done by symmetry)
+
+  const NGBndry& bd = getBndry();
+  const Box& domain = bd.getDomain();
+  for (OrientationIter oitr; oitr; oitr++) {
+    int cdir(oitr());
+    idim = oitr().coordDir();
+    const RadBoundCond &bct = bd.bndryConds(oitr())[i];
+    const Real      &bcl = bd.bndryLocs(oitr())[i];
+    const Mask      &msk = bd.bndryMasks(oitr(),i);
+    if (reg[oitr()] == domain[oitr()]) {
+      const int *tfp = NULL;
+      int bctype = bct;
+      if (bd.mixedBndry(oitr())) {
+        const BaseFab<int> &tf = *(bd.bndryTypes(oitr())[i]);
+        tfp = tf.dataPtr();
+        bctype = -1;
+      }
+      const Box &fsb = bd.bndryValues(oitr())[ai].box();
+      Real* pSPa;
+      Box SPabox;
+      if (SPa != 0) {
+	pSPa = (*SPa)[ai].dataPtr();
+	SPabox = (*SPa)[ai].box();
+      }
+      else {
+	pSPa = &foo;
+	SPabox = Box(IntVect::TheZeroVector(),IntVect::TheZeroVector());
+      }
+      getFaceMetric(r, reg, oitr(), geom);
+      hbmat3(mat.dataPtr(), ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
+	     cdir, bctype, tfp, bcl,
+	     ARLIM(fsb.loVect()), ARLIM(fsb.hiVect()),
+	     BL_TO_FORTRAN(msk),
+	     BL_TO_FORTRAN((*bcoefs[idim])[ai]),
+	     beta, dx, flux_factor, r.dataPtr(),
+	     pSPa, ARLIM(SPabox.loVect()), ARLIM(SPabox.hiVect()));
+    }
+    else {
+      hbmat(mat.dataPtr(), ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
+	    cdir, bct, bcl,
+	    BL_TO_FORTRAN(msk),
+	    BL_TO_FORTRAN((*bcoefs[idim])[ai]),
+	    beta, dx);
+    }
+  }
+}
+
+void ABecLevel::addBoundaryRhs(const MFIter& di, Real* vec)
+{
+  int i = di.index();
+  const Box &reg = acoefs->boxArray()[i];
+
+  Vector<Real> r;
+
+  const NGBndry& bd = getBndry();
+  const Box& domain = bd.getDomain();
+  for (OrientationIter oitr; oitr; oitr++) {
+    int cdir(oitr());
+    int idim = oitr().coordDir();
+    const RadBoundCond &bct = bd.bndryConds(oitr())[i];
+    const Real      &bcl = bd.bndryLocs(oitr())[i];
+    const FArrayBox       &fs  = bd.bndryValues(oitr())[di];
+    const Mask      &msk = bd.bndryMasks(oitr(),i);
+
+    if (reg[oitr()] == domain[oitr()]) {
+      const int *tfp = NULL;
+      int bctype = bct;
+      if (bd.mixedBndry(oitr())) {
+        const BaseFab<int> &tf = *(bd.bndryTypes(oitr())[i]);
+        tfp = tf.dataPtr();
+        bctype = -1;
+      }
+      getFaceMetric(r, reg, oitr(), geom);
+      hbvec3(vec, ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
+	     cdir, bctype, tfp, bho, bcl,
+	     BL_TO_FORTRAN_N(fs, bdcomp),
+	     BL_TO_FORTRAN(msk),
+	     BL_TO_FORTRAN((*bcoefs[idim])[di]),
+	     beta, dx, r.dataPtr());
+    }
+    else {
+      hbvec(vec, ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
+	    cdir, bct, bho, bcl,
+	    BL_TO_FORTRAN_N(fs, bdcomp),
+	    BL_TO_FORTRAN(msk),
+	    BL_TO_FORTRAN((*bcoefs[idim])[di]),
+	    beta, dx);
+    }
+  }
+}
+
+void ABecLevel::boundaryFlux(MultiFab* Flux, MultiFab& Soln, int icomp,
+                             BC_Mode inhom)
+{
+    BL_PROFILE("ABecLevel::boundaryFlux");
+    
+    const BoxArray &grids = Soln.boxArray();
+    
+    const NGBndry& bd = getBndry();
+    const Box& domain = bd.getDomain();
+    
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+	Vector<Real> r;
+	Real foo=1.e200;
+	
+	for (MFIter si(Soln); si.isValid(); ++si) {
+	    int i = si.index();
+	    const Box &reg = grids[i];
+	    for (OrientationIter oitr; oitr; oitr++) {
+		int cdir(oitr());
+		int idim = oitr().coordDir();
+		const RadBoundCond &bct = bd.bndryConds(oitr())[i];
+		const Real      &bcl = bd.bndryLocs(oitr())[i];
+		const FArrayBox       &fs  = bd.bndryValues(oitr())[si];
+		const Mask      &msk = bd.bndryMasks(oitr(),i);
+
+		if (reg[oitr()] == domain[oitr()]) {
+		    const int *tfp = NULL;
+		    int bctype = bct;
+		    if (bd.mixedBndry(oitr())) {
+			const BaseFab<int> &tf = *(bd.bndryTypes(oitr())[i]);
+			tfp = tf.dataPtr();
+			bctype = -1;
+		    }
+		    // In normal code operation only the fluxes at internal
+		    // Dirichlet boundaries are used.  Some diagnostics use the
+		    // fluxes computed at domain boundaries but these do not
+		    // influence the evolution of the interior solution.
+		    Real* pSPa;
+		    Box SPabox; 
+		    if (SPa != 0) {
+			pSPa = (*SPa)[si].dataPtr();
+			SPabox = (*SPa)[si].box();
+		    }
+		    else {
+			pSPa = &foo;
+			SPabox = Box(IntVect::TheZeroVector(),IntVect::TheZeroVector());
+		    }
+		    getFaceMetric(r, reg, oitr(), geom);
+		    hbflx3(BL_TO_FORTRAN(Flux[idim][si]),
+			   BL_TO_FORTRAN_N(Soln[si], icomp),
+			   ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
+			   cdir, bctype, tfp, bho, bcl,
+			   BL_TO_FORTRAN_N(fs, bdcomp),
+			   BL_TO_FORTRAN(msk),
+			   BL_TO_FORTRAN((*bcoefs[idim])[si]),
+			   beta, dx, flux_factor, r.dataPtr(), inhom,
+			   pSPa, ARLIM(SPabox.loVect()), ARLIM(SPabox.hiVect()));
+		}
+		else {
+		    hbflx(BL_TO_FORTRAN(Flux[idim][si]),
+			  BL_TO_FORTRAN_N(Soln[si], icomp),
+			  ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
+			  cdir, bct, bho, bcl,
+			  BL_TO_FORTRAN_N(fs, bdcomp),
+			  BL_TO_FORTRAN(msk),
+			  BL_TO_FORTRAN((*bcoefs[idim])[si]),
+			  beta, dx, inhom);
+		}
+	    }
+	}
+    }
+}
+
+void ABecLevel::getFaceMetric(Vector<Real>& r,
+                              const Box& reg,
+                              const Orientation& ori,
+                              const Geometry& geom)
+{
+  if (ori.coordDir() == 0) {
+    if (Geometry::IsCartesian()) {
+      r.resize(1, 1.0);
+    }
+    else { // RZ or Spherical
+      r.resize(1);
+      if (ori.isLow()) {
+        r[0] = geom.LoEdge(reg.smallEnd(0), 0);
+      }
+      else {
+        r[0] = geom.HiEdge(reg.bigEnd(0), 0);
+      }
+      if (Geometry::IsSPHERICAL()) {
+        r[0] *= r[0];
+      }
+    }
+  }
+  else {
+    if (Geometry::IsCartesian()) {
+      r.resize(reg.length(0), 1.0);
+    }
+    else { // RZ
+      // We only support spherical coordinates in 1D
+      BL_ASSERT(Geometry::IsRZ());
+      geom.GetCellLoc(r, reg, 0);
+    }
+  }
+}
@@ -0,0 +1,282 @@
+#include <AMReX_ParmParse.H>
+
+#include <RadBoundCond.H>
+
+#include "ABecMG.H"
+#include "HABEC_F.H"
+
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace amrex;
+
+ABecMG::ABecMG(const BoxArray& grids,
+               const DistributionMapping& dmap,
+               const Geometry& geom)
+  : final_res(0.0), broke_down(false)
+{
+  ParmParse pp("abecmg");
+
+  nu = 2;                   pp.query("nu", nu);
+  bottom_sweeps = 8;        pp.query("bottom_sweeps", bottom_sweeps);
+  int max_levels = 20;      pp.query("max_levels", max_levels);
+
+  // The piecewise constant coarse-grid correction is too small by about
+  // a factor of 2 for the diffusion part of the operator.
+  correction_factor = 2.0;  pp.query("correction_factor", correction_factor);
+
+  // Coarsen by 2 as long as every grid (and every periodic direction)
+  // allows it.  The coarse grids keep the distribution of the fine ones.
+
+  BoxArray ba(grids);
+  Box domain(geom.Domain());
+
+  for (int lev = 0; lev < max_levels; lev++) {
+
+    if (lev > 0) {
+      bool coarsenable = ba.coarsenable(2);
+      for (int idim = 0; idim < BL_SPACEDIM; idim++) {
+        if (geom.isPeriodic(idim) && domain.length(idim) % 2 != 0) {
+          coarsenable = false;
+        }
+      }
+      if (!coarsenable) {
+        break;
+      }
+      ba.coarsen(2);
+      domain.coarsen(2);
+    }
+
+    IntVect per(IntVect::TheZeroVector());
+    for (int idim = 0; idim < BL_SPACEDIM; idim++) {
+      if (geom.isPeriodic(idim)) {
+        per[idim] = domain.length(idim);
+      }
+    }
+    period.push_back(Periodicity(per));
+
+    st.emplace_back(new MultiFab(ba, dmap, 4, 1));
+    cor.emplace_back(new MultiFab(ba, dmap, 1, 1));
+    rhs.emplace_back(new MultiFab(ba, dmap, 1, 0));
+    res.emplace_back(new MultiFab(ba, dmap, 1, 0));
+
+    st[lev]->setVal(0.0);
+  }
+
+  nlevels = st.size();
+
+  sol.reset(new MultiFab(grids, dmap, 1, 1));
+  p.reset(new MultiFab(grids, dmap, 1, 1));
+  q.reset(new MultiFab(grids, dmap, 1, 0));
+  r.reset(new MultiFab(grids, dmap, 1, 0));
+}
+
+void ABecMG::setup()
+{
+  BL_PROFILE("ABecMG::setup");
+
+  // Couplings to cells outside the grids (and outside the domain, unless
+  // periodic) stay zero in the ghost cells.
+
+  st[0]->setBndry(0.0);
+  st[0]->FillBoundary(period[0]);
+
+  for (int lev = 1; lev < nlevels; lev++) {
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(*st[lev], true); mfi.isValid(); ++mfi) {
+      const Box& bx = mfi.tilebox();
+
+      ca_abecmg_coarsen(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+                        BL_TO_FORTRAN_3D((*st[lev-1])[mfi]),
+                        BL_TO_FORTRAN_3D((*st[lev])[mfi]));
+    }
+
+    st[lev]->setBndry(0.0);
+    st[lev]->FillBoundary(period[lev]);
+  }
+}
+
+void ABecMG::applyLevel(int lev, MultiFab& y, MultiFab& x)
+{
+  x.FillBoundary(period[lev]);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  for (MFIter mfi(y, true); mfi.isValid(); ++mfi) {
+    const Box& bx = mfi.tilebox();
+
+    ca_abecmg_apply(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+                    BL_TO_FORTRAN_3D((*st[lev])[mfi]),
+                    BL_TO_FORTRAN_3D(x[mfi]),
+                    BL_TO_FORTRAN_3D(y[mfi]));
+  }
+}
+
+void ABecMG::apply(MultiFab& y, const MultiFab& x)
+{
+  BL_PROFILE("ABecMG::apply");
+
+  MultiFab::Copy(*p, x, 0, 0, 1, 0);
+  p->setBndry(0.0);
+
+  applyLevel(0, *q, *p);
+
+  MultiFab::Copy(y, *q, 0, 0, 1, 0);
+}
+
+void ABecMG::residual(int lev, MultiFab& rr, MultiFab& x, const MultiFab& b)
+{
+  x.FillBoundary(period[lev]);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  for (MFIter mfi(rr, true); mfi.isValid(); ++mfi) {
+    const Box& bx = mfi.tilebox();
+
+    ca_abecmg_residual(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+                       BL_TO_FORTRAN_3D((*st[lev])[mfi]),
+                       BL_TO_FORTRAN_3D(x[mfi]),
+                       BL_TO_FORTRAN_3D(b[mfi]),
+                       BL_TO_FORTRAN_3D(rr[mfi]));
+  }
+}
+
+void ABecMG::smooth(int lev, int nsweeps, bool reverse)
+{
+  MultiFab& x = *cor[lev];
+  const MultiFab& b = *rhs[lev];
+
+  for (int sweep = 0; sweep < nsweeps; sweep++) {
+    for (int c = 0; c < 2; c++) {
+      const int color = reverse ? 1 - c : c;
+
+      x.FillBoundary(period[lev]);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+      for (MFIter mfi(x, true); mfi.isValid(); ++mfi) {
+        const Box& bx = mfi.tilebox();
+
+        ca_abecmg_gsrb(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+                       BL_TO_FORTRAN_3D((*st[lev])[mfi]),
+                       BL_TO_FORTRAN_3D(x[mfi]),
+                       BL_TO_FORTRAN_3D(b[mfi]),
+                       color);
+      }
+    }
+  }
+}
+
+void ABecMG::vcycle(int lev)
+{
+  cor[lev]->setVal(0.0);
+
+  if (lev == nlevels-1) {
+    smooth(lev, bottom_sweeps, false);
+    smooth(lev, bottom_sweeps, true);
+    return;
+  }
+
+  smooth(lev, nu, false);
+
+  residual(lev, *res[lev], *cor[lev], *rhs[lev]);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  for (MFIter mfi(*rhs[lev+1], true); mfi.isValid(); ++mfi) {
+    const Box& bx = mfi.tilebox();
+
+    ca_abecmg_restrict(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+                       BL_TO_FORTRAN_3D((*res[lev])[mfi]),
+                       BL_TO_FORTRAN_3D((*rhs[lev+1])[mfi]));
+  }
+
+  vcycle(lev+1);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  for (MFIter mfi(*rhs[lev+1], true); mfi.isValid(); ++mfi) {
+    const Box& bx = mfi.tilebox();
+
+    ca_abecmg_interp(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+                     BL_TO_FORTRAN_3D((*cor[lev])[mfi]),
+                     BL_TO_FORTRAN_3D((*cor[lev+1])[mfi]),
+                     correction_factor);
+  }
+
+  smooth(lev, nu, true);
+}
+
+int ABecMG::solve(MultiFab& x, const MultiFab& b, Real tol, int maxiter)
+{
+  BL_PROFILE("ABecMG::solve");
+
+  MultiFab::Copy(*sol, x, 0, 0, 1, 0);
+  sol->setBndry(0.0);
+  p->setVal(0.0);
+
+  const Real bnorm = std::sqrt(MultiFab::Dot(b, 0, b, 0, 1, 0));
+
+  // r = b - A x
+  residual(0, *r, *sol, b);
+
+  Real rnorm = std::sqrt(MultiFab::Dot(*r, 0, *r, 0, 1, 0));
+
+  int iter = 0;
+  Real rho = 0.0;
+
+  broke_down = false;
+
+  while (rnorm > tol * bnorm && iter < maxiter) {
+    iter++;
+
+    // z = M r, one V-cycle
+    MultiFab::Copy(*rhs[0], *r, 0, 0, 1, 0);
+    vcycle(0);
+    const MultiFab& z = *cor[0];
+
+    const Real rho_new = MultiFab::Dot(*r, 0, z, 0, 1, 0);
+
+    if (iter == 1) {
+      MultiFab::Copy(*p, z, 0, 0, 1, 0);
+    }
+    else {
+      p->mult(rho_new / rho, 0, 1, 0);
+      MultiFab::Add(*p, z, 0, 0, 1, 0);
+    }
+    rho = rho_new;
+
+    applyLevel(0, *q, *p);
+
+    const Real pq = MultiFab::Dot(*p, 0, *q, 0, 1, 0);
+    if (pq <= 0.0) {
+      // the operator (or the preconditioner) is not positive definite;
+      // the caller reports it
+      broke_down = true;
+      break;
+    }
+    const Real alpha = rho / pq;
+
+    MultiFab::Saxpy(*sol, alpha, *p, 0, 0, 1, 0);
+    MultiFab::Saxpy(*r, -alpha, *q, 0, 0, 1, 0);
+
+    rnorm = std::sqrt(MultiFab::Dot(*r, 0, *r, 0, 1, 0));
+  }
+
+  final_res = (bnorm > 0.0) ? rnorm / bnorm : rnorm;
+
+  MultiFab::Copy(x, *sol, 0, 0, 1, 0);
+
+  return iter;
+}
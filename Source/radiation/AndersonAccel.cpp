@@ -0,0 +1,155 @@
+#include <AMReX_ParallelDescriptor.H>
+
+#include "AndersonAccel.H"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace amrex;
+
+AndersonAccel::AndersonAccel(const BoxArray& grids,
+                             const DistributionMapping& dmap,
+                             int _ncomp, int _depth)
+  : ncomp(_ncomp), depth(_depth),
+    f_prev(grids, dmap, _ncomp, 0), g_prev(grids, dmap, _ncomp, 0),
+    f(grids, dmap, _ncomp, 0), mix(grids, dmap, _ncomp, 0)
+{
+  BL_ASSERT(depth > 0);
+
+  for (int i = 0; i < depth; i++) {
+    dF.emplace_back(new MultiFab(grids, dmap, ncomp, 0));
+    dG.emplace_back(new MultiFab(grids, dmap, ncomp, 0));
+  }
+
+  reset();
+}
+
+void AndersonAccel::reset()
+{
+  nhist = 0;
+  newest = depth - 1;
+  have_prev = false;
+}
+
+int AndersonAccel::update(MultiFab& gx, const MultiFab& x)
+{
+  BL_PROFILE("AndersonAccel::update");
+
+  // f = G(x) - x
+  MultiFab::LinComb(f, 1.0, gx, 0, -1.0, x, 0, 0, ncomp, 0);
+
+  if (have_prev) {
+    newest = (newest + 1) % depth;
+    MultiFab::LinComb(*dF[newest], 1.0, f, 0, -1.0, f_prev, 0, 0, ncomp, 0);
+    MultiFab::LinComb(*dG[newest], 1.0, gx, 0, -1.0, g_prev, 0, 0, ncomp, 0);
+    nhist = std::min(nhist + 1, depth);
+  }
+
+  MultiFab::Copy(f_prev, f, 0, 0, ncomp, 0);
+  MultiFab::Copy(g_prev, gx, 0, 0, ncomp, 0);
+  have_prev = true;
+
+  if (nhist == 0) {
+    return 0;
+  }
+
+  const int m = nhist;
+
+  // slot of the i-th history vector, i = 0 being the newest
+  Vector<int> slot(m);
+  for (int i = 0; i < m; i++) {
+    slot[i] = (newest - i + depth) % depth;
+  }
+
+  // Normal equations of min |f - dF gamma|: the Gram matrix of dF
+  // (upper triangle) and dF^T f, summed with a single reduction.
+
+  const int nsums = m*(m+1)/2 + m;
+  Vector<Real> sums(nsums, 0.0);
+
+  for (MFIter mfi(f); mfi.isValid(); ++mfi) {
+    const Box& bx = mfi.validbox();
+    int n = 0;
+    for (int i = 0; i < m; i++) {
+      const FArrayBox& dfi = (*dF[slot[i]])[mfi];
+      for (int j = i; j < m; j++) {
+        sums[n++] += dfi.dot(bx, 0, (*dF[slot[j]])[mfi], bx, 0, ncomp);
+      }
+      sums[n++] += dfi.dot(bx, 0, f[mfi], bx, 0, ncomp);
+    }
+  }
+
+  ParallelDescriptor::ReduceRealSum(sums.dataPtr(), nsums);
+
+  Vector<Real> H(m*m), gamma(m);
+  {
+    int n = 0;
+    for (int i = 0; i < m; i++) {
+      for (int j = i; j < m; j++) {
+        H[i*m+j] = H[j*m+i] = sums[n++];
+      }
+      gamma[i] = sums[n++];
+    }
+  }
+
+  // A little regularization keeps nearly dependent histories harmless.
+  Real hmax = 0.0;
+  for (int i = 0; i < m; i++) {
+    hmax = std::max(hmax, H[i*m+i]);
+  }
+  if (hmax <= 0.0) {
+    return 0;
+  }
+  for (int i = 0; i < m; i++) {
+    H[i*m+i] += 1.e-12 * hmax;
+  }
+
+  // Gaussian elimination; H is symmetric positive definite
+  for (int k = 0; k < m; k++) {
+    for (int i = k+1; i < m; i++) {
+      Real fac = H[i*m+k] / H[k*m+k];
+      for (int j = k; j < m; j++) {
+        H[i*m+j] -= fac * H[k*m+j];
+      }
+      gamma[i] -= fac * gamma[k];
+    }
+  }
+  for (int k = m-1; k >= 0; k--) {
+    for (int j = k+1; j < m; j++) {
+      gamma[k] -= H[k*m+j] * gamma[j];
+    }
+    gamma[k] /= H[k*m+k];
+  }
+
+  for (int i = 0; i < m; i++) {
+    if (!std::isfinite(gamma[i])) {
+      reset();
+      return 0;
+    }
+  }
+
+  // mix = G(x) - dG gamma
+  MultiFab::Copy(mix, gx, 0, 0, ncomp, 0);
+  for (int i = 0; i < m; i++) {
+    MultiFab::Saxpy(mix, -gamma[i], *dG[slot[i]], 0, 0, ncomp, 0);
+  }
+
+  Real mixmin = 1.e200;
+  for (MFIter mfi(mix); mfi.isValid(); ++mfi) {
+    const Box& bx = mfi.validbox();
+    for (int n = 0; n < ncomp; n++) {
+      mixmin = std::min(mixmin, mix[mfi].min(bx, n));
+    }
+  }
+  ParallelDescriptor::ReduceRealMin(mixmin);
+
+  if (mixmin < 0.0) {
+    // keep the plain iterate and drop the history (but not this step)
+    nhist = 0;
+    return 0;
+  }
+
+  MultiFab::Copy(gx, mix, 0, 0, ncomp, 0);
+
+  return m;
+}
@@ -1,8 +1,10 @@
-! This subroutine cannot be tiled
+! reg_lo:reg_hi is the valid box of the grid.  The box of lam may be
+! any part of the grid and its ghost cells; this is how the
+! subroutine is tiled.  The filter works on the whole grid only.
 subroutine ca_compute_lamborder(Er, Er_l1, Er_h1, &
      kap, kap_l1, kap_h1, &
      lam, lam_l1, lam_h1, &
-     dx, ngrow, limiter, filter_T, S)
+     dx, reg_lo, reg_hi, limiter, filter_T, S)
 
   use rad_params_module, only : ngroups
   use fluxlimiter_module, only : FLDlambda
@@ -12,7 +14,8 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_h1, &
   implicit none
 
   integer, intent(in) :: Er_l1, Er_h1, kap_l1, kap_h1, lam_l1, lam_h1
-  integer, intent(in) :: ngrow, limiter, filter_T, S
+  integer, intent(in) :: reg_lo(1), reg_hi(1)
+  integer, intent(in) :: limiter, filter_T, S
   real(rt)        , intent(in) :: dx
   real(rt)        , intent(in) :: kap(kap_l1:kap_h1, 0:ngroups-1)
   real(rt)        , intent(in) :: Er(Er_l1:Er_h1, 0:ngroups-1)
@@ -25,8 +28,8 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_h1, &
 
   lam = -1.e50_rt
 
-  reg_l1 = lam_l1 + ngrow
-  reg_h1 = lam_h1 - ngrow
+  reg_l1 = reg_lo(1)
+  reg_h1 = reg_hi(1)
 
   if (filter_T .gt. 0) then
      allocate(lamfil(reg_l1:reg_h1))
@@ -39,16 +42,20 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_h1, &
         lam(i,g) = FLDlambda(r, limiter)
      end do
 
-     if (Er(reg_l1-1,g) .eq. -1.e0_rt) then
-        r = abs(Er(reg_l1+1,g) - Er(reg_l1,g)) / dx
-        r = r / (kap(reg_l1,g) * max(Er(reg_l1,g), 1.e-50_rt))
-        lam(reg_l1,g) = FLDlambda(r, limiter)
+     if (reg_l1 .ge. lam_l1) then
+        if (Er(reg_l1-1,g) .eq. -1.e0_rt) then
+           r = abs(Er(reg_l1+1,g) - Er(reg_l1,g)) / dx
+           r = r / (kap(reg_l1,g) * max(Er(reg_l1,g), 1.e-50_rt))
+           lam(reg_l1,g) = FLDlambda(r, limiter)
+        end if
      end if
 
-     if (Er(reg_h1+1,g) .eq. -1.e0_rt) then
-        r = abs(Er(reg_h1,g) - Er(reg_h1-1,g)) / dx
-        r = r / (kap(reg_h1,g) * max(Er(reg_h1,g), 1.e-50_rt))
-        lam(reg_h1,g) = FLDlambda(r, limiter)
+     if (reg_h1 .le. lam_h1) then
+        if (Er(reg_h1+1,g) .eq. -1.e0_rt) then
+           r = abs(Er(reg_h1,g) - Er(reg_h1-1,g)) / dx
+           r = r / (kap(reg_h1,g) * max(Er(reg_h1,g), 1.e-50_rt))
+           lam(reg_h1,g) = FLDlambda(r, limiter)
+        end if
      end if
 
      ! filter
@@ -1,8 +1,10 @@
-! This subroutine cannot be tiled
+! reg_lo:reg_hi is the valid box of the grid.  The box of lam may be
+! any part of the grid and its ghost cells; this is how the
+! subroutine is tiled.  The filter works on the whole grid only.
 subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_h1, Er_h2, &
                                 kap, kap_l1, kap_l2, kap_h1, kap_h2, &
                                 lam, lam_l1, lam_l2, lam_h1, lam_h2, &
-                                dx, ngrow, limiter, filter_T, S)
+                                dx, reg_lo, reg_hi, limiter, filter_T, S)
 
   use rad_params_module, only : ngroups
   use fluxlimiter_module, only : FLDlambda
@@ -13,7 +15,8 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_h1, Er_h2, &
 
   integer, intent(in) :: Er_l1, Er_l2, Er_h1, Er_h2, kap_l1, kap_l2, kap_h1, kap_h2, &
        lam_l1, lam_l2, lam_h1, lam_h2
-  integer, intent(in) :: ngrow, limiter, filter_T, S
+  integer, intent(in) :: reg_lo(2), reg_hi(2)
+  integer, intent(in) :: limiter, filter_T, S
   real(rt)        , intent(in) :: dx(2)
   real(rt)        , intent(in) :: kap(kap_l1:kap_h1, kap_l2:kap_h2)
   real(rt)        , intent(in) :: Er(Er_l1:Er_h1, Er_l2:Er_h2, 0:ngroups-1)
@@ -26,10 +29,10 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_h1, Er_h2, &
 
   lam = -1.e50_rt
 
-  reg_l1 = lam_l1 + ngrow
-  reg_l2 = lam_l2 + ngrow
-  reg_h1 = lam_h1 - ngrow
-  reg_h2 = lam_h2 - ngrow
+  reg_l1 = reg_lo(1)
+  reg_l2 = reg_lo(2)
+  reg_h1 = reg_hi(1)
+  reg_h2 = reg_hi(2)
 
   if (filter_T .gt. 0) then
      allocate(lamfil(reg_l1:reg_h1,lam_l2:lam_h2))
@@ -392,7 +395,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_h1, Er_h2, &
 
   ! reg-x lo-y
   do j=lam_l2,reg_l2-1
-     do i=reg_l1,reg_h1
+     do i=max(reg_l1,lam_l1), min(reg_h1,lam_h1)
         if (Er(i,j,g).eq.-1.e0_rt) then
            lam(i,j,g) = lam(i,reg_l2,g)
         end if
@@ -409,7 +412,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_h1, Er_h2, &
   end do
 
   ! lo-x reg-y
-  do j=reg_l2,reg_h2
+  do j=max(reg_l2,lam_l2), min(reg_h2,lam_h2)
      do i=lam_l1,reg_l1-1
         if (Er(i,j,g).eq.-1.e0_rt) then
            lam(i,j,g) = lam(reg_l1,j,g)
@@ -418,7 +421,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_h1, Er_h2, &
   end do
 
   ! hi-x reg-y
-  do j=reg_l2,reg_h2
+  do j=max(reg_l2,lam_l2), min(reg_h2,lam_h2)
      do i=reg_h1+1,lam_h1
         if (Er(i,j,g).eq.-1.e0_rt) then
            lam(i,j,g) = lam(reg_h1,j,g)
@@ -437,7 +440,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_h1, Er_h2, &
 
   ! reg-x hi-y
   do j=reg_h2+1,lam_h2
-     do i=reg_l1,reg_h1
+     do i=max(reg_l1,lam_l1), min(reg_h1,lam_h1)
         if (Er(i,j,g).eq.-1.e0_rt) then
            lam(i,j,g) = lam(i,reg_h2,g)
         end if
@@ -1,8 +1,10 @@
-! This subroutine cannot be tiled
+! reg_lo:reg_hi is the valid box of the grid.  The box of lam may be
+! any part of the grid and its ghost cells; this is how the
+! subroutine is tiled.  The filter works on the whole grid only.
 subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
                                 kap, kap_l1, kap_l2, kap_l3, kap_h1, kap_h2, kap_h3, &
                                 lam, lam_l1, lam_l2, lam_l3, lam_h1, lam_h2, lam_h3, &
-                                dx, ngrow, limiter, filter_T, S)
+                                dx, reg_lo, reg_hi, limiter, filter_T, S)
 
   use rad_params_module, only : ngroups
   use fluxlimiter_module, only : FLDlambda
@@ -14,7 +16,8 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   integer, intent(in) :: Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
        kap_l1, kap_l2, kap_l3, kap_h1, kap_h2, kap_h3, &
        lam_l1, lam_l2, lam_l3, lam_h1, lam_h2, lam_h3
-  integer, intent(in) :: ngrow, limiter, filter_T, S
+  integer, intent(in) :: reg_lo(3), reg_hi(3)
+  integer, intent(in) :: limiter, filter_T, S
   real(rt)        , intent(in) :: dx(3)
   real(rt)        , intent(in) :: kap(kap_l1:kap_h1, kap_l2:kap_h2, kap_l3:kap_h3, 0:ngroups-1)
   real(rt)        , intent(in) :: Er(Er_l1:Er_h1, Er_l2:Er_h2, Er_l3:Er_h3, 0:ngroups-1)
@@ -25,12 +28,12 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
 
   real(rt)        , allocatable :: lamfil(:,:,:)
 
-  reg_l1 = lam_l1 + ngrow
-  reg_l2 = lam_l2 + ngrow
-  reg_l3 = lam_l3 + ngrow
-  reg_h1 = lam_h1 - ngrow
-  reg_h2 = lam_h2 - ngrow
-  reg_h3 = lam_h3 - ngrow
+  reg_l1 = reg_lo(1)
+  reg_l2 = reg_lo(2)
+  reg_l3 = reg_lo(3)
+  reg_h1 = reg_hi(1)
+  reg_h2 = reg_hi(2)
+  reg_h3 = reg_hi(3)
 
   if (filter_T .gt. 0) then
      allocate(lamfil(reg_l1:reg_h1,lam_l2:lam_h2,lam_l3:lam_h3))
@@ -650,7 +653,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   ! reg-x lo-y lo-z
   do k=lam_l3,reg_l3-1
      do j=lam_l2,reg_l2-1
-        do i=reg_l1,reg_h1
+        do i=max(reg_l1,lam_l1), min(reg_h1,lam_h1)
            if (Er(i,j,k,g).eq.-1.e0_rt) then
               lam(i,j,k,g) = lam(i,reg_l2,reg_l3,g)
            end if
@@ -671,7 +674,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
 
   ! lo-x reg-y lo-z
   do k=lam_l3,reg_l3-1
-     do j=reg_l2,reg_h2
+     do j=max(reg_l2,lam_l2), min(reg_h2,lam_h2)
         do i=lam_l1,reg_l1-1
            lam(i,j,k,g) = lam(reg_l1,j,reg_l3,g)
         end do
@@ -680,8 +683,8 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
 
   ! reg-x reg-y lo-z side
   do k=lam_l3,reg_l3-1
-     do j=reg_l2,reg_h2
-        do i=reg_l1,reg_h1
+     do j=max(reg_l2,lam_l2), min(reg_h2,lam_h2)
+        do i=max(reg_l1,lam_l1), min(reg_h1,lam_h1)
            if (Er(i,j,k,g).eq.-1.e0_rt) then
               lam(i,j,k,g) = lam(i,j,reg_l3,g)
            end if
@@ -691,7 +694,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
 
   ! hi-x reg-y lo-z
   do k=lam_l3,reg_l3-1
-     do j=reg_l2,reg_h2
+     do j=max(reg_l2,lam_l2), min(reg_h2,lam_h2)
         do i=reg_h1+1,lam_h1
            lam(i,j,k,g) = lam(reg_h1,j,reg_l3,g)
         end do
@@ -712,7 +715,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   ! reg-x hi-y lo-z
   do k=lam_l3,reg_l3-1
      do j=reg_h2+1,lam_h2
-        do i=reg_l1,reg_h1
+        do i=max(reg_l1,lam_l1), min(reg_h1,lam_h1)
            if (Er(i,j,k,g).eq.-1.e0_rt) then
               lam(i,j,k,g) = lam(i,reg_h2,reg_l3,g)
            end if
@@ -732,7 +735,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   end do
 
   ! lo-x lo-y reg-z
-  do k=reg_l3,reg_h3
+  do k=max(reg_l3,lam_l3), min(reg_h3,lam_h3)
      do j=lam_l2,reg_l2-1
         do i=lam_l1,reg_l1-1
            if (Er(i,j,k,g).eq.-1.e0_rt) then
@@ -743,9 +746,9 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   end do
 
   ! reg-x lo-y reg-z
-  do k=reg_l3,reg_h3
+  do k=max(reg_l3,lam_l3), min(reg_h3,lam_h3)
      do j=lam_l2,reg_l2-1
-        do i=reg_l1,reg_h1
+        do i=max(reg_l1,lam_l1), min(reg_h1,lam_h1)
            if (Er(i,j,k,g).eq.-1.e0_rt) then
               lam(i,j,k,g) = lam(i,reg_l2,k,g)
            end if
@@ -754,7 +757,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   end do
 
   ! hi-x lo-y reg-z
-  do k=reg_l3,reg_h3
+  do k=max(reg_l3,lam_l3), min(reg_h3,lam_h3)
      do j=lam_l2,reg_l2-1
         do i=reg_h1+1,lam_h1
            if (Er(i,j,k,g).eq.-1.e0_rt) then
@@ -765,8 +768,8 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   end do
 
   ! lo-x reg-y reg-z
-  do k=reg_l3,reg_h3
-     do j=reg_l2,reg_h2
+  do k=max(reg_l3,lam_l3), min(reg_h3,lam_h3)
+     do j=max(reg_l2,lam_l2), min(reg_h2,lam_h2)
         do i=lam_l1,reg_l1-1
            if (Er(i,j,k,g).eq.-1.e0_rt) then
               lam(i,j,k,g) = lam(reg_l1,j,k,g)
@@ -776,8 +779,8 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   end do
 
   ! hi-x reg-y reg-z
-  do k=reg_l3,reg_h3
-     do j=reg_l2,reg_h2
+  do k=max(reg_l3,lam_l3), min(reg_h3,lam_h3)
+     do j=max(reg_l2,lam_l2), min(reg_h2,lam_h2)
         do i=reg_h1+1,lam_h1
            if (Er(i,j,k,g).eq.-1.e0_rt) then
               lam(i,j,k,g) = lam(reg_h1,j,k,g)
@@ -787,7 +790,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   end do
 
   ! lo-x hi-y reg-z
-  do k=reg_l3,reg_h3
+  do k=max(reg_l3,lam_l3), min(reg_h3,lam_h3)
      do j=reg_h2+1,lam_h2
         do i=lam_l1,reg_l1-1
            if (Er(i,j,k,g).eq.-1.e0_rt) then
@@ -798,9 +801,9 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   end do
 
   ! reg-x hi-y reg-z
-  do k=reg_l3,reg_h3
+  do k=max(reg_l3,lam_l3), min(reg_h3,lam_h3)
      do j=reg_h2+1,lam_h2
-        do i=reg_l1,reg_h1
+        do i=max(reg_l1,lam_l1), min(reg_h1,lam_h1)
            if (Er(i,j,k,g).eq.-1.e0_rt) then
               lam(i,j,k,g) = lam(i,reg_h2,k,g)
            end if
@@ -809,7 +812,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   end do
 
   ! hi-x hi-y reg-z
-  do k=reg_l3,reg_h3
+  do k=max(reg_l3,lam_l3), min(reg_h3,lam_h3)
      do j=reg_h2+1,lam_h2
         do i=reg_h1+1,lam_h1
            if (Er(i,j,k,g).eq.-1.e0_rt) then
@@ -833,7 +836,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   ! reg-x lo-y hi-z
   do k=reg_h3+1,lam_h3
      do j=lam_l2,reg_l2-1
-        do i=reg_l1,reg_h1
+        do i=max(reg_l1,lam_l1), min(reg_h1,lam_h1)
            if (Er(i,j,k,g).eq.-1.e0_rt) then
               lam(i,j,k,g) = lam(i,reg_l2,reg_h3,g)
            end if
@@ -854,7 +857,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
 
   ! lo-x reg-y hi-z
   do k=reg_h3+1,lam_h3
-     do j=reg_l2,reg_h2
+     do j=max(reg_l2,lam_l2), min(reg_h2,lam_h2)
         do i=lam_l1,reg_l1-1
            lam(i,j,k,g) = lam(reg_l1,j,reg_h3,g)
         end do
@@ -863,8 +866,8 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
 
   ! reg-x reg-y hi-z
   do k=reg_h3+1,lam_h3
-     do j=reg_l2,reg_h2
-        do i=reg_l1,reg_h1
+     do j=max(reg_l2,lam_l2), min(reg_h2,lam_h2)
+        do i=max(reg_l1,lam_l1), min(reg_h1,lam_h1)
            if (Er(i,j,k,g).eq.-1.e0_rt) then
               lam(i,j,k,g) = lam(i,j,reg_h3,g)
            end if
@@ -874,7 +877,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
 
   ! hi-x reg-y hi-z
   do k=reg_h3+1,lam_h3
-     do j=reg_l2,reg_h2
+     do j=max(reg_l2,lam_l2), min(reg_h2,lam_h2)
         do i=reg_h1+1,lam_h1
            lam(i,j,k,g) = lam(reg_h1,j,reg_h3,g)
         end do
@@ -895,7 +898,7 @@ subroutine ca_compute_lamborder(Er, Er_l1, Er_l2, Er_l3, Er_h1, Er_h2, Er_h3, &
   ! reg-x hi-y hi-z
   do k=reg_h3+1,lam_h3
      do j=reg_h2+1,lam_h2
-        do i=reg_l1,reg_h1
+        do i=max(reg_l1,lam_l1), min(reg_h1,lam_h1)
            if (Er(i,j,k,g).eq.-1.e0_rt) then
               lam(i,j,k,g) = lam(i,reg_h2,reg_h3,g)
            end if
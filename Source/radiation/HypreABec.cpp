@@ -3,9 +3,10 @@
 #include <AMReX_LO_BCTYPES.H>
 
 #include "HypreABec.H"
-#include "HABEC_F.H"
 
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -20,8 +21,6 @@ static int ispow2(int i)
   return (i == 1) ? 1 : (((i <= 0) || (i & 1)) ? 0 : ispow2(i / 2));
 }
 
-Real HypreABec::flux_factor = 1.0;
-
 #if (BL_SPACEDIM == 1)
 static int vl[2] = { 0, 0 };
 static int vh[2] = { 0, 0 };
@@ -48,14 +47,23 @@ static int* hiV(const Box& b) {
 HypreABec::HypreABec(const BoxArray& grids,
 		     const DistributionMapping& dmap,
 		     const Geometry& _geom,
-		     int _solver_flag)
-  : geom(_geom), solver_flag(_solver_flag)
+		     int _solver_flag,
+		     MPI_Comm _comm)
+  : ABecLevel(grids, dmap, _geom), solver_flag(_solver_flag), comm(_comm)
 {
   ParmParse pp("habec");
 
   pfmg_relax_type = 1; pp.query("pfmg_relax_type", pfmg_relax_type);
-  verbose = 0; pp.query("v", verbose); pp.query("verbose", verbose);
-  verbose_threshold = 0; pp.query("verbose_threshold", verbose_threshold);
+  pp.query("setup_reuse_tol", setup_reuse_tol);
+
+  if (solver_flag != 0 && solver_flag != 1 &&
+      solver_flag != 3 && solver_flag != 4) {
+    // Jacobi has nothing to reuse, and the hybrid solver redoes the
+    // setup of its preconditioner inside the solve anyway.
+    setup_reuse_tol = -1.0;
+  }
+
+  solver_ready = 0;
 
   static int first = 1;
   if (verbose >= 1 && first && ParallelDescriptor::IOProcessor()) {
@@ -65,8 +73,8 @@ HypreABec::HypreABec(const BoxArray& grids,
     }
     std::cout << "habec.verbose                   = " << verbose << std::endl;
     std::cout << "habec.verbose_threshold         = " << verbose_threshold << std::endl;
+    std::cout << "habec.setup_reuse_tol           = " << setup_reuse_tol << std::endl;
   }
-  bho = 0; // higher order boundaries don't work with symmetric matrices
 
   int i;
 #if defined(BL_USE_MPI) || !(defined(BL_BGL) || defined(chaos_3_x86_64_ib) || defined(chaos_3_x86_64))
@@ -81,14 +89,15 @@ HypreABec::HypreABec(const BoxArray& grids,
     MPI_Init(&argc, (char***)&argv);
   }
 
-  int num_procs, myid;
+  if (comm == MPI_COMM_NULL) {
+    // This processor is not in the solver's communicator (and owns
+    // none of the grids); it only takes part in the coefficient copies.
+    return;
+  }
 
-  MPI_Comm_size(MPI_COMM_WORLD, &num_procs );
-  MPI_Comm_rank(MPI_COMM_WORLD, &myid );
+  int num_procs;
 
-  for (i = 0; i < BL_SPACEDIM; i++) {
-    dx[i] = geom.CellSize(i);
-  }
+  MPI_Comm_size(comm, &num_procs );
 
 #if (BL_SPACEDIM == 1)
 
@@ -97,7 +106,7 @@ HypreABec::HypreABec(const BoxArray& grids,
   // (SMG reduces to cyclic reduction in this case, so it's an exact solve.)
   // (PFMG will not work.)
 
-  HYPRE_StructGridCreate(MPI_COMM_WORLD, 2, &hgrid);
+  HYPRE_StructGridCreate(comm, 2, &hgrid);
 
   if (geom.isAnyPeriodic()) {
     BL_ASSERT(geom.isPeriodic(0));
@@ -113,7 +122,7 @@ HypreABec::HypreABec(const BoxArray& grids,
 
 #else
 
-  HYPRE_StructGridCreate(MPI_COMM_WORLD, BL_SPACEDIM, &hgrid);
+  HYPRE_StructGridCreate(comm, BL_SPACEDIM, &hgrid);
 
   if (geom.isAnyPeriodic()) {
     int is_periodic[BL_SPACEDIM];
@@ -130,12 +139,11 @@ HypreABec::HypreABec(const BoxArray& grids,
 #endif
 
   if (num_procs != 1) {
-    // parallel section:
-    BL_ASSERT(ParallelDescriptor::NProcs() == num_procs);
-    BL_ASSERT(ParallelDescriptor::MyProc() == myid);
+    // parallel section (dmap is in terms of the global ranks):
+    BL_ASSERT(comm != MPI_COMM_WORLD || ParallelDescriptor::NProcs() == num_procs);
 
     for (i = 0; i < grids.size(); i++) {
-      if (dmap[i] == myid) {
+      if (dmap[i] == ParallelDescriptor::MyProc()) {
 	HYPRE_StructGridSetExtents(hgrid, loV(grids[i]), hiV(grids[i]));
       }
     }
@@ -189,40 +197,35 @@ HypreABec::HypreABec(const BoxArray& grids,
     HYPRE_StructStencilSetElement(stencil, i, offsets[i]);
   }
 
-  HYPRE_StructMatrixCreate(MPI_COMM_WORLD, hgrid, stencil, &A);
+  HYPRE_StructMatrixCreate(comm, hgrid, stencil, &A);
   HYPRE_StructMatrixSetSymmetric(A, 1);
   HYPRE_StructMatrixSetNumGhost(A, A_num_ghost);
   HYPRE_StructMatrixInitialize(A);
 
-  HYPRE_StructMatrixCreate(MPI_COMM_WORLD, hgrid, stencil, &A0);
+  HYPRE_StructMatrixCreate(comm, hgrid, stencil, &A0);
   HYPRE_StructMatrixSetSymmetric(A0, 1);
   HYPRE_StructMatrixSetNumGhost(A0, A_num_ghost);
   HYPRE_StructMatrixInitialize(A0);
 
-  //HYPRE_StructVectorCreate(MPI_COMM_WORLD, hgrid, stencil, &b);
-  //HYPRE_StructVectorCreate(MPI_COMM_WORLD, hgrid, stencil, &x);
-  HYPRE_StructVectorCreate(MPI_COMM_WORLD, hgrid, &b);
-  HYPRE_StructVectorCreate(MPI_COMM_WORLD, hgrid, &x);
+  //HYPRE_StructVectorCreate(comm, hgrid, stencil, &b);
+  //HYPRE_StructVectorCreate(comm, hgrid, stencil, &x);
+  HYPRE_StructVectorCreate(comm, hgrid, &b);
+  HYPRE_StructVectorCreate(comm, hgrid, &x);
 
   HYPRE_StructStencilDestroy(stencil); // no longer needed
 
   HYPRE_StructVectorInitialize(b);
   HYPRE_StructVectorInitialize(x);
-
-  int ncomp=1;
-  int ngrow=0;
-  acoefs.reset(new MultiFab(grids, dmap, ncomp, ngrow));
-  acoefs->setVal(0.0);
- 
-  for (i = 0; i < BL_SPACEDIM; i++) {
-    BoxArray edge_boxes(grids);
-    edge_boxes.surroundingNodes(i);
-    bcoefs[i].reset(new MultiFab(edge_boxes, dmap, ncomp, ngrow));
-  }
 }
 
 HypreABec::~HypreABec()
 {
+  clearSolver();
+
+  if (comm == MPI_COMM_NULL) {
+    return;
+  }
+
   HYPRE_StructVectorDestroy(b);
   HYPRE_StructVectorDestroy(x);
 
@@ -232,37 +235,6 @@ HypreABec::~HypreABec()
   HYPRE_StructGridDestroy(hgrid);
 }
 
-void HypreABec::setScalars(Real Alpha, Real Beta)
-{
-  alpha = Alpha;
-  beta  = Beta;
-}
-
-void HypreABec::aCoefficients(const MultiFab &a)
-{
-  BL_ASSERT( a.ok() );
-  BL_ASSERT( a.boxArray() == acoefs->boxArray() );
-  MultiFab::Copy(*acoefs, a, 0, 0, 1, 0);
-}
- 
-void HypreABec::bCoefficients(const MultiFab &b, int dir)
-{
-  BL_ASSERT( b.ok() );
-  BL_ASSERT( b.boxArray() == bcoefs[dir]->boxArray() );
-  MultiFab::Copy(*bcoefs[dir], b, 0, 0, 1, 0);
-}
-
-void HypreABec::SPalpha(const MultiFab& a)
-{
-  BL_ASSERT( a.ok() );
-  if (SPa == 0) {
-    const BoxArray& grids = a.boxArray(); 
-    const DistributionMapping& dmap = a.DistributionMap();
-    SPa.reset(new MultiFab(grids,dmap,1,0));
-  }
-  MultiFab::Copy(*SPa, a, 0, 0, 1, 0);
-}
-
 void HypreABec::apply(MultiFab& product, MultiFab& vector, int icomp,
                       BC_Mode inhom)
 {
@@ -273,7 +245,7 @@ void HypreABec::apply(MultiFab& product, MultiFab& vector, int icomp,
   BL_ASSERT(product.nGrow() == 0); // need a temporary if this is false
 
   const int size = BL_SPACEDIM + 1;
-  int i, idim;
+  int i;
 
   int stencil_indices[size];
 
@@ -281,10 +253,8 @@ void HypreABec::apply(MultiFab& product, MultiFab& vector, int icomp,
     stencil_indices[i] = i;
   }
 
-  Vector<Real> r;
-  Real foo=1.e200;
-
-  Real *mat, *vec;
+  Vector<Real> mat;
+  Real *vec;
   FArrayBox fnew;
   for (MFIter vi(vector); vi.isValid(); ++vi) {
     i = vi.index();
@@ -313,85 +283,10 @@ void HypreABec::apply(MultiFab& product, MultiFab& vector, int icomp,
     product[vi].setVal(0.0);
     vec = product[vi].dataPtr();
 
-    int volume = reg.numPts();
-    mat = hypre_CTAlloc(double, size*volume);
-
-    // build matrix interior
-
-    hacoef(mat, 
-	   BL_TO_FORTRAN((*acoefs)[vi]),
-	   ARLIM(reg.loVect()), ARLIM(reg.hiVect()), alpha);
-
-    for (idim = 0; idim < BL_SPACEDIM; idim++) {
-      hbcoef(mat,
-	     BL_TO_FORTRAN((*bcoefs[idim])[vi]),
-	     ARLIM(reg.loVect()), ARLIM(reg.hiVect()), beta, dx, idim);
-    }
+    buildMatrix(vi, mat);
 
-    // add b.c.'s to matrix diagonal and product (otherwise zero), and
-    // zero out offdiag values at low domain boundaries (high done by symmetry)
-
-    const NGBndry& bd = getBndry();
-    const Box& domain = bd.getDomain();
-    for (OrientationIter oitr; oitr; oitr++) {
-      int cdir(oitr());
-      idim = oitr().coordDir();
-      const RadBoundCond &bct = bd.bndryConds(oitr())[i];
-      const Real      &bcl = bd.bndryLocs(oitr())[i];
-      const Mask      &msk = bd.bndryMasks(oitr(),i);
-
-      if (reg[oitr()] == domain[oitr()]) {
-        const int *tfp = NULL;
-        int bctype = bct;
-        if (bd.mixedBndry(oitr())) {
-          const BaseFab<int> &tf = *(bd.bndryTypes(oitr())[i]);
-          tfp = tf.dataPtr();
-          bctype = -1;
-        }
-	const FArrayBox &fs  = bd.bndryValues(oitr())[vi];
-	Real* pSPa;
-	Box SPabox; 
-	if (SPa != 0) {
-	  pSPa = (*SPa)[vi].dataPtr();
-	  SPabox = (*SPa)[vi].box();
-	}
-	else {
-	  pSPa = &foo;
-	  SPabox = Box(IntVect::TheZeroVector(),IntVect::TheZeroVector());
-	}
-        getFaceMetric(r, reg, oitr(), geom);
-	hbmat3(mat, ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
-	       cdir, bctype, tfp, bcl,
-	       ARLIM(fs.loVect()), ARLIM(fs.hiVect()),
-	       BL_TO_FORTRAN(msk),
-	       BL_TO_FORTRAN((*bcoefs[idim])[vi]),
-	       beta, dx, flux_factor, r.dataPtr(),
-	       pSPa, ARLIM(SPabox.loVect()), ARLIM(SPabox.hiVect()));
-	if (inhom) {
-	  hbvec3(vec, ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
-		 cdir, bctype, tfp, bho, bcl,
-		 BL_TO_FORTRAN_N(fs, bdcomp),
-		 BL_TO_FORTRAN(msk),
-		 BL_TO_FORTRAN((*bcoefs[idim])[vi]),
-		 beta, dx, r.dataPtr());
-	}
-      }
-      else {
-	hbmat(mat, ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
-	      cdir, bct, bcl,
-	      BL_TO_FORTRAN(msk),
-	      BL_TO_FORTRAN((*bcoefs[idim])[vi]),
-	      beta, dx);
-	if (inhom) {
-	  const FArrayBox &fs  = bd.bndryValues(oitr())[vi];
-	  hbvec(vec, ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
-		cdir, bct, bho, bcl,
-		BL_TO_FORTRAN_N(fs, bdcomp),
-		BL_TO_FORTRAN(msk),
-		BL_TO_FORTRAN((*bcoefs[idim])[vi]),
-		beta, dx);
-	}
-      }
+    if (inhom) {
+      addBoundaryRhs(vi, vec);
     }
 
     // initialize product
@@ -402,9 +297,7 @@ void HypreABec::apply(MultiFab& product, MultiFab& vector, int icomp,
     // initialize matrix
 
     HYPRE_StructMatrixSetBoxValues(A0, loV(reg), hiV(reg),
-				   size, stencil_indices, mat);
-
-    hypre_TFree(mat);
+				   size, stencil_indices, mat.dataPtr());
   }
 
   HYPRE_StructMatrixAssemble(A0);
@@ -432,124 +325,73 @@ void HypreABec::apply(MultiFab& product, MultiFab& vector, int icomp,
   }
 }
 
-void HypreABec::boundaryFlux(MultiFab* Flux, MultiFab& Soln, int icomp,
-                             BC_Mode inhom)
+void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
 {
-    BL_PROFILE("HypreABec::boundaryFlux");
-    
-    const BoxArray &grids = Soln.boxArray();
-    
-    const NGBndry& bd = getBndry();
-    const Box& domain = bd.getDomain();
-    
-#ifdef _OPENMP
-#pragma omp parallel
-#endif
-    {
-	Vector<Real> r;
-	Real foo=1.e200;
-	
-	for (MFIter si(Soln); si.isValid(); ++si) {
-	    int i = si.index();
-	    const Box &reg = grids[i];
-	    for (OrientationIter oitr; oitr; oitr++) {
-		int cdir(oitr());
-		int idim = oitr().coordDir();
-		const RadBoundCond &bct = bd.bndryConds(oitr())[i];
-		const Real      &bcl = bd.bndryLocs(oitr())[i];
-		const FArrayBox       &fs  = bd.bndryValues(oitr())[si];
-		const Mask      &msk = bd.bndryMasks(oitr(),i);
-
-		if (reg[oitr()] == domain[oitr()]) {
-		    const int *tfp = NULL;
-		    int bctype = bct;
-		    if (bd.mixedBndry(oitr())) {
-			const BaseFab<int> &tf = *(bd.bndryTypes(oitr())[i]);
-			tfp = tf.dataPtr();
-			bctype = -1;
-		    }
-		    // In normal code operation only the fluxes at internal
-		    // Dirichlet boundaries are used.  Some diagnostics use the
-		    // fluxes computed at domain boundaries but these do not
-		    // influence the evolution of the interior solution.
-		    Real* pSPa;
-		    Box SPabox; 
-		    if (SPa != 0) {
-			pSPa = (*SPa)[si].dataPtr();
-			SPabox = (*SPa)[si].box();
-		    }
-		    else {
-			pSPa = &foo;
-			SPabox = Box(IntVect::TheZeroVector(),IntVect::TheZeroVector());
-		    }
-		    getFaceMetric(r, reg, oitr(), geom);
-		    hbflx3(BL_TO_FORTRAN(Flux[idim][si]),
-			   BL_TO_FORTRAN_N(Soln[si], icomp),
-			   ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
-			   cdir, bctype, tfp, bho, bcl,
-			   BL_TO_FORTRAN_N(fs, bdcomp),
-			   BL_TO_FORTRAN(msk),
-			   BL_TO_FORTRAN((*bcoefs[idim])[si]),
-			   beta, dx, flux_factor, r.dataPtr(), inhom,
-			   pSPa, ARLIM(SPabox.loVect()), ARLIM(SPabox.hiVect()));
-		}
-		else {
-		    hbflx(BL_TO_FORTRAN(Flux[idim][si]),
-			  BL_TO_FORTRAN_N(Soln[si], icomp),
-			  ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
-			  cdir, bct, bho, bcl,
-			  BL_TO_FORTRAN_N(fs, bdcomp),
-			  BL_TO_FORTRAN(msk),
-			  BL_TO_FORTRAN((*bcoefs[idim])[si]),
-			  beta, dx, inhom);
-		}
-	    }
-	}
-    }
-}
+  BL_PROFILE("HypreABec::setupSolver");
 
-void HypreABec::getFaceMetric(Vector<Real>& r,
-                              const Box& reg,
-                              const Orientation& ori,
-                              const Geometry& geom)
-{
-  if (ori.coordDir() == 0) {
-    if (Geometry::IsCartesian()) {
-      r.resize(1, 1.0);
-    }
-    else { // RZ or Spherical
-      r.resize(1);
-      if (ori.isLow()) {
-        r[0] = geom.LoEdge(reg.smallEnd(0), 0);
-      }
-      else {
-        r[0] = geom.HiEdge(reg.bigEnd(0), 0);
-      }
-      if (Geometry::IsSPHERICAL()) {
-        r[0] *= r[0];
-      }
-    }
+  // The matrix values are always reloaded.  If a solver set up for the
+  // same group is still alive and the matrix has changed little since
+  // its hierarchy was built, that setup is kept as it is: the solve
+  // still uses the new fine-level operator, only the coarse-level
+  // operators are stale.  A new reltol does not need a new setup,
+  // since solve sets the tolerance of a reused solver.  Each group is
+  // compared with its own setup, since one solver serves several
+  // groups whose operators differ (by their opacities) far more than
+  // one group's does from one iteration to the next.
+
+  reltol = _reltol;
+  abstol = _abstol; // may be used to change tolerance for solve
+
+  if (setup_reuse_tol < 0.0) {
+    loadMatrix(0);
+    clearSolver();
   }
   else {
-    if (Geometry::IsCartesian()) {
-      r.resize(reg.length(0), 1.0);
+    auto it = group_setup.find(setup_group);
+    Real dmat = loadMatrix((it == group_setup.end()) ? 0 : &it->second.mat);
+
+    if (it != group_setup.end()) {
+      GroupSetup& g = it->second;
+      if (dmat <= setup_reuse_tol && maxiter == g.maxiter) {
+        solver = g.solver;
+        precond = g.precond;
+        solver_ready = 1;
+        num_setup_reuses++;
+        return;
+      }
+      destroySolver(g.solver, g.precond);
+      group_setup.erase(it);
     }
-    else { // RZ
-      // We only support spherical coordinates in 1D
-      BL_ASSERT(Geometry::IsRZ());
-      geom.GetCellLoc(r, reg, 0);
+  }
+
+  Real strt_time = ParallelDescriptor::second();
+
+  createSolver(maxiter);
+
+  setup_time += ParallelDescriptor::second() - strt_time;
+  num_setups++;
+
+  if (setup_reuse_tol >= 0.0) {
+    // remember this hierarchy and the matrix it was built for
+    GroupSetup& g = group_setup[setup_group];
+    g.solver = solver;
+    g.precond = precond;
+    g.maxiter = maxiter;
+    g.mat.resize(acoefs->local_size());
+    for (MFIter ai(*acoefs); ai.isValid(); ++ai) {
+      buildMatrix(ai, g.mat[ai.LocalIndex()]);
     }
   }
 }
 
-void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
+Real HypreABec::loadMatrix(const Vector<Vector<Real> >* mat_setup)
 {
-  BL_PROFILE("HypreABec::setupSolver");
+  BL_PROFILE("HypreABec::loadMatrix");
 
   const BoxArray& grids = acoefs->boxArray();
 
   const int size = BL_SPACEDIM + 1;
-  int i, idim;
+  int i;
 
   int stencil_indices[size];
 
@@ -557,89 +399,52 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
     stencil_indices[i] = i;
   }
 
-  Vector<Real> r;
-  Real foo=1.e200;
+  // max change of the matrix entries since the setup, and max entry
+  Real dmat[2] = { 0.0, 0.0 };
 
-  Real *mat;
+  Vector<Real> mat;
   for (MFIter ai(*acoefs); ai.isValid(); ++ai) {
     i = ai.index();
     const Box &reg = grids[i];
 
-    int volume = reg.numPts();
-    mat = hypre_CTAlloc(double, size*volume);
-
-    // build matrix interior
+    buildMatrix(ai, mat);
 
-    hacoef(mat, 
-	   BL_TO_FORTRAN((*acoefs)[ai]),
-	   ARLIM(reg.loVect()), ARLIM(reg.hiVect()), alpha);
-
-    for (idim = 0; idim < BL_SPACEDIM; idim++) {
-      hbcoef(mat,
-	     BL_TO_FORTRAN((*bcoefs[idim])[ai]),
-	     ARLIM(reg.loVect()), ARLIM(reg.hiVect()), beta, dx, idim);
-    }
+    // initialize matrix
 
-    // add b.c.'s to matrix diagonal, and
-    // zero out offdiag values at low domain boundaries (high done by symmetry)
-
-    const NGBndry& bd = getBndry();
-    const Box& domain = bd.getDomain();
-    for (OrientationIter oitr; oitr; oitr++) {
-      int cdir(oitr());
-      idim = oitr().coordDir();
-      const RadBoundCond &bct = bd.bndryConds(oitr())[i];
-      const Real      &bcl = bd.bndryLocs(oitr())[i];
-      const Mask      &msk = bd.bndryMasks(oitr(),i);
-      const Box &bbox = (*bcoefs[idim])[ai].box();
-      const Box &msb  = msk.box();
-      if (reg[oitr()] == domain[oitr()]) {
-        const int *tfp = NULL;
-        int bctype = bct;
-        if (bd.mixedBndry(oitr())) {
-          const BaseFab<int> &tf = *(bd.bndryTypes(oitr())[i]);
-          tfp = tf.dataPtr();
-          bctype = -1;
+    HYPRE_StructMatrixSetBoxValues(A, loV(reg), hiV(reg),
+                                   size, stencil_indices, mat.dataPtr());
+
+    if (mat_setup) {
+      const Vector<Real>& msetup = (*mat_setup)[ai.LocalIndex()];
+      const int nmat = mat.size();
+      if (msetup.size() == nmat) {
+        for (int n = 0; n < nmat; n++) {
+          dmat[0] = std::max(dmat[0], std::abs(mat[n] - msetup[n]));
+          dmat[1] = std::max(dmat[1], std::abs(msetup[n]));
         }
-        const Box &fsb = bd.bndryValues(oitr())[ai].box();
-	Real* pSPa;
-	Box SPabox; 
-	if (SPa != 0) {
-	  pSPa = (*SPa)[ai].dataPtr();
-	  SPabox = (*SPa)[ai].box();
-	}
-	else {
-	  pSPa = &foo;
-	  SPabox = Box(IntVect::TheZeroVector(),IntVect::TheZeroVector());
-	}
-        getFaceMetric(r, reg, oitr(), geom);
-	hbmat3(mat, ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
-	       cdir, bctype, tfp, bcl,
-	       ARLIM(fsb.loVect()), ARLIM(fsb.hiVect()),
-	       BL_TO_FORTRAN(msk), 
-	       BL_TO_FORTRAN((*bcoefs[idim])[ai]),
-	       beta, dx, flux_factor, r.dataPtr(),
-	       pSPa, ARLIM(SPabox.loVect()), ARLIM(SPabox.hiVect()));
       }
       else {
-	hbmat(mat, ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
-	      cdir, bct, bcl,
-	      BL_TO_FORTRAN(msk),
-	      BL_TO_FORTRAN((*bcoefs[idim])[ai]),
-	      beta, dx);
+        dmat[0] = 1.e200;
       }
     }
+  }
 
-    // initialize matrix
-
-    HYPRE_StructMatrixSetBoxValues(A, loV(reg), hiV(reg),
-				   size, stencil_indices, mat);
+  HYPRE_StructMatrixAssemble(A);
 
-    hypre_TFree(mat);
+  if (!mat_setup) {
+    return 1.e200;
   }
 
-  HYPRE_StructMatrixAssemble(A);
+  // only the processors of this solver get here
+  MPI_Allreduce(MPI_IN_PLACE, dmat, 2, MPI_DOUBLE, MPI_MAX, comm);
+
+  return (dmat[1] > 0.0) ? dmat[0] / dmat[1] : dmat[0];
+}
+
 
+void HypreABec::createSolver(int maxiter)
+{
+  BL_PROFILE("HypreABec::createSolver");
 
 #if 0
   HYPRE_StructMatrixPrint("mat", A, 1);
@@ -652,11 +457,8 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
   HYPRE_StructVectorAssemble(b); // currently a no-op
   HYPRE_StructVectorAssemble(x); // currently a no-op
 
-  reltol = _reltol;
-  abstol = _abstol; // may be used to change tolerance for solve
-
   if (solver_flag == 0) {
-    HYPRE_StructSMGCreate(MPI_COMM_WORLD, &solver);
+    HYPRE_StructSMGCreate(comm, &solver);
     HYPRE_StructSMGSetMemoryUse(solver, 0);
     HYPRE_StructSMGSetMaxIter(solver, maxiter);
     HYPRE_StructSMGSetRelChange(solver, 0);
@@ -667,7 +469,7 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
     HYPRE_StructSMGSetup(solver, A, b, x);
   }
   else if (solver_flag == 1) {
-    HYPRE_StructPFMGCreate(MPI_COMM_WORLD, &solver);
+    HYPRE_StructPFMGCreate(comm, &solver);
     //HYPRE_StructPFMGSetMemoryUse(solver, 0);
     HYPRE_StructPFMGSetSkipRelax(solver, 0);
     HYPRE_StructPFMGSetMaxIter(solver, maxiter);
@@ -682,7 +484,7 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
     HYPRE_StructPFMGSetup(solver, A, b, x);
   }
   else if (solver_flag == 2) {
-    HYPRE_StructJacobiCreate(MPI_COMM_WORLD, &solver);
+    HYPRE_StructJacobiCreate(comm, &solver);
     //HYPRE_StructPFMGSetMemoryUse(solver, 0);
     //HYPRE_StructPFMGSetSkipRelax(solver, 0);
     HYPRE_StructJacobiSetMaxIter(solver, maxiter);
@@ -694,14 +496,14 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
     HYPRE_StructJacobiSetup(solver, A, b, x);
   }
   else if (solver_flag == 3 || solver_flag == 4) {
-    HYPRE_StructPCGCreate(MPI_COMM_WORLD, &solver);
+    HYPRE_StructPCGCreate(comm, &solver);
     HYPRE_StructPCGSetMaxIter(solver, maxiter);
     HYPRE_StructPCGSetRelChange(solver, 0);
     HYPRE_StructPCGSetTol(solver, reltol);
 
     if (solver_flag == 3) {
 // pfmg pre-conditioned cg
-      HYPRE_StructPFMGCreate(MPI_COMM_WORLD, &precond);
+      HYPRE_StructPFMGCreate(comm, &precond);
       HYPRE_StructPFMGSetMaxIter(precond, 1);
       HYPRE_StructPFMGSetTol(precond, 0.0);
       HYPRE_StructPFMGSetZeroGuess(precond);
@@ -717,7 +519,7 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
                                 precond);
     }
     else if (solver_flag == 4) {
-      HYPRE_StructSMGCreate(MPI_COMM_WORLD, &precond);
+      HYPRE_StructSMGCreate(comm, &precond);
       HYPRE_StructSMGSetMemoryUse(precond, 0);
       HYPRE_StructSMGSetMaxIter(precond, 1);
       HYPRE_StructSMGSetRelChange(precond, 0);
@@ -733,7 +535,7 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
 
 #if 0
 //  jacobi as pre-conditioner for cg
-    HYPRE_StructJacobiCreate(MPI_COMM_WORLD, &precond);
+    HYPRE_StructJacobiCreate(comm, &precond);
     HYPRE_StructJacobiSetMaxIter(precond, 2);
     HYPRE_StructJacobiSetTol(precond, 0.0);
     HYPRE_StructJacobiSetZeroGuess(precond);
@@ -747,7 +549,7 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
     HYPRE_StructPCGSetup(solver, A, b, x);
   }  
   else if (solver_flag == 5 || solver_flag == 6) {
-    HYPRE_StructHybridCreate(MPI_COMM_WORLD, &solver);
+    HYPRE_StructHybridCreate(comm, &solver);
     HYPRE_StructHybridSetDSCGMaxIter(solver, maxiter);
     HYPRE_StructHybridSetPCGMaxIter(solver, maxiter);
     HYPRE_StructHybridSetTol(solver, reltol);
@@ -759,7 +561,7 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
 
     /* pfmg preconditioning */
     if (solver_flag == 5) {
-      HYPRE_StructPFMGCreate(MPI_COMM_WORLD, &precond);
+      HYPRE_StructPFMGCreate(comm, &precond);
       HYPRE_StructPFMGSetMaxIter(precond, 1);
       HYPRE_StructPFMGSetTol(precond, 0.0);
       HYPRE_StructPFMGSetZeroGuess(precond);
@@ -775,7 +577,7 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
                                    precond);
     }
     else if (solver_flag == 6) {
-      HYPRE_StructSMGCreate(MPI_COMM_WORLD, &precond);
+      HYPRE_StructSMGCreate(comm, &precond);
       HYPRE_StructSMGSetMemoryUse(precond, 0);
       HYPRE_StructSMGSetMaxIter(precond, 1);
       HYPRE_StructSMGSetRelChange(precond, 0);
@@ -795,39 +597,56 @@ void HypreABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
     std::cout << "HypreABec: no such solver" << std::endl;
     exit(1);
   }
+
+  solver_ready = 1;
 }
 
 void HypreABec::clearSolver()
 {
   BL_PROFILE("HypreABec::clearSolver");
 
+  // With kept setups the current solver is one of them.
+  if (!group_setup.empty()) {
+    for (auto& g : group_setup) {
+      destroySolver(g.second.solver, g.second.precond);
+    }
+    group_setup.clear();
+  }
+  else if (solver_ready) {
+    destroySolver(solver, precond);
+  }
+  solver_ready = 0;
+}
+
+void HypreABec::destroySolver(HYPRE_StructSolver& s, HYPRE_StructSolver& p)
+{
   if (solver_flag == 0) {
-    HYPRE_StructSMGDestroy(solver);
+    HYPRE_StructSMGDestroy(s);
   }
   else if (solver_flag == 1) {
-    HYPRE_StructPFMGDestroy(solver);
+    HYPRE_StructPFMGDestroy(s);
   }
   else if(solver_flag == 2) {
-    HYPRE_StructJacobiDestroy(solver);
+    HYPRE_StructJacobiDestroy(s);
   }
   else if(solver_flag == 3 || solver_flag == 4) {
-    HYPRE_StructPCGDestroy(solver);
+    HYPRE_StructPCGDestroy(s);
     if (solver_flag == 3)
     {
-       HYPRE_StructPFMGDestroy(precond);
+       HYPRE_StructPFMGDestroy(p);
     }
     else if (solver_flag == 4)
     {
-       HYPRE_StructSMGDestroy(precond);
+       HYPRE_StructSMGDestroy(p);
     }
   }
   else if(solver_flag == 5 || solver_flag == 6) {
-    HYPRE_StructHybridDestroy(solver);
+    HYPRE_StructHybridDestroy(s);
     if(solver_flag == 5) {
-       HYPRE_StructPFMGDestroy(precond);
+       HYPRE_StructPFMGDestroy(p);
     }
     if(solver_flag == 6) {
-       HYPRE_StructSMGDestroy(precond);
+       HYPRE_StructSMGDestroy(p);
     }
   }
 }
@@ -838,12 +657,10 @@ void HypreABec::solve(MultiFab& dest, int icomp, MultiFab& rhs, BC_Mode inhom)
 
   const BoxArray& grids = dest.boxArray();
 
-  int i, idim;
+  int i;
 
   //dest.setVal(0.0);
 
-  Vector<Real> r;
-
   Real *vec;
   FArrayBox fnew;
   for (MFIter di(dest); di.isValid(); ++di) {
@@ -873,42 +690,7 @@ void HypreABec::solve(MultiFab& dest, int icomp, MultiFab& rhs, BC_Mode inhom)
     // add b.c.'s to rhs
 
     if (inhom) {
-      const NGBndry& bd = getBndry();
-      const Box& domain = bd.getDomain();
-      for (OrientationIter oitr; oitr; oitr++) {
-	int cdir(oitr());
-	idim = oitr().coordDir();
-	const RadBoundCond &bct = bd.bndryConds(oitr())[i];
-	const Real      &bcl = bd.bndryLocs(oitr())[i];
-	const FArrayBox       &fs  = bd.bndryValues(oitr())[di];
-	const Mask      &msk = bd.bndryMasks(oitr(),i);
-	const Box &bbox = (*bcoefs[idim])[di].box();
-
-        if (reg[oitr()] == domain[oitr()]) {
-          const int *tfp = NULL;
-          int bctype = bct;
-          if (bd.mixedBndry(oitr())) {
-            const BaseFab<int> &tf = *(bd.bndryTypes(oitr())[i]);
-            tfp = tf.dataPtr();
-            bctype = -1;
-          }
-          getFaceMetric(r, reg, oitr(), geom);
-	  hbvec3(vec, ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
-		 cdir, bctype, tfp, bho, bcl,
-		 BL_TO_FORTRAN_N(fs, bdcomp),
-		 BL_TO_FORTRAN(msk),
-		 BL_TO_FORTRAN((*bcoefs[idim])[di]),
-		 beta, dx, r.dataPtr());
-	}
-	else {
-	  hbvec(vec, ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
-		cdir, bct, bho, bcl,
-		BL_TO_FORTRAN_N(fs, bdcomp),
-		BL_TO_FORTRAN(msk),
-		BL_TO_FORTRAN((*bcoefs[idim])[di]),
-		beta, dx);
-	}
-      }
+      addBoundaryRhs(di, vec);
     }
 
     // initialize rhs
@@ -919,6 +701,8 @@ void HypreABec::solve(MultiFab& dest, int icomp, MultiFab& rhs, BC_Mode inhom)
   HYPRE_StructVectorAssemble(b); // currently a no-op
   HYPRE_StructVectorAssemble(x); // currently a no-op
 
+  Real reltol_new = reltol;
+
   if (abstol > 0.0) {
     Real bnorm;
     bnorm = hypre_StructInnerProd((hypre_StructVector *) b,
@@ -931,23 +715,26 @@ void HypreABec::solve(MultiFab& dest, int icomp, MultiFab& rhs, BC_Mode inhom)
       volume += grids[i].numPts();
     }
 
-    Real reltol_new = (bnorm > 0.0
-		       ? abstol / bnorm * sqrt(volume)
-		       : reltol);
+    if (bnorm > 0.0) {
+      reltol_new = std::max(reltol, abstol / bnorm * sqrt(volume));
+    }
+  }
 
-    if (reltol_new > reltol) {
-      if (solver_flag == 0) {
-	HYPRE_StructSMGSetTol(solver, reltol_new);
-      }
-      else if(solver_flag == 1) {
-	HYPRE_StructPFMGSetTol(solver, reltol_new);
-      }
-      else if(solver_flag == 2) {
-	// nothing for this option
-      }
-      else if(solver_flag == 3 || solver_flag == 4) {
-	HYPRE_StructPCGSetTol(solver, reltol_new);
-      }
+  // With a reused setup the tolerance the solver was set up with, or
+  // that of the previous solve, may still be in effect, so it is always
+  // reset here.
+  if (reltol_new > reltol || setup_reuse_tol >= 0.0) {
+    if (solver_flag == 0) {
+      HYPRE_StructSMGSetTol(solver, reltol_new);
+    }
+    else if(solver_flag == 1) {
+      HYPRE_StructPFMGSetTol(solver, reltol_new);
+    }
+    else if(solver_flag == 2) {
+      // nothing for this option
+    }
+    else if(solver_flag == 3 || solver_flag == 4) {
+      HYPRE_StructPCGSetTol(solver, reltol_new);
     }
   }
 
@@ -995,9 +782,9 @@ void HypreABec::solve(MultiFab& dest, int icomp, MultiFab& rhs, BC_Mode inhom)
     }
   }
 
-  if (verbose >= 2 && ParallelDescriptor::IOProcessor()) {
-    int num_iterations;
-    Real res;
+  {
+    int num_iterations = 0;
+    Real res = 0.0;
     if (solver_flag == 0) {
       HYPRE_StructSMGGetNumIterations(solver, &num_iterations);
       HYPRE_StructSMGGetFinalRelativeResidualNorm(solver, &res);
@@ -1018,7 +805,11 @@ void HypreABec::solve(MultiFab& dest, int icomp, MultiFab& rhs, BC_Mode inhom)
       HYPRE_StructHybridGetNumIterations(solver, &num_iterations);
       HYPRE_StructHybridGetFinalRelativeResidualNorm(solver, &res);
     }
-    if (num_iterations >= verbose_threshold) {
+
+    num_iterations_last = num_iterations;
+
+    if (verbose >= 2 && ParallelDescriptor::IOProcessor() &&
+        num_iterations >= verbose_threshold) {
       int oldprec = std::cout.precision(20);
       std::cout << num_iterations
            << " Hypre Multigrid Iterations, Relative Residual "
@@ -1032,6 +823,12 @@ Real HypreABec::getAbsoluteResidual()
 {
   BL_PROFILE("HypreABec::getAbsoluteResidual");
 
+  const BoxArray& grids = acoefs->boxArray();
+  Real volume = 0.0;
+  for (int i = 0; i < grids.size(); i++) {
+    volume += grids[i].numPts();
+  }
+
   Real bnorm;
   bnorm = hypre_StructInnerProd((hypre_StructVector *) b,
 				(hypre_StructVector *) b);
@@ -1054,11 +851,5 @@ Real HypreABec::getAbsoluteResidual()
     HYPRE_StructHybridGetFinalRelativeResidualNorm(solver, &res);
   }
 
-  const BoxArray& grids = acoefs->boxArray();
-  Real volume = 0.0;
-  for (int i = 0; i < grids.size(); i++) {
-    volume += grids[i].numPts();
-  }
-
   return bnorm * res / sqrt(volume);
 }
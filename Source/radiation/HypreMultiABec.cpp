@@ -624,6 +624,7 @@ HypreMultiABec::HypreMultiABec(int _crse_level, int _fine_level,
   verbose = 1;       pp.query("v", verbose); pp.query("verbose", verbose);
   verbose_threshold = 0; pp.query("verbose_threshold", verbose_threshold);
   bho = 0;           pp.query("bho", bho);
+  num_iterations_last = 0;
   use_subgrids = 0;  pp.query("use_subgrids", use_subgrids);
 
   static int first = 1;
@@ -2890,9 +2891,9 @@ void HypreMultiABec::solve()
 
   HYPRE_SStructVectorGather(x);
 
-  if (verbose >= 2 && ParallelDescriptor::IOProcessor()) {
-    int num_iterations;
-    Real res;
+  {
+    int num_iterations = 0;
+    Real res = 0.0;
     if (solver_flag == 100) {
       HYPRE_BoomerAMGGetNumIterations(solver, &num_iterations);
       HYPRE_BoomerAMGGetFinalRelativeResidualNorm(solver, &res);
@@ -2957,7 +2958,10 @@ void HypreMultiABec::solve()
       HYPRE_PCGGetFinalRelativeResidualNorm(solver, &res);
     }
 
-    if (num_iterations >= verbose_threshold) {
+    num_iterations_last = num_iterations;
+
+    if (verbose >= 2 && ParallelDescriptor::IOProcessor() &&
+        num_iterations >= verbose_threshold) {
       int oldprec = std::cout.precision(20);
       if (Radiation::current_group_number >= 0) {
 	std::cout << Radiation::current_group_name << " Group "
@@ -458,6 +458,75 @@ void Radiation::eos_opacity_emissivity(const MultiFab& S_new,
 }
 
 
+// B and C coefficients of a gray equation: the diffusion coefficients
+// of the groups summed with the weights in spec, which needs one ghost
+// cell.
+
+void Radiation::gray_bccoefs(MultiFab& spec, MultiFab& kappa_r,
+			     Tuple<MultiFab, BL_SPACEDIM>& lambda,
+			     RadSolve& solver, int level)
+{
+  const Geometry& geom = parent->Geom(level);
+  const Real* dx = geom.CellSize();
+  const Castro *castro = dynamic_cast<Castro*>(&parent->getLevel(level));
+  const DistributionMapping& dm = castro->DistributionMap();
+
+  Tuple<MultiFab, BL_SPACEDIM> bcoefs, ccoefs, bcgrp;
+  for (int idim = 0; idim < BL_SPACEDIM; idim++) {
+    const BoxArray& edge_boxes = castro->getEdgeBoxArray(idim);
+
+    bcoefs[idim].define(edge_boxes, dm, 1, 0);
+    bcoefs[idim].setVal(0.0);
+
+    bcgrp [idim].define(edge_boxes, dm, 1, 0);
+
+    if (nGroups > 1) {
+	ccoefs[idim].define(edge_boxes, dm, 2, 0);
+	ccoefs[idim].setVal(0.0);
+    }
+  }
+
+  for (int igroup = 0; igroup < nGroups; igroup++) {
+    for (int idim=0; idim<BL_SPACEDIM; idim++) {
+      solver.computeBCoeffs(bcgrp[idim], idim, kappa_r, igroup,
+			    lambda[idim], igroup, c, geom);
+      // metrics is already in bcgrp
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+      for (MFIter mfi(spec,true); mfi.isValid(); ++mfi) {
+	  const Box&  bx  = mfi.nodaltilebox(idim);
+	  const Box& bbox = bcoefs[idim][mfi].box();
+
+	  lbcoefna(bcoefs[idim][mfi].dataPtr(),
+		   bcgrp[idim][mfi].dataPtr(),
+		   ARLIM(bbox.loVect()), ARLIM(bbox.hiVect()),
+		   ARLIM(bx.loVect()), ARLIM(bx.hiVect()),
+		   BL_TO_FORTRAN_N(spec[mfi], igroup), 
+		   idim);
+	  
+	  if (nGroups > 1) {
+	      BL_FORT_PROC_CALL(CA_ACCEL_CCOE, ca_accel_ccoe)
+		  (bx.loVect(), bx.hiVect(),
+		   BL_TO_FORTRAN(bcgrp[idim][mfi]),
+		   BL_TO_FORTRAN(spec[mfi]),
+		   BL_TO_FORTRAN(ccoefs[idim][mfi]),
+		   dx, &idim, &igroup);
+	  }
+      }
+    }
+  }
+
+  for (int idim = 0; idim < BL_SPACEDIM; idim++) {
+    solver.setLevelBCoeffs(level, bcoefs[idim], idim);
+
+    if (nGroups > 1) {
+      solver.setLevelCCoeffs(level, ccoefs[idim], idim);
+    }
+  }
+}
+
 void Radiation::gray_accel(MultiFab& Er_new, MultiFab& Er_pi, 
 			   MultiFab& kappa_p, MultiFab& kappa_r,
 			   MultiFab& etaT, MultiFab& etaY, MultiFab& eta1,
@@ -468,8 +537,6 @@ void Radiation::gray_accel(MultiFab& Er_new, MultiFab& Er_pi,
 			   const BoxArray& grids, int level, Real time, 
 			   Real delta_t, Real ptc_tau)
 {
-  const Geometry& geom = parent->Geom(level);
-  const Real* dx = parent->Geom(level).CellSize();
   const Castro *castro = dynamic_cast<Castro*>(&parent->getLevel(level));
   const DistributionMapping& dmap = castro->DistributionMap();
 
@@ -557,63 +624,8 @@ void Radiation::gray_accel(MultiFab& Er_new, MultiFab& Er_pi,
   solver.cellCenteredApplyMetrics(level, acoefs);
   solver.setLevelACoeffs(level, acoefs);
 
-  const DistributionMapping& dm = castro->DistributionMap();
-
   // B & C coefficients
-  Tuple<MultiFab, BL_SPACEDIM> bcoefs, ccoefs, bcgrp;
-  for (int idim = 0; idim < BL_SPACEDIM; idim++) {
-    const BoxArray& edge_boxes = castro->getEdgeBoxArray(idim);
-
-    bcoefs[idim].define(edge_boxes, dm, 1, 0);
-    bcoefs[idim].setVal(0.0);
-
-    bcgrp [idim].define(edge_boxes, dm, 1, 0);
-
-    if (nGroups > 1) {
-	ccoefs[idim].define(edge_boxes, dm, 2, 0);
-	ccoefs[idim].setVal(0.0);
-    }
-  }
-
-  for (int igroup = 0; igroup < nGroups; igroup++) {
-    for (int idim=0; idim<BL_SPACEDIM; idim++) {
-      solver.computeBCoeffs(bcgrp[idim], idim, kappa_r, igroup,
-			    lambda[idim], igroup, c, geom);
-      // metrics is already in bcgrp
-
-#ifdef _OPENMP
-#pragma omp parallel
-#endif
-      for (MFIter mfi(spec,true); mfi.isValid(); ++mfi) {
-	  const Box&  bx  = mfi.nodaltilebox(idim);
-	  const Box& bbox = bcoefs[idim][mfi].box();
-
-	  lbcoefna(bcoefs[idim][mfi].dataPtr(),
-		   bcgrp[idim][mfi].dataPtr(),
-		   ARLIM(bbox.loVect()), ARLIM(bbox.hiVect()),
-		   ARLIM(bx.loVect()), ARLIM(bx.hiVect()),
-		   BL_TO_FORTRAN_N(spec[mfi], igroup), 
-		   idim);
-	  
-	  if (nGroups > 1) {
-	      BL_FORT_PROC_CALL(CA_ACCEL_CCOE, ca_accel_ccoe)
-		  (bx.loVect(), bx.hiVect(),
-		   BL_TO_FORTRAN(bcgrp[idim][mfi]),
-		   BL_TO_FORTRAN(spec[mfi]),
-		   BL_TO_FORTRAN(ccoefs[idim][mfi]),
-		   dx, &idim, &igroup);
-	  }
-      }
-    }
-  }
-
-  for (int idim = 0; idim < BL_SPACEDIM; idim++) {
-    solver.setLevelBCoeffs(level, bcoefs[idim], idim);
-
-    if (nGroups > 1) {
-      solver.setLevelCCoeffs(level, ccoefs[idim], idim);
-    }
-  }
+  gray_bccoefs(spec, kappa_r, lambda, solver, level);
 
   // rhs
   MultiFab rhs(grids,dmap,1,0);
@@ -675,6 +687,155 @@ void Radiation::gray_accel(MultiFab& Er_new, MultiFab& Er_pi,
 }
 
 
+// Adaptive groups: flag the zones that are optically thick in every
+// group (kappa_r dx >= adaptive_groups_tau) and whose spectrum is
+// within adaptive_groups_tol of Planck.  Zones at the faces of the
+// level are not flagged.  flag needs one ghost cell, which is filled.
+// Returns the fraction of the zones of the level that are flagged.
+
+Real Radiation::adaptive_groups_flag(int level, MultiFab& flag, const MultiFab& Er,
+				     const MultiFab& kappa_p, const MultiFab& kappa_r,
+				     const MultiFab& jg)
+{
+    BL_PROFILE("Radiation::adaptive_groups_flag");
+
+    const Geometry& geom = parent->Geom(level);
+    const Real* dx = geom.CellSize();
+    Real dxmin = dx[0];
+    for (int idim = 1; idim < BL_SPACEDIM; idim++) {
+	dxmin = std::min(dxmin, dx[idim]);
+    }
+
+    // 1 in the zones of the level, including the ghost cells covered
+    // by other grids, 0 outside
+    MultiFab inlev(flag.boxArray(), flag.DistributionMap(), 1, 1);
+    inlev.setVal(0.0);
+    inlev.setVal(1.0, 0, 1, 0);
+    inlev.FillBoundary(geom.periodicity());
+
+    flag.setVal(0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(flag,true); mfi.isValid(); ++mfi) {
+	const Box& bx = mfi.tilebox();
+
+	ca_adaptive_groups_flag(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+				BL_TO_FORTRAN_3D(Er[mfi]),
+				BL_TO_FORTRAN_3D(kappa_p[mfi]),
+				BL_TO_FORTRAN_3D(kappa_r[mfi]),
+				BL_TO_FORTRAN_3D(jg[mfi]),
+				BL_TO_FORTRAN_3D(inlev[mfi]),
+				BL_TO_FORTRAN_3D(flag[mfi]),
+				dxmin, adaptive_groups_tau, adaptive_groups_tol);
+    }
+
+    flag.FillBoundary(geom.periodicity());
+
+    return flag.sum(0) / flag.boxArray().d_numPts();
+}
+
+// Gray sweep of the adaptive group mode: the gray equation (the group
+// equations summed with the Planck spectrum as weights) is solved in
+// the zones with flag = 1, where the group solves held Er fixed, and
+// its solution is spread over the groups with the Planck spectrum.
+// The other zones hold the total energy of their groups.  rhs_gray is
+// the sum of the rhs of the group equations.
+
+void Radiation::gray_sweep(MultiFab& Er_new, const MultiFab& rhs_gray, const MultiFab& flag,
+			   MultiFab& kappa_p, MultiFab& kappa_r, const MultiFab& jg,
+			   Tuple<MultiFab, BL_SPACEDIM>& lambda,
+			   RadSolve& solver, MGRadBndry& mgbd,
+			   const BoxArray& grids, int level, Real delta_t, Real ptc_tau)
+{
+  BL_PROFILE("Radiation::gray_sweep");
+
+  const Geometry& geom = parent->Geom(level);
+  const Castro *castro = dynamic_cast<Castro*>(&parent->getLevel(level));
+  const DistributionMapping& dmap = castro->DistributionMap();
+
+  if (nGroups > 1) {
+    solver.setHypreMulti(1.0);
+  }
+  else {
+    solver.setHypreMulti(0.0);
+  }
+
+  MultiFab spec(grids, dmap, nGroups, 1);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  for (MFIter mfi(spec,true); mfi.isValid(); ++mfi) {
+    const Box& bx = mfi.tilebox();
+    ca_planck_spec(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+		   BL_TO_FORTRAN_3D(kappa_p[mfi]),
+		   BL_TO_FORTRAN_3D(jg[mfi]),
+		   BL_TO_FORTRAN_3D(spec[mfi]));
+  }
+
+  for (int indx = 0; indx < nGroups; indx++) {
+    extrapolateBorders(spec, indx);
+  }
+  spec.FillBoundary(geom.periodicity());
+
+  // Only the held zones touch the boundaries of the level, and their
+  // faces are removed from the operator, so any boundary data will do.
+  solver.levelBndry(mgbd,0);
+
+  MultiFab acoefs(grids, dmap, 1, 0);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  for (MFIter mfi(acoefs,true); mfi.isValid(); ++mfi) {
+    const Box& bx = mfi.tilebox();
+    ca_gray_sweep_acoe(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+		       BL_TO_FORTRAN_3D(spec[mfi]),
+		       BL_TO_FORTRAN_3D(kappa_p[mfi]),
+		       BL_TO_FORTRAN_3D(acoefs[mfi]),
+		       delta_t, ptc_tau);
+  }
+
+  solver.cellCenteredApplyMetrics(level, acoefs);
+  solver.setLevelACoeffs(level, acoefs);
+
+  gray_bccoefs(spec, kappa_r, lambda, solver, level);
+
+  MultiFab Etot(grids, dmap, 1, 0);
+  Etot.setVal(0.0);
+  for (int igroup = 0; igroup < nGroups; igroup++) {
+    MultiFab::Add(Etot, Er_new, igroup, 0, 1, 0);
+  }
+
+  MultiFab hold(grids, dmap, 1, 1);
+  hold.setVal(0.0);
+  hold.setVal(1.0, 0, 1, 0);
+  MultiFab::Subtract(hold, flag, 0, 0, 1, 0);
+  hold.FillBoundary(geom.periodicity());
+
+  MultiFab rhs(grids, dmap, 1, 0);
+  MultiFab::Copy(rhs, rhs_gray, 0, 0, 1, 0);
+
+  solver.levelHold(level, rhs, Etot, 0, hold);
+
+  // the gray operator has its own solver setup, after those of the groups
+  solver.levelSolve(level, Etot, 0, rhs, 0.01, nGroups);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  for (MFIter mfi(Er_new,true); mfi.isValid(); ++mfi) {
+    const Box& bx = mfi.tilebox();
+    ca_gray_sweep_update(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+			 BL_TO_FORTRAN_3D(flag[mfi]),
+			 BL_TO_FORTRAN_3D(spec[mfi]),
+			 BL_TO_FORTRAN_3D(Etot[mfi]),
+			 BL_TO_FORTRAN_3D(Er_new[mfi]));
+  }
+
+  solver.restoreHypreMulti();
+}
+
 void Radiation::local_accel(MultiFab& Er_new, const MultiFab& Er_pi,
 			    const MultiFab& kappa_p, 
 			    const MultiFab& etaT, const MultiFab& etaY, 
@@ -991,11 +1152,12 @@ void Radiation::compute_limiter(int level, const BoxArray& grids,
 #pragma omp parallel
 #endif    
     for (MFIter mfi(Er_wide,false); mfi.isValid(); ++mfi) {
+      const Box& bx = mfi.validbox();
       BL_FORT_PROC_CALL(CA_COMPUTE_LAMBORDER, ca_compute_lamborder)
 	(BL_TO_FORTRAN(Er_wide[mfi]), 
 	 BL_TO_FORTRAN(kpr[mfi]),
 	 BL_TO_FORTRAN(lamborder[mfi]), 
-	 dx, &ngrow, &limiter, &filter_lambda_T, &filter_lambda_S);
+	 dx, bx.loVect(), bx.hiVect(), &limiter, &filter_lambda_T, &filter_lambda_S);
     }
 
     if (filter_lambda_T) {
@@ -1005,6 +1167,87 @@ void Radiation::compute_limiter(int level, const BoxArray& grids,
 }
 
 
+// The limiter on the box of lam alone, for one tile of the hydro update;
+// validbox is the grid the tile belongs to.  Er has to cover the box of
+// lam grown by one cell.  kpr and Er_wide are scratch space supplied by
+// the caller so that they can be reused from tile to tile.  The flux
+// limiter filter needs the limiter of the neighboring grids and is only
+// available in the MultiFab version.
+
+void Radiation::compute_limiter(int level, const BoxArray& grids,
+				const Box& validbox,
+				const FArrayBox& state, 
+				const FArrayBox& Er,
+				FArrayBox& lam,
+				FArrayBox& kpr, FArrayBox& Er_wide)
+{
+  BL_ASSERT(filter_lambda_T == 0);
+
+  if (limiter == 0) {
+
+    lam.setVal(1./3.);
+
+  }
+  else {
+
+    const Box& lbox = lam.box();
+
+    kpr.resize(lbox, nGroups);
+
+    if (do_multigroup) {
+      MGFLD_compute_rosseland(kpr, state);
+    }
+    else {
+      SGFLD_compute_rosseland(kpr, state);
+    }
+
+    // As in the MultiFab version, cells not covered by the grids of this
+    // level (or their periodic images) are set to -1 so that one-sided
+    // differences are used next to them.
+
+    const Box& wbox = amrex::grow(lbox, 1);
+    BL_ASSERT(Er.box().contains(wbox));
+
+    Er_wide.resize(wbox, nGroups);
+    Er_wide.setVal(-1.0);
+
+    const std::vector< std::pair<int,Box> >& isects = grids.intersections(wbox);
+    for (int ii = 0; ii < isects.size(); ii++) {
+      const Box& ovlp = isects[ii].second;
+      Er_wide.copy(Er, ovlp, 0, ovlp, 0, nGroups);
+    }
+
+    const Geometry& geom = parent->Geom(level);
+
+    if (geom.isAnyPeriodic() && !geom.Domain().contains(wbox)) {
+      Vector<IntVect> pshifts(27);
+      geom.periodicShift(geom.Domain(), wbox, pshifts);
+      for (int iiv = 0; iiv < pshifts.size(); iiv++) {
+	const IntVect& iv = pshifts[iiv];
+	Box sbox(wbox);
+	sbox.shift(iv);
+	const std::vector< std::pair<int,Box> >& pisects = grids.intersections(sbox);
+	for (int ii = 0; ii < pisects.size(); ii++) {
+	  Box ovlp(pisects[ii].second);
+	  ovlp.shift(-iv);
+	  Er_wide.copy(Er, ovlp, 0, ovlp, 0, nGroups);
+	}
+      }
+    }
+
+    const Real* dx = geom.CellSize();
+    int no_filter = 0;
+
+    BL_FORT_PROC_CALL(CA_COMPUTE_LAMBORDER, ca_compute_lamborder)
+      (BL_TO_FORTRAN(Er_wide), 
+       BL_TO_FORTRAN(kpr),
+       BL_TO_FORTRAN(lam), 
+       dx, validbox.loVect(), validbox.hiVect(), 
+       &limiter, &no_filter, &filter_lambda_S);
+  }
+}
+
+
 void Radiation::estimate_gamrPr(const FArrayBox& state, const FArrayBox& Er, 
 				FArrayBox& gPr, const Real*dx, const Box& box)
 {
@@ -4,6 +4,7 @@
 
 #include "Radiation.H"
 #include "RadSolve.H"
+#include "AndersonAccel.H"
 
 #include "Castro_F.H"
 
@@ -11,6 +12,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -66,12 +68,7 @@ void Radiation::MGFLD_implicit_update(int level, int iteration, int ncycle)
       MultiFab kpr_lag(grids,dmap,nGroups,1);
       MGFLD_compute_rosseland(kpr_lag, S_lag); 
 
-      for (int igroup=0; igroup<nGroups; ++igroup) {
-	scaledGradient(level, lambda, kpr_lag, igroup, Er_lag, igroup, limiter, 1, igroup);
-	// lambda now contains scaled gradient
-	fluxLimiter(level, lambda, limiter, igroup);
-	// lambda now contains flux limiter
-      }
+      scaledGradientLimiter(level, lambda, kpr_lag, Er_lag, limiter);
     }
   }
   else {
@@ -228,6 +225,20 @@ void Radiation::MGFLD_implicit_update(int level, int iteration, int ncycle)
   RadSolve solver(parent);
   solver.levelInit(level);
 
+  // boundary data on the distribution of each group block
+  const int n_group_blocks = solver.numGroupBlocks();
+  Vector<std::unique_ptr<MGRadBndry> > mgbd_block(n_group_blocks);
+  if (n_group_blocks > 1) {
+    const int ng = Er_new.nGrow();
+    for (int ib = 0; ib < n_group_blocks; ++ib) {
+      const DistributionMapping& bdmap = solver.groupBlockDistributionMap(ib);
+      MultiFab Er_block(grids, bdmap, nGroups, ng);
+      Er_block.copy(Er_new, 0, 0, nGroups, ng, ng);
+      mgbd_block[ib].reset(new MGRadBndry(grids, bdmap, nGroups, castro->Geom()));
+      getBndryDataMG(*mgbd_block[ib], Er_block, time, level);
+    }
+  }
+
   Real relative_in, absolute_in, error_er;
   Real rel_rhoe, abs_rhoe;
   Real rel_T, abs_T, rel_Ye, abs_Ye;
@@ -267,6 +278,33 @@ void Radiation::MGFLD_implicit_update(int level, int iteration, int ncycle)
   Real reltol_in = relInTol;
   Real ptc_tau = 0.0;  // not being used 
 
+  // Anderson acceleration of the inner iteration, on top of the
+  // local or gray acceleration
+  std::unique_ptr<AndersonAccel> anderson;
+  if (anderson_depth > 0) {
+    anderson.reset(new AndersonAccel(grids, dmap, nGroups, anderson_depth));
+  }
+
+  // adaptive group mode: the zones solved as gray (group_flag = 1),
+  // the sum of the rhs of the groups for their gray solve, and the
+  // fraction of gray zones summed over the outer iterations
+  MultiFab group_flag, rhs_gray;
+  Real gray_frac = 0.0, gray_frac_sum = 0.0;
+  if (adaptive_groups) {
+    if (n_group_blocks > 1 || have_Sanchez_Pomraning) {
+      amrex::Error("radiation.adaptive_groups does not work with group blocks or Sanchez-Pomraning boundaries");
+    }
+    group_flag.define(grids, dmap, 1, 1);
+    rhs_gray.define(grids, dmap, 1, 0);
+  }
+
+  // inner iteration statistics for this update
+  int total_inner = 0;
+  int n_inner_unconverged = 0;
+
+  // nonlinear residuals for the adaptive linear tolerance
+  Real forcing_res = -1.0, forcing_res_prev = -1.0, outer_res = -1.0;
+
   // nonlinear loop for all groups
   int it = 0;
   bool conservative_update = false;
@@ -298,12 +336,7 @@ void Radiation::MGFLD_implicit_update(int level, int iteration, int ncycle)
     if (limiter>0 && inner_update_limiter==0) {
       Er_star.FillBoundary(parent->Geom(level).periodicity());
 
-      for (int igroup=0; igroup<nGroups; ++igroup) {
-	scaledGradient(level, lambda, kappa_r, igroup, Er_star, igroup, limiter, 1, igroup);
-	// lambda now contains scaled gradient
-	fluxLimiter(level, lambda, limiter, igroup);
-	// lambda now contains flux limiter
-      }
+      scaledGradientLimiter(level, lambda, kappa_r, Er_star, limiter);
     }
     
     // djdT & djdY are both input and output
@@ -316,11 +349,24 @@ void Radiation::MGFLD_implicit_update(int level, int iteration, int ncycle)
 		      grids, delta_t, ptc_tau);
     // After this, djdT & djdY contain mugT and mugY.
 
+    if (adaptive_groups) {
+      gray_frac = adaptive_groups_flag(level, group_flag, Er_star, kappa_p, kappa_r, jg);
+      gray_frac_sum += gray_frac;
+    }
+    // the gray zones are held fixed in the group solves, and the groups
+    // are not solved at all when every zone is gray
+    const bool do_gray_sweep = gray_frac > 0.0;
+    const bool do_group_solves = gray_frac < 1.0;
+
     // The inner loops does not update rhoe and T
     int innerIteration = 0;
     inner_converged = false;
     Real relative_in_prev = 1.e200, absolute_in_prev = 1.e200;
     bool accel_allowed = true;
+    if (anderson) {
+      // the coefficients have changed, and so has the fixed-point map
+      anderson->reset();
+    }
     do {
       innerIteration++;
 
@@ -330,61 +376,150 @@ void Radiation::MGFLD_implicit_update(int level, int iteration, int ncycle)
 	if (innerIteration <= inner_update_limiter) {
           Er_pi.FillBoundary(parent->Geom(level).periodicity());
 	  
-	  for (int igroup=0; igroup<nGroups; ++igroup) {
-	    scaledGradient(level, lambda, kappa_r, igroup, Er_pi, igroup, limiter, 1, igroup);
-	    // lambda now contains scaled gradient
-	    fluxLimiter(level, lambda, limiter, igroup);
-	    // lambda now contains flux limiter
-	  }
+	  scaledGradientLimiter(level, lambda, kappa_r, Er_pi, limiter);
 	}
       }
 
       compute_coupling(coupT, coupY, kappa_p, Er_pi, jg);
 
-      for (int igroup=0; igroup<nGroups; ++igroup) {
+      solver.updateForcingTerm(forcing_res, forcing_res_prev, reltol_in, outer_res);
 
-	set_current_group(igroup);
+      if (n_group_blocks == 1) {
+	if (do_gray_sweep) {
+	  rhs_gray.setVal(0.0);
+	}
+
+	for (int igroup=0; igroup<nGroups; ++igroup) {
 
-	// setup and solve linear system
+	  set_current_group(igroup);
 
-	// set boundary condition
-	solver.levelBndry(mgbd, igroup);
+	  // setup and solve linear system
+
+	  // set boundary condition
+	  solver.levelBndry(mgbd, igroup);
 	
-	solver.levelACoeffs(level, kappa_p, delta_t, c, igroup, ptc_tau);
+	  solver.levelACoeffs(level, kappa_p, delta_t, c, igroup, ptc_tau);
 
-	int lamcomp = (limiter==0) ? 0 : igroup;
-	solver.levelBCoeffs(level, lambda, kappa_r, igroup, c, lamcomp);
+	  int lamcomp = (limiter==0) ? 0 : igroup;
+	  solver.levelBCoeffs(level, lambda, kappa_r, igroup, c, lamcomp);
 
-	if (have_Sanchez_Pomraning) {
-	  solver.levelSPas(level, lambda, igroup, lo_bc, hi_bc);
-	}
+	  if (have_Sanchez_Pomraning) {
+	    solver.levelSPas(level, lambda, igroup, lo_bc, hi_bc);
+	  }
 
-	{ // src and rhd block
+	  { // src and rhd block
 	  	  
-	  MultiFab rhs(grids,dmap,1,0);
+	    MultiFab rhs(grids,dmap,1,0);
+
+	    solver.levelRhs(level, rhs, jg, mugT, mugY, 
+			    coupT, coupY, etaT, etaY, thetaT, thetaY,
+			    Er_step, rhoe_step, rhoYe_step, Er_star, rhoe_star, rhoYe_star, 
+			    delta_t, igroup, it, ptc_tau);
+
+	    if (do_gray_sweep) {
+	      MultiFab::Add(rhs_gray, rhs, 0, 0, 1, 0);
+	      if (do_group_solves) {
+		solver.levelHold(level, rhs, Er_pi, igroup, group_flag);
+	      }
+	    }
+
+	    // solve Er equation and put solution in Er_new(igroup)
+	    if (do_group_solves) {
+	      solver.levelSolve(level, Er_new, igroup, rhs, 0.01, igroup);
+	    }
+	  } // end src and rhs block
+
+	  if (!do_gray_sweep) {
+	    solver.levelFlux(level, Flux, Er_new, igroup);
+	    solver.levelFluxReg(level, flux_in, flux_out, Flux, igroup);
+	  
+	    if (icomp_flux >= 0) 
+	      solver.levelFluxFaceToCenter(level, Flux, *flxcc, icomp_flux+igroup);
+	  }
 
-	  solver.levelRhs(level, rhs, jg, mugT, mugY, 
-			  coupT, coupY, etaT, etaY, thetaT, thetaY,
-			  Er_step, rhoe_step, rhoYe_step, Er_star, rhoe_star, rhoYe_star, 
-			  delta_t, igroup, it, ptc_tau);
+	} // end loop over groups
 
-	  // solve Er equation and put solution in Er_new(igroup)
-	  solver.levelSolve(level, Er_new, igroup, rhs, 0.01);
-	} // end src and rhs block
+	if (do_gray_sweep) {
+	  gray_sweep(Er_new, rhs_gray, group_flag, kappa_p, kappa_r, jg, lambda,
+		     solver, mgbd, grids, level, delta_t, ptc_tau);
 
-	solver.levelFlux(level, Flux, Er_new, igroup);
-	solver.levelFluxReg(level, flux_in, flux_out, Flux, igroup);
-	  
-	if (icomp_flux >= 0) 
-	    solver.levelFluxFaceToCenter(level, Flux, *flxcc, icomp_flux+igroup);
+	  // the group solves changed the b coefficients next to the gray
+	  // zones, so the fluxes of all groups are computed now
+	  for (int igroup=0; igroup<nGroups; ++igroup) {
+	    solver.levelBndry(mgbd, igroup);
+
+	    int lamcomp = (limiter==0) ? 0 : igroup;
+	    solver.levelBCoeffs(level, lambda, kappa_r, igroup, c, lamcomp);
+
+	    solver.levelFlux(level, Flux, Er_new, igroup);
+	    solver.levelFluxReg(level, flux_in, flux_out, Flux, igroup);
+
+	    if (icomp_flux >= 0) 
+	      solver.levelFluxFaceToCenter(level, Flux, *flxcc, icomp_flux+igroup);
+	  }
+	}
+      }
+      else {
+	// Groups are solved n_group_blocks at a time, each on its own
+	// block of processors.  All processors build the coefficients and
+	// rhs of every group (on the level distribution); the solves then
+	// run concurrently on the blocks.
+	for (int g0=0; g0<nGroups; g0+=n_group_blocks) {
+	  const int nblocks = std::min(n_group_blocks, nGroups-g0);
 
-      } // end loop over groups
+	  for (int ib=0; ib<nblocks; ++ib) {
+	    int igroup = g0 + ib;
+
+	    set_current_group(igroup);
+
+	    solver.selectGroupBlock(ib);
+
+	    solver.levelBndry(*mgbd_block[ib], igroup);
+
+	    solver.levelACoeffs(level, kappa_p, delta_t, c, igroup, ptc_tau);
+
+	    int lamcomp = (limiter==0) ? 0 : igroup;
+	    solver.levelBCoeffs(level, lambda, kappa_r, igroup, c, lamcomp);
+
+	    if (have_Sanchez_Pomraning) {
+	      solver.levelSPas(level, lambda, igroup, lo_bc, hi_bc);
+	    }
+
+	    MultiFab rhs(grids,dmap,1,0);
+
+	    solver.levelRhs(level, rhs, jg, mugT, mugY, 
+			    coupT, coupY, etaT, etaY, thetaT, thetaY,
+			    Er_step, rhoe_step, rhoYe_step, Er_star, rhoe_star, rhoYe_star, 
+			    delta_t, igroup, it, ptc_tau);
+
+	    solver.setGroupBlockData(ib, Er_new, igroup, rhs);
+	  }
+
+	  solver.selectGroupBlock(-1);
+
+	  solver.levelSolveGroupBlocks(level, nblocks, 0.01);
+
+	  for (int ib=0; ib<nblocks; ++ib) {
+	    int igroup = g0 + ib;
+
+	    solver.getGroupBlockData(level, ib, Er_new, igroup, Flux);
+
+	    solver.levelFluxReg(level, flux_in, flux_out, Flux, igroup);
+
+	    if (icomp_flux >= 0) 
+	      solver.levelFluxFaceToCenter(level, Flux, *flxcc, icomp_flux+igroup);
+	  }
+	}
+      }
       
       // Check for convergence *before* acceleration step:
       check_convergence_er(relative_in, absolute_in, error_er, Er_new, Er_pi,
       			   kappa_p, etaTz, etaYz, thetaTz, thetaYz,
 			   temp_new, Ye_new, grids, delta_t);
 
+      forcing_res_prev = forcing_res;
+      forcing_res = relative_in;
+
       if (verbose >= 2 && ParallelDescriptor::IOProcessor()) {
 	int oldprec = std::cout.precision(3);
         std::cout << "Outer = " << it << ", Inner = " << innerIteration
@@ -429,11 +564,20 @@ void Radiation::MGFLD_implicit_update(int level, int iteration, int ncycle)
 		       etaT, etaY, eta1, thetaT, thetaY, mugT, mugY, 
 		       lambda, solver, mgbd, grids, level, time, delta_t, ptc_tau);
 	  } 
+
+	  if (anderson) {
+	    int nmix = anderson->update(Er_new, Er_pi);
+	    if (verbose >= 3 && ParallelDescriptor::IOProcessor()) {
+	      std::cout << "Anderson mixing with " << nmix << " previous iterates" << std::endl;
+	    }
+	  }
 	}
       }
 
     } while(!inner_converged && innerIteration < maxInIter); 
 
+    total_inner += innerIteration;
+
     if (verbose == 1 && ParallelDescriptor::IOProcessor()) {
       int oldprec = std::cout.precision(3);
       std::cout << "Outer = " << it << ", Inner = " << innerIteration
@@ -446,6 +590,14 @@ void Radiation::MGFLD_implicit_update(int level, int iteration, int ncycle)
 	(relative_in > reltol_in && absolute_in > absInTol)) {
       //      amrex::Warning("Er Equation Update Failed to Converge");
       //      amrex::Abort("Er Equation Update Failed to Converge");
+      n_inner_unconverged++;
+      if (verbose >= 1 && ParallelDescriptor::IOProcessor()) {
+	int oldprec = std::cout.precision(3);
+	std::cout << "Warning: inner iteration not converged after " << maxInIter
+		  << " iterations, inner err = " << relative_in << " (rel), "
+		  << absolute_in << " (abs)" << std::endl;
+	std::cout.precision(oldprec);
+      }
     }
 
     // update rhoe, rhoYe and T
@@ -558,6 +710,8 @@ void Radiation::MGFLD_implicit_update(int level, int iteration, int ncycle)
       absolute_out = (abs_T > abs_Ye) ? abs_T : abs_Ye;      
     }
 
+    outer_res = relative_out;
+
     if (verbose >= 2 && ParallelDescriptor::IOProcessor()) {
       int oldprec = std::cout.precision(4);
       std::cout << "Update Errors for      rhoe,        FT,         T" 
@@ -635,6 +789,23 @@ void Radiation::MGFLD_implicit_update(int level, int iteration, int ncycle)
     std::cout.precision(oldprec);
   }
 
+  if (verbose >= 1 && ParallelDescriptor::IOProcessor()) {
+    std::cout << "MGFLD level " << level << ": " << it << " outer, "
+	      << total_inner << " inner iterations";
+    if (n_inner_unconverged > 0) {
+      std::cout << " (" << n_inner_unconverged << " inner loops not converged)";
+    }
+    std::cout << std::endl;
+    if (adaptive_groups) {
+      int oldprec = std::cout.precision(3);
+      Real frac = gray_frac_sum / it;
+      std::cout << "MGFLD level " << level << ": " << 100.0*frac
+		<< "% of zones gray, " << 100.0*(1.0-frac)
+		<< "% multigroup (mean over the outer iterations)" << std::endl;
+      std::cout.precision(oldprec);
+    }
+  }
+
   if (! converged) {
     if (verbose > 0 && ParallelDescriptor::IOProcessor()) {
       std::cout << "Implicit Update Failed to Converge" << std::endl;
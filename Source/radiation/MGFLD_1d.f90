@@ -877,6 +877,7 @@ subroutine ca_opacs( lo, hi,  &
 
   use rad_params_module, only : ngroups, nugroup
   use opacity_table_module, only : get_opacities
+  use opacity_cache_module, only : use_opacity_cache, opacity_cache_locate, opacity_cache_interp
   use network, only : naux
   use meth_params_module, only : NVAR, URHO, UFX
 
@@ -899,6 +900,10 @@ subroutine ca_opacs( lo, hi,  &
   integer, intent(in) :: use_dkdT, validStar, lag_opac
 
   integer :: i, g
+  integer :: n, ii
+  integer, allocatable :: ir(:), it(:), ir2(:), it2(:)
+  real(rt), allocatable :: fr(:), ft(:), fr2(:), ft2(:)
+  real(rt), allocatable :: tm(:), tp(:), dTv(:), kpm(:), kpl(:)
   real(rt)         :: kp, kr, nu, rho, temp, Ye
   real(rt)         :: kp1, kr1
   real(rt)         :: kp2, kr2
@@ -911,6 +916,43 @@ subroutine ca_opacs( lo, hi,  &
      return
   end if
 
+  if (use_opacity_cache) then
+     n = hi(1) - lo(1) + 1
+     allocate(ir(n), it(n), fr(n), ft(n), ir2(n), it2(n), fr2(n), ft2(n))
+     allocate(tm(n), tp(n), dTv(n), kpm(n), kpl(n))
+     call opacity_cache_locate(n, Snew(lo(1):hi(1),URHO), T(lo(1):hi(1)), ir, it, fr, ft)
+     do g = 0, ngroups-1
+        call opacity_cache_interp(n, g, 1, ir, it, fr, ft, kpp(lo(1):hi(1),g))
+        call opacity_cache_interp(n, g, 2, ir, it, fr, ft, kpr(lo(1):hi(1),g))
+     end do
+
+     if (use_dkdT .eq. 0) then
+        dkdT(lo(1):hi(1),:) = 0.e0_rt
+     else
+        do i = lo(1), hi(1)
+           ii = i - lo(1) + 1
+           if (validStar > 0) then
+              dT = fac*abs(Ts(i) - T(i))
+              dT = max(dT, minfrac*T(i))
+           else
+              dT = T(i) * 1.e-3_rt + 1.e-50_rt
+           end if
+           dTv(ii) = dT
+           tm(ii) = T(i) - dT
+           tp(ii) = T(i) + dT
+        end do
+
+        call opacity_cache_locate(n, Snew(lo(1):hi(1),URHO), tm, ir, it, fr, ft)
+        call opacity_cache_locate(n, Snew(lo(1):hi(1),URHO), tp, ir2, it2, fr2, ft2)
+        do g = 0, ngroups-1
+           call opacity_cache_interp(n, g, 1, ir, it, fr, ft, kpm)
+           call opacity_cache_interp(n, g, 1, ir2, it2, fr2, ft2, kpl)
+           dkdT(lo(1):hi(1),g) = (kpl - kpm) / (2.e0_rt*dTv)
+        end do
+     end if
+     return
+  end if
+
   do i=lo(1), hi(1)
      
      rho = Snew(i,URHO)
@@ -965,6 +1007,7 @@ subroutine ca_compute_rosseland( lo, hi, &
 
   use rad_params_module, only : ngroups, nugroup
   use opacity_table_module, only : get_opacities
+  use opacity_cache_module, only : use_opacity_cache, opacity_cache_locate, opacity_cache_interp
   use network, only : naux
   use meth_params_module, only : NVAR, URHO, UTEMP, UFX
 
@@ -978,10 +1021,23 @@ subroutine ca_compute_rosseland( lo, hi, &
   real(rt)        , intent(in) :: stat(stat_l1:stat_h1,NVAR)
 
   integer :: i, g
+  integer :: n
+  integer, allocatable :: ir(:), it(:)
+  real(rt), allocatable :: fr(:), ft(:)
   real(rt)         :: kp, kr, nu, rho, temp, Ye
   logical, parameter :: comp_kp = .false. 
   logical, parameter :: comp_kr = .true.
 
+  if (use_opacity_cache) then
+     n = hi(1) - lo(1) + 1
+     allocate(ir(n), it(n), fr(n), ft(n))
+     call opacity_cache_locate(n, stat(lo(1):hi(1),URHO), stat(lo(1):hi(1),UTEMP), ir, it, fr, ft)
+     do g = 0, ngroups-1
+        call opacity_cache_interp(n, g, 2, ir, it, fr, ft, kpr(lo(1):hi(1),g))
+     end do
+     return
+  end if
+
   do g=0, ngroups-1
 
      nu = nugroup(g)
@@ -1012,6 +1068,7 @@ subroutine ca_compute_planck( lo, hi,  &
 
   use rad_params_module, only : ngroups, nugroup
   use opacity_table_module, only : get_opacities
+  use opacity_cache_module, only : use_opacity_cache, opacity_cache_locate, opacity_cache_interp
   use network, only : naux
   use meth_params_module, only : NVAR, URHO, UTEMP, UFX
 
@@ -1025,10 +1082,23 @@ subroutine ca_compute_planck( lo, hi,  &
   real(rt)        , intent(in) :: stat(stat_l1:stat_h1,NVAR)
 
   integer :: i, g
+  integer :: n
+  integer, allocatable :: ir(:), it(:)
+  real(rt), allocatable :: fr(:), ft(:)
   real(rt)         :: kp, kr, nu, rho, temp, Ye
   logical, parameter :: comp_kp = .true. 
   logical, parameter :: comp_kr = .false.
 
+  if (use_opacity_cache) then
+     n = hi(1) - lo(1) + 1
+     allocate(ir(n), it(n), fr(n), ft(n))
+     call opacity_cache_locate(n, stat(lo(1):hi(1),URHO), stat(lo(1):hi(1),UTEMP), ir, it, fr, ft)
+     do g = 0, ngroups-1
+        call opacity_cache_interp(n, g, 1, ir, it, fr, ft, kpp(lo(1):hi(1),g))
+     end do
+     return
+  end if
+
   do g=0, ngroups-1
 
      nu = nugroup(g)
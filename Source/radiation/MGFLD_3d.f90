@@ -954,6 +954,7 @@ subroutine ca_opacs( lo, hi,  &
 
   use rad_params_module, only : ngroups, nugroup
   use opacity_table_module, only : get_opacities
+  use opacity_cache_module, only : use_opacity_cache, opacity_cache_locate, opacity_cache_interp
   use network, only : naux
   use meth_params_module, only : NVAR, URHO, UFX
 
@@ -976,6 +977,10 @@ subroutine ca_opacs( lo, hi,  &
   integer, intent(in) :: use_dkdT, validStar, lag_opac
 
   integer :: i, j, k, g
+  integer :: n, ii
+  integer, allocatable :: ir(:), it(:), ir2(:), it2(:)
+  real(rt), allocatable :: fr(:), ft(:), fr2(:), ft2(:)
+  real(rt), allocatable :: tm(:), tp(:), dTv(:), kpm(:), kpl(:)
   real(rt)         :: kp, kr, nu, rho, temp, Ye
   real(rt)         :: kp1, kr1
   real(rt)         :: kp2, kr2
@@ -988,6 +993,47 @@ subroutine ca_opacs( lo, hi,  &
      return
   end if
 
+  if (use_opacity_cache) then
+     n = hi(1) - lo(1) + 1
+     allocate(ir(n), it(n), fr(n), ft(n), ir2(n), it2(n), fr2(n), ft2(n))
+     allocate(tm(n), tp(n), dTv(n), kpm(n), kpl(n))
+     do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        call opacity_cache_locate(n, Snew(lo(1):hi(1),j,k,URHO), T(lo(1):hi(1),j,k), ir, it, fr, ft)
+        do g = 0, ngroups-1
+           call opacity_cache_interp(n, g, 1, ir, it, fr, ft, kpp(lo(1):hi(1),j,k,g))
+           call opacity_cache_interp(n, g, 2, ir, it, fr, ft, kpr(lo(1):hi(1),j,k,g))
+        end do
+
+        if (use_dkdT .eq. 0) then
+           dkdT(lo(1):hi(1),j,k,:) = 0.e0_rt
+        else
+           do i = lo(1), hi(1)
+              ii = i - lo(1) + 1
+              if (validStar > 0) then
+                 dT = fac*abs(Ts(i,j,k) - T(i,j,k))
+                 dT = max(dT, minfrac*T(i,j,k))
+              else
+                 dT = T(i,j,k) * 1.e-3_rt + 1.e-50_rt
+              end if
+              dTv(ii) = dT
+              tm(ii) = T(i,j,k) - dT
+              tp(ii) = T(i,j,k) + dT
+           end do
+
+           call opacity_cache_locate(n, Snew(lo(1):hi(1),j,k,URHO), tm, ir, it, fr, ft)
+           call opacity_cache_locate(n, Snew(lo(1):hi(1),j,k,URHO), tp, ir2, it2, fr2, ft2)
+           do g = 0, ngroups-1
+              call opacity_cache_interp(n, g, 1, ir, it, fr, ft, kpm)
+              call opacity_cache_interp(n, g, 1, ir2, it2, fr2, ft2, kpl)
+              dkdT(lo(1):hi(1),j,k,g) = (kpl - kpm) / (2.e0_rt*dTv)
+           end do
+        end if
+     end do
+     end do
+     return
+  end if
+
   do k=lo(3), hi(3)
   do j=lo(2), hi(2)
   do i=lo(1), hi(1)
@@ -1046,6 +1092,7 @@ subroutine ca_compute_rosseland( lo, hi,   &
 
   use rad_params_module, only : ngroups, nugroup
   use opacity_table_module, only : get_opacities
+  use opacity_cache_module, only : use_opacity_cache, opacity_cache_locate, opacity_cache_interp
   use network, only : naux
   use meth_params_module, only : NVAR, URHO, UTEMP, UFX
 
@@ -1059,10 +1106,27 @@ subroutine ca_compute_rosseland( lo, hi,   &
   real(rt)        ,intent(in)::stat(stat_l1:stat_h1,stat_l2:stat_h2,stat_l3:stat_h3,NVAR)
 
   integer :: i, j, k, g
+  integer :: n
+  integer, allocatable :: ir(:), it(:)
+  real(rt), allocatable :: fr(:), ft(:)
   real(rt)         :: kp, kr, nu, rho, temp, Ye
   logical, parameter :: comp_kp = .false. 
   logical, parameter :: comp_kr = .true.
 
+  if (use_opacity_cache) then
+     n = hi(1) - lo(1) + 1
+     allocate(ir(n), it(n), fr(n), ft(n))
+     do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        call opacity_cache_locate(n, stat(lo(1):hi(1),j,k,URHO), stat(lo(1):hi(1),j,k,UTEMP), ir, it, fr, ft)
+        do g = 0, ngroups-1
+           call opacity_cache_interp(n, g, 2, ir, it, fr, ft, kpr(lo(1):hi(1),j,k,g))
+        end do
+     end do
+     end do
+     return
+  end if
+
   do g=0, ngroups-1
 
      nu = nugroup(g)
@@ -1097,6 +1161,7 @@ subroutine ca_compute_planck( lo, hi,  &
 
   use rad_params_module, only : ngroups, nugroup
   use opacity_table_module, only : get_opacities
+  use opacity_cache_module, only : use_opacity_cache, opacity_cache_locate, opacity_cache_interp
   use network, only : naux
   use meth_params_module, only : NVAR, URHO, UTEMP, UFX
 
@@ -1110,10 +1175,27 @@ subroutine ca_compute_planck( lo, hi,  &
   real(rt)        ,intent(in)::stat(stat_l1:stat_h1,stat_l2:stat_h2,stat_l3:stat_h3,NVAR)
 
   integer :: i, j, k, g
+  integer :: n
+  integer, allocatable :: ir(:), it(:)
+  real(rt), allocatable :: fr(:), ft(:)
   real(rt)         :: kp, kr, nu, rho, temp, Ye
   logical, parameter :: comp_kp = .true. 
   logical, parameter :: comp_kr = .false.
 
+  if (use_opacity_cache) then
+     n = hi(1) - lo(1) + 1
+     allocate(ir(n), it(n), fr(n), ft(n))
+     do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        call opacity_cache_locate(n, stat(lo(1):hi(1),j,k,URHO), stat(lo(1):hi(1),j,k,UTEMP), ir, it, fr, ft)
+        do g = 0, ngroups-1
+           call opacity_cache_interp(n, g, 1, ir, it, fr, ft, kpp(lo(1):hi(1),j,k,g))
+        end do
+     end do
+     end do
+     return
+  end if
+
   do g=0, ngroups-1
 
      nu = nugroup(g)
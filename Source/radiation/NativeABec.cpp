@@ -0,0 +1,133 @@
+#include "NativeABec.H"
+
+#include <iostream>
+#include <cmath>
+
+using namespace amrex;
+
+NativeABec::NativeABec(const BoxArray& grids,
+                       const DistributionMapping& dmap,
+                       const Geometry& _geom)
+  : ABecLevel(grids, dmap, _geom),
+    setup_maxiter(0),
+    mg(grids, dmap, _geom),
+    x(grids, dmap, 1, 0),
+    b(grids, dmap, 1, 0),
+    bnorm(0.0)
+{
+}
+
+void NativeABec::setupSolver(Real _reltol, Real _abstol, int maxiter)
+{
+  BL_PROFILE("NativeABec::setupSolver");
+
+  reltol = _reltol;
+  abstol = _abstol;
+  setup_maxiter = maxiter;
+
+  Real strt_time = ParallelDescriptor::second();
+
+  // The native solver keeps the lower couplings in components 0 to
+  // BL_SPACEDIM-1 of its stencil and the diagonal in component 3.
+
+  MultiFab& stencil = mg.stencil();
+  const int size = BL_SPACEDIM + 1;
+
+  Vector<Real> mat;
+  for (MFIter ai(*acoefs); ai.isValid(); ++ai) {
+    const Box &reg = acoefs->boxArray()[ai.index()];
+
+    buildMatrix(ai, mat);
+
+    FArrayBox& st = stencil[ai];
+    int n = 0;
+    for (IntVect iv = reg.smallEnd(); iv <= reg.bigEnd(); reg.next(iv), n++) {
+      for (int s = 0; s < BL_SPACEDIM; s++) {
+        st(iv, s) = mat[s + size*n];
+      }
+      st(iv, 3) = mat[BL_SPACEDIM + size*n];
+    }
+  }
+
+  mg.setup();
+
+  setup_time += ParallelDescriptor::second() - strt_time;
+  num_setups++;
+}
+
+void NativeABec::solve(MultiFab& dest, int icomp, MultiFab& rhs, BC_Mode inhom)
+{
+  BL_PROFILE("NativeABec::solve");
+
+  const BoxArray& grids = acoefs->boxArray();
+
+  for (MFIter di(x); di.isValid(); ++di) {
+    const Box &reg = grids[di.index()];
+
+    x[di].copy(dest[di], reg, icomp, reg, 0, 1);
+    b[di].copy(rhs[di], reg, 0, reg, 0, 1);
+
+    // add b.c.'s to rhs
+
+    if (inhom) {
+      addBoundaryRhs(di, b[di].dataPtr());
+    }
+  }
+
+  bnorm = std::sqrt(MultiFab::Dot(b, 0, b, 0, 1, 0));
+
+  // same interpretation of abstol as for the Hypre solvers
+  Real tol = reltol;
+  if (abstol > 0.0 && bnorm > 0.0) {
+    Real volume = 0.0;
+    for (int i = 0; i < grids.size(); i++) {
+      volume += grids[i].numPts();
+    }
+    tol = std::max(tol, abstol / bnorm * sqrt(volume));
+  }
+
+  int num_iterations = mg.solve(x, b, tol, setup_maxiter);
+  num_iterations_last = num_iterations;
+
+  MultiFab::Copy(dest, x, 0, icomp, 1, 0);
+
+  const Real res = mg.finalRelativeResidual();
+
+  if (verbose >= 2 && ParallelDescriptor::IOProcessor() &&
+      num_iterations >= verbose_threshold) {
+    int oldprec = std::cout.precision(20);
+    std::cout << num_iterations
+              << " Native Multigrid Iterations, Relative Residual "
+              << res << std::endl;
+    std::cout.precision(oldprec);
+  }
+
+  // The solution is returned either way, as with the Hypre solvers, and
+  // getAbsoluteResidual reports the residual actually reached.
+
+  if (mg.brokeDown()) {
+    if (ParallelDescriptor::IOProcessor()) {
+      std::cout << "NativeABec: conjugate gradient breakdown after "
+                << num_iterations << " iterations, relative residual "
+                << res << std::endl;
+    }
+  }
+  else if (res > tol && verbose >= 1 && ParallelDescriptor::IOProcessor()) {
+    std::cout << "NativeABec: not converged after "
+              << num_iterations << " iterations, relative residual "
+              << res << std::endl;
+  }
+}
+
+Real NativeABec::getAbsoluteResidual()
+{
+  BL_PROFILE("NativeABec::getAbsoluteResidual");
+
+  const BoxArray& grids = acoefs->boxArray();
+  Real volume = 0.0;
+  for (int i = 0; i < grids.size(); i++) {
+    volume += grids[i].numPts();
+  }
+
+  return bnorm * mg.finalRelativeResidual() / sqrt(volume);
+}
@@ -0,0 +1,112 @@
+#include <AMReX_ParmParse.H>
+
+#include "Radiation.H"
+
+#include "RAD_F.H"
+
+#include <iostream>
+
+using namespace amrex;
+
+// Tabulate the Planck and Rosseland means of opacity_table_module for
+// every group.  With MPI the table lives in a shared memory window of
+// the ranks on a node: they fill the groups in turn and then read it
+// in place, so a node holds one copy however many ranks it runs.
+
+void Radiation::init_opacity_cache()
+{
+  BL_PROFILE("Radiation::init_opacity_cache");
+
+#ifdef NEUTRINO
+  amrex::Error("radiation.use_opacity_cache is only available for photons");
+#endif
+
+  if (!use_opacity_table_module) {
+    amrex::Error("radiation.use_opacity_cache requires radiation.use_opacity_table_module = 1");
+  }
+
+  ParmParse pp("radiation");
+
+  int nrho = 256, ntemp = 256;
+  pp.query("opacity_cache_nrho", nrho);
+  pp.query("opacity_cache_ntemp", ntemp);
+
+  // the table range has to cover the problem; outside it the
+  // opacities are those of the nearest table edge
+  Real rho_lo, rho_hi, temp_lo, temp_hi;
+  pp.get("opacity_cache_rho_min", rho_lo);
+  pp.get("opacity_cache_rho_max", rho_hi);
+  pp.get("opacity_cache_temp_min", temp_lo);
+  pp.get("opacity_cache_temp_max", temp_hi);
+
+  if (rho_lo <= 0.0 || rho_hi <= rho_lo || temp_lo <= 0.0 || temp_hi <= temp_lo) {
+    amrex::Error("radiation.opacity_cache: invalid rho or T range");
+  }
+
+  ca_init_opacity_cache(&nrho, &ntemp, &rho_lo, &rho_hi, &temp_lo, &temp_hi);
+
+  const long ntab = long(nrho) * long(ntemp) * 2 * nGroups;
+
+  Real strt_time = ParallelDescriptor::second();
+
+#ifdef BL_USE_MPI
+  MPI_Comm_split_type(ParallelDescriptor::Communicator(), MPI_COMM_TYPE_SHARED,
+                      0, MPI_INFO_NULL, &opacity_cache_comm);
+
+  int node_rank, node_size;
+  MPI_Comm_rank(opacity_cache_comm, &node_rank);
+  MPI_Comm_size(opacity_cache_comm, &node_size);
+
+  // rank 0 of the node owns the memory
+  MPI_Aint bytes = (node_rank == 0) ? ntab * sizeof(Real) : 0;
+  Real* base;
+  MPI_Win_allocate_shared(bytes, sizeof(Real), MPI_INFO_NULL,
+                          opacity_cache_comm, &base, &opacity_cache_win);
+
+  MPI_Aint size;
+  int disp_unit;
+  MPI_Win_shared_query(opacity_cache_win, 0, &size, &disp_unit, &opacity_cache_data);
+
+  MPI_Win_fence(0, opacity_cache_win);
+  for (int g = node_rank; g < nGroups; g += node_size) {
+    ca_fill_opacity_cache(opacity_cache_data, g);
+  }
+  MPI_Win_fence(0, opacity_cache_win);
+#else
+  opacity_cache_local.resize(ntab);
+  opacity_cache_data = opacity_cache_local.dataPtr();
+  for (int g = 0; g < nGroups; g++) {
+    ca_fill_opacity_cache(opacity_cache_data, g);
+  }
+#endif
+
+  ca_set_opacity_cache(opacity_cache_data);
+
+  if (verbose >= 1) {
+    Real run_time = ParallelDescriptor::second() - strt_time;
+    ParallelDescriptor::ReduceRealMax(run_time, ParallelDescriptor::IOProcessorNumber());
+    if (ParallelDescriptor::IOProcessor()) {
+      std::cout << "Opacity cache: " << nrho << " x " << ntemp << " x "
+                << nGroups << " groups, " << ntab * sizeof(Real) / (1024*1024)
+                << " MB per node, built in " << run_time << " s" << std::endl;
+    }
+  }
+}
+
+void Radiation::free_opacity_cache()
+{
+  if (opacity_cache_data == 0) {
+    return;
+  }
+
+  ca_set_opacity_cache(0);
+
+#ifdef BL_USE_MPI
+  MPI_Win_free(&opacity_cache_win);
+  MPI_Comm_free(&opacity_cache_comm);
+#else
+  opacity_cache_local.clear();
+#endif
+
+  opacity_cache_data = 0;
+}
@@ -9,6 +9,8 @@
 #include "Radiation.H"  // for access to static physical constants only
 
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -23,19 +25,21 @@ using namespace amrex;
 Vector<Real> RadSolve::absres(0);
 
 RadSolve::RadSolve(Amr* Parent) : parent(Parent),
-  hd(NULL), hm(NULL)
+  hd(NULL), hm(NULL), my_group_block(0), block_comm(MPI_COMM_NULL), hd_level(NULL)
 {
   ParmParse pp("radsolve");
 
-  if (BL_SPACEDIM == 1) {
-    // pfmg will not work in 1D
-    level_solver_flag            = 0;
-  }
-  else {
-    level_solver_flag            = 1;
-  }
+  // The native multigrid solver is the default; the Hypre solvers
+  // (0-6, and >= 100 for the multilevel ones) need USE_HYPRE = TRUE.
+  level_solver_flag = 10;
   pp.query("level_solver_flag",            level_solver_flag);
 
+#ifndef HAS_HYPRE
+  if (level_solver_flag != 10) {
+    amrex::Error("radsolve.level_solver_flag other than 10 needs Castro built with USE_HYPRE = TRUE");
+  }
+#endif
+
   use_hypre_nonsymmetric_terms = 0;
   pp.query("use_hypre_nonsymmetric_terms", use_hypre_nonsymmetric_terms);
 
@@ -71,12 +75,32 @@ RadSolve::RadSolve(Amr* Parent) : parent(Parent),
   pp.query("abstol",  abstol);
   maxiter    = 40;        pp.query("maxiter", maxiter);
 
+  forcing_term  = 0;      pp.query("forcing_term", forcing_term);
+  forcing_max   = 0.1;    pp.query("forcing_max", forcing_max);
+  forcing_gamma = 0.9;    pp.query("forcing_gamma", forcing_gamma);
+  forcing_alpha = 2.0;    pp.query("forcing_alpha", forcing_alpha);
+  forcing_eta   = -1.0;
+
+  num_linear_solves = 0;
+  num_linear_iterations = 0;
+
   // For the radiation problem these are always +1:
   alpha = 1.0; pp.query("alpha",alpha);
   beta  = 1.0; pp.query("beta",beta);
 
   verbose = 0; pp.query("v", verbose); pp.query("verbose", verbose);
 
+  n_group_blocks = 1; pp.query("n_group_blocks", n_group_blocks);
+  if (n_group_blocks > 1) {
+    if (Radiation::SolverType != Radiation::MGFLDSolver ||
+        level_solver_flag >= 100 || level_solver_flag == 10) {
+      amrex::Error("radsolve.n_group_blocks > 1 requires the MGFLD solver and a Hypre level_solver_flag < 100");
+    }
+    n_group_blocks = std::min(n_group_blocks, ParallelDescriptor::NProcs());
+    n_group_blocks = std::min(n_group_blocks, Radiation::nGroups);
+  }
+  n_group_blocks = std::max(n_group_blocks, 1);
+
   {
     // Putting this here is a kludge, but I make the factors static and
     // enter them here for both kinds of solvers so that any solver
@@ -90,8 +114,10 @@ RadSolve::RadSolve(Amr* Parent) : parent(Parent),
     ParmParse pp1("radiation");
     Real c = Radiation::clight;
     pp1.query("c", c);
-    HypreABec::fluxFactor() = c;
+    ABecLevel::fluxFactor() = c;
+#ifdef HAS_HYPRE
     HypreMultiABec::fluxFactor() = c;
+#endif
   }
 
   static int first = 1;
@@ -101,9 +127,11 @@ RadSolve::RadSolve(Amr* Parent) : parent(Parent),
     std::cout << "radsolve.maxiter                = " << maxiter << std::endl;
     std::cout << "radsolve.reltol                 = " << reltol << std::endl;
     std::cout << "radsolve.abstol                 = " << abstol << std::endl;
+    std::cout << "radsolve.forcing_term           = " << forcing_term << std::endl;
     std::cout << "radsolve.use_hypre_nonsymmetric_terms = "
          << use_hypre_nonsymmetric_terms << std::endl;
     std::cout << "radsolve.verbose                = " << verbose << std::endl;
+    std::cout << "radsolve.n_group_blocks         = " << n_group_blocks << std::endl;
   }
 
   // Static initialization:
@@ -119,7 +147,11 @@ void RadSolve::levelInit(int level)
   const DistributionMapping& dmap = parent->DistributionMap(level);
 //  const Real *dx = parent->Geom(level).CellSize();
 
-  if (level_solver_flag < 100) {
+  if (level_solver_flag == 10) {
+      hd = new NativeABec(grids, dmap, parent->Geom(level));
+  }
+#ifdef HAS_HYPRE
+  else if (level_solver_flag < 100) {
       hd = new HypreABec(grids, dmap, parent->Geom(level), level_solver_flag);
   }
   else {
@@ -137,6 +169,112 @@ void RadSolve::levelInit(int level)
                    IntVect::TheUnitVector());
       hm->buildMatrixStructure();
   }
+#endif
+
+  hd_level = hd;
+
+  forcing_eta = -1.0;
+  num_linear_solves = 0;
+  num_linear_iterations = 0;
+
+  if (n_group_blocks > 1) {
+      const int nprocs = ParallelDescriptor::NProcs();
+      const int myproc = ParallelDescriptor::MyProc();
+
+      // Block ib gets the processors [ib*nprocs/n, (ib+1)*nprocs/n).
+      // Each grid goes to the processor of that block that corresponds
+      // to its owner on the level, so the level load balance carries over.
+
+      my_group_block = 0;
+      while ((my_group_block+1)*nprocs/n_group_blocks <= myproc) {
+	  my_group_block++;
+      }
+      MPI_Comm_split(ParallelDescriptor::Communicator(), my_group_block, myproc,
+		     &block_comm);
+
+      block_dmap.resize(n_group_blocks);
+      hd_block.resize(n_group_blocks);
+      Er_block.resize(n_group_blocks);
+      rhs_block.resize(n_group_blocks);
+      group_of_block.resize(n_group_blocks, -1);
+
+      for (int ib = 0; ib < n_group_blocks; ib++) {
+	  const int plo = ib*nprocs/n_group_blocks;
+	  const int np  = (ib+1)*nprocs/n_group_blocks - plo;
+
+	  Vector<int> pmap(grids.size());
+	  for (int i = 0; i < grids.size(); i++) {
+	      pmap[i] = plo + static_cast<int>((static_cast<long>(dmap[i]) * np) / nprocs);
+	  }
+	  block_dmap[ib] = DistributionMapping(pmap);
+
+#ifdef HAS_HYPRE
+	  MPI_Comm comm = (ib == my_group_block) ? block_comm : MPI_COMM_NULL;
+	  hd_block[ib].reset(new HypreABec(grids, block_dmap[ib], parent->Geom(level),
+					   level_solver_flag, comm));
+#endif
+	  Er_block[ib].reset(new MultiFab(grids, block_dmap[ib], 1, 0));
+	  rhs_block[ib].reset(new MultiFab(grids, block_dmap[ib], 1, 0));
+      }
+  }
+}
+
+void RadSolve::selectGroupBlock(int ib)
+{
+  if (n_group_blocks > 1) {
+    hd = (ib < 0) ? hd_level : hd_block[ib].get();
+  }
+}
+
+void RadSolve::setGroupBlockData(int ib, const MultiFab& Er, int igroup,
+                                 const MultiFab& rhs)
+{
+  BL_PROFILE("RadSolve::setGroupBlockData");
+
+  Er_block[ib]->copy(Er, igroup, 0, 1);
+  rhs_block[ib]->copy(rhs, 0, 0, 1);
+  group_of_block[ib] = igroup;
+}
+
+void RadSolve::levelSolveGroupBlocks(int level, int nblocks, Real sync_absres_factor)
+{
+  BL_PROFILE("RadSolve::levelSolveGroupBlocks");
+
+  // Each processor only takes part in the solve of its own block, so
+  // the blocks run concurrently.
+  if (my_group_block < nblocks) {
+    hd = hd_block[my_group_block].get();
+    levelSolve(level, *Er_block[my_group_block], 0, *rhs_block[my_group_block],
+               sync_absres_factor, group_of_block[my_group_block]);
+    hd = hd_level;
+  }
+
+  ParallelDescriptor::ReduceRealMax(absres[level]);
+}
+
+void RadSolve::getGroupBlockData(int level, int ib, MultiFab& Er, int igroup,
+                                 Tuple<MultiFab, BL_SPACEDIM>& Flux)
+{
+  BL_PROFILE("RadSolve::getGroupBlockData");
+
+  Er.copy(*Er_block[ib], 0, igroup, 1);
+
+  // The fluxes need the coefficients and boundary data of the block,
+  // so they are computed on its distribution and copied back.
+  hd = hd_block[ib].get();
+
+  Tuple<MultiFab, BL_SPACEDIM> Flux_block;
+  for (int n = 0; n < BL_SPACEDIM; n++) {
+    Flux_block[n].define(Flux[n].boxArray(), block_dmap[ib], 1, 0);
+  }
+
+  levelFlux(level, Flux_block, *Er_block[ib], 0);
+
+  for (int n = 0; n < BL_SPACEDIM; n++) {
+    Flux[n].copy(Flux_block[n]);
+  }
+
+  hd = hd_level;
 }
 
 void RadSolve::levelBndry(RadBndry& bd)
@@ -146,9 +284,11 @@ void RadSolve::levelBndry(RadBndry& bd)
   if (hd) {
     hd->setBndry(bd);
   }
+#ifdef HAS_HYPRE
   else if (hm) {
     hm->setBndry(hm->crseLevel(), bd);
   }
+#endif
 }
 
 // update multigroup version
@@ -159,21 +299,89 @@ void RadSolve::levelBndry(MGRadBndry& mgbd, const int comp)
   if (hd) {
     hd->setBndry(mgbd, comp);
   }
+#ifdef HAS_HYPRE
   else if (hm) {
     hm->setBndry(hm->crseLevel(), mgbd, comp);
   }
+#endif
 }
 
 void RadSolve::levelClear()
 {
+  hd = hd_level;
+
+  // the solver that ran, for the reports below
+  const char* solver_name = (level_solver_flag == 10) ? "native multigrid" : "Hypre";
+
+  if (verbose >= 1 && (hd || hm)) {
+    long niters = num_linear_iterations;
+    int nsolves = num_linear_solves;
+    if (n_group_blocks > 1) {
+      // every processor of a block counted the solves of its block
+      int block_rank = 0;
+      if (block_comm != MPI_COMM_NULL) {
+        MPI_Comm_rank(block_comm, &block_rank);
+      }
+      if (block_rank != 0) {
+        niters = 0;
+        nsolves = 0;
+      }
+      ParallelDescriptor::ReduceLongSum(niters, ParallelDescriptor::IOProcessorNumber());
+      ParallelDescriptor::ReduceIntSum(nsolves, ParallelDescriptor::IOProcessorNumber());
+    }
+    if (ParallelDescriptor::IOProcessor()) {
+      std::cout << "RadSolve: " << nsolves << " linear solves, "
+                << niters << " linear solver iterations (" << solver_name << ")"
+                << std::endl;
+    }
+  }
+
   if (hd) {
+    if (verbose >= 1) {
+      Real setup_time = hd->setupTime();
+      int nsetup = hd->numSetups();
+      int nreuse = hd->numSetupReuses();
+      if (n_group_blocks > 1) {
+        // report the setups of the processor's own block; all blocks
+        // are reduced with max
+        const ABecLevel& hb = *hd_block[my_group_block];
+        setup_time += hb.setupTime();
+        nsetup += hb.numSetups();
+        nreuse += hb.numSetupReuses();
+        ParallelDescriptor::ReduceIntMax(nsetup,
+                                         ParallelDescriptor::IOProcessorNumber());
+        ParallelDescriptor::ReduceIntMax(nreuse,
+                                         ParallelDescriptor::IOProcessorNumber());
+      }
+      ParallelDescriptor::ReduceRealMax(setup_time,
+                                        ParallelDescriptor::IOProcessorNumber());
+      if (ParallelDescriptor::IOProcessor()) {
+        std::cout << "RadSolve: " << nsetup << " " << solver_name << " setups, "
+                  << nreuse << " reused, setup time = "
+                  << setup_time << std::endl;
+      }
+    }
     delete hd;
     hd = NULL;
+    hd_level = NULL;
   }
+#ifdef HAS_HYPRE
   else if (hm) {
     delete hm;
     hm = NULL;
   }
+#endif
+
+  if (n_group_blocks > 1) {
+    hd_block.clear();
+    Er_block.clear();
+    rhs_block.clear();
+    group_of_block.clear();
+    block_dmap.clear();
+    if (block_comm != MPI_COMM_NULL) {
+      MPI_Comm_free(&block_comm);
+    }
+  }
 }
 
 void RadSolve::cellCenteredApplyMetrics(int level, MultiFab& cc)
@@ -205,9 +413,11 @@ void RadSolve::setLevelACoeffs(int level, const MultiFab& acoefs)
     if (hd) {
 	hd->aCoefficients(acoefs);
     }
+#ifdef HAS_HYPRE
     else if (hm) {
 	hm->aCoefficients(level, acoefs);
     }
+#endif
 }
 
 void RadSolve::setLevelBCoeffs(int level, const MultiFab& bcoefs, int dir)
@@ -215,19 +425,23 @@ void RadSolve::setLevelBCoeffs(int level, const MultiFab& bcoefs, int dir)
     if (hd) {
 	hd->bCoefficients(bcoefs, dir);
     }
+#ifdef HAS_HYPRE
     else if (hm) {
 	hm->bCoefficients(level, bcoefs, dir);
     }
+#endif
 }
 
 void RadSolve::setLevelCCoeffs(int level, const MultiFab& ccoefs, int dir)
 {
+#ifdef HAS_HYPRE
   if (hm) {
     HypreExtMultiABec *hem = dynamic_cast<HypreExtMultiABec*>(hm);
     if (hem) {
       hem->cCoefficients(level, ccoefs, dir);
     }
   }
+#endif
 }
 
 void RadSolve::levelACoeffs(int level,
@@ -266,9 +480,11 @@ void RadSolve::levelACoeffs(int level,
   if (hd) {
     hd->aCoefficients(acoefs);
   }
+#ifdef HAS_HYPRE
   else if (hm) {
     hm->aCoefficients(level, acoefs);
   }
+#endif
 }
 
 void RadSolve::levelSPas(int level, Tuple<MultiFab, BL_SPACEDIM>& lambda, int igroup, 
@@ -312,10 +528,13 @@ void RadSolve::levelSPas(int level, Tuple<MultiFab, BL_SPACEDIM>& lambda, int ig
       }
   }
 
+#ifdef HAS_HYPRE
   if (hm) {
     hm->SPalpha(level, spa);
   }
-  else if (hd) {
+  else
+#endif
+  if (hd) {
     hd->SPalpha(spa);
   }
   else {
@@ -323,6 +542,68 @@ void RadSolve::levelSPas(int level, Tuple<MultiFab, BL_SPACEDIM>& lambda, int ig
   }
 }
 
+void RadSolve::levelHold(int level, MultiFab& rhs, const MultiFab& Er, int icomp,
+			 const MultiFab& mask)
+{
+  BL_PROFILE("RadSolve::levelHold");
+  BL_ASSERT(mask.nGrow() >= 1);
+
+  if (hd == 0 || hd != hd_level) {
+    amrex::Abort("RadSolve::levelHold: only for the level solvers without group blocks");
+  }
+
+  const Geometry& geom = parent->Geom(level);
+  const Real* dx = geom.CellSize();
+
+  MultiFab Erborder(rhs.boxArray(), rhs.DistributionMap(), 1, 1);
+  Erborder.setVal(0.0);
+  MultiFab::Copy(Erborder, Er, icomp, 0, 1, 0);
+  Erborder.FillBoundary(geom.periodicity());
+
+  MultiFab acoefs(rhs.boxArray(), rhs.DistributionMap(), 1, 0);
+  MultiFab::Copy(acoefs, hd->aCoefficients(), 0, 0, 1, 0);
+
+  Tuple<MultiFab, BL_SPACEDIM> bcoefs;
+  for (int idim = 0; idim < BL_SPACEDIM; idim++) {
+    const MultiFab& b = hd->bCoefficients(idim);
+    bcoefs[idim].define(b.boxArray(), b.DistributionMap(), 1, 0);
+    MultiFab::Copy(bcoefs[idim], b, 0, 0, 1, 0);
+  }
+
+  // the couplings are moved with the b coefficients they had before
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  for (MFIter mfi(rhs,true); mfi.isValid(); ++mfi) {
+    const Box& reg = mfi.tilebox();
+    for (int idim = 0; idim < BL_SPACEDIM; idim++) {
+      ca_hold_cells(ARLIM_3D(reg.loVect()), ARLIM_3D(reg.hiVect()),
+		    BL_TO_FORTRAN_3D(mask[mfi]),
+		    BL_TO_FORTRAN_3D(Erborder[mfi]),
+		    BL_TO_FORTRAN_3D(acoefs[mfi]),
+		    BL_TO_FORTRAN_3D(bcoefs[idim][mfi]),
+		    BL_TO_FORTRAN_3D(rhs[mfi]),
+		    alpha, beta, ZFILL(dx), idim);
+    }
+  }
+
+  for (int idim = 0; idim < BL_SPACEDIM; idim++) {
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(bcoefs[idim],true); mfi.isValid(); ++mfi) {
+      const Box& bx = mfi.tilebox();
+      ca_hold_faces(ARLIM_3D(bx.loVect()), ARLIM_3D(bx.hiVect()),
+		    BL_TO_FORTRAN_3D(mask[mfi]),
+		    BL_TO_FORTRAN_3D(bcoefs[idim][mfi]),
+		    idim);
+    }
+    hd->bCoefficients(bcoefs[idim], idim);
+  }
+
+  hd->aCoefficients(acoefs);
+}
+
 void RadSolve::levelBCoeffs(int level,
                             Tuple<MultiFab, BL_SPACEDIM>& lambda,
                             MultiFab& kappa_r, int kcomp,
@@ -361,9 +642,11 @@ void RadSolve::levelBCoeffs(int level,
     if (hd) {
 	hd->bCoefficients(bcoefs, idim);
     }
+#ifdef HAS_HYPRE
     else if (hm) {
 	hm->bCoefficients(level, bcoefs, idim);
     }
+#endif
   } // -->> over dimension
 }
 
@@ -396,9 +679,11 @@ void RadSolve::levelDCoeffs(int level, Tuple<MultiFab, BL_SPACEDIM>& lambda,
 	    }
 	}
 
+#ifdef HAS_HYPRE
 	HypreExtMultiABec *hem = (HypreExtMultiABec*)hm;
 	hem->d2Coefficients(level, dcoefs, idim);
 	hem->d2Multiplier() = 1.0;
+#endif
     }
 }
 
@@ -457,7 +742,7 @@ void RadSolve::levelRhs(int level, MultiFab& rhs,
 
 void RadSolve::levelSolve(int level,
                           MultiFab& Er, int igroup, MultiFab& rhs,
-                          Real sync_absres_factor)
+                          Real sync_absres_factor, int setup_group)
 {
   BL_PROFILE("RadSolve::levelSolve");
 
@@ -465,13 +750,20 @@ void RadSolve::levelSolve(int level,
   if (hd) {
     hd->setScalars(alpha, beta);
   }
+#ifdef HAS_HYPRE
   else if (hm) {
     hm->setScalars(alpha, beta);
   }
+#endif
+
+  const Real linear_reltol = linearRelTol();
 
   if (hd) {
-    hd->setupSolver(reltol, abstol, maxiter);
+    hd->setSetupGroup(setup_group);
+    hd->setupSolver(linear_reltol, abstol, maxiter);
     hd->solve(Er, igroup, rhs, Inhomogeneous_BC);
+    num_linear_solves++;
+    num_linear_iterations += hd->getNumIterations();
     Real res = hd->getAbsoluteResidual();
     if (verbose >= 2 && ParallelDescriptor::IOProcessor()) {
       int oldprec = std::cout.precision(20);
@@ -480,15 +772,20 @@ void RadSolve::levelSolve(int level,
     }
     res *= sync_absres_factor;
     absres[level] = (absres[level] > res) ? absres[level] : res;
-    hd->clearSolver();
+    if (!hd->reuseSetup()) {
+      hd->clearSolver();
+    }
   }
+#ifdef HAS_HYPRE
   else if (hm) {
     hm->loadMatrix();
     hm->finalizeMatrix();
     hm->loadLevelVectors(level, Er, igroup, rhs, Inhomogeneous_BC);
     hm->finalizeVectors();
-    hm->setupSolver(reltol, abstol, maxiter);
+    hm->setupSolver(linear_reltol, abstol, maxiter);
     hm->solve();
+    num_linear_solves++;
+    num_linear_iterations += hm->getNumIterations();
     hm->getSolution(level, Er, igroup);
     Real res = hm->getAbsoluteResidual();
     if (verbose >= 2 && ParallelDescriptor::IOProcessor()) {
@@ -500,6 +797,42 @@ void RadSolve::levelSolve(int level,
     absres[level] = (absres[level] > res) ? absres[level] : res;
     hm->clearSolver();
   }
+#endif
+}
+
+void RadSolve::updateForcingTerm(Real res, Real res_prev,
+                                 Real res_target, Real outer_res)
+{
+  if (!forcing_term) {
+    return;
+  }
+
+  Real eta = forcing_max;
+
+  if (res > 0.0 && res_prev > 0.0 && forcing_eta > 0.0) {
+    // Eisenstat and Walker (1996), choice 2, with their safeguard
+    // against dropping the tolerance too fast
+    eta = forcing_gamma * std::pow(res / res_prev, forcing_alpha);
+    Real eta_safe = forcing_gamma * std::pow(forcing_eta, forcing_alpha);
+    if (eta_safe > 0.1) {
+      eta = std::max(eta, eta_safe);
+    }
+    // no need to solve beyond what the nonlinear tolerance asks for
+    eta = std::max(eta, 0.5 * res_target / res);
+  }
+
+  eta = std::min(eta, forcing_max);
+
+  // tighten as the outer iteration converges
+  if (outer_res > 0.0) {
+    eta = std::min(eta, outer_res);
+  }
+
+  forcing_eta = std::max(eta, reltol);
+
+  if (verbose >= 2 && ParallelDescriptor::IOProcessor()) {
+    std::cout << "RadSolve: linear relative tolerance = " << forcing_eta << std::endl;
+  }
 }
 
 void RadSolve::levelFluxFaceToCenter(int level, const Tuple<MultiFab, BL_SPACEDIM>& Flux,
@@ -541,11 +874,10 @@ void RadSolve::levelFlux(int level,
                          MultiFab& Er, int igroup)
 {
   BL_PROFILE("RadSolve::levelFlux");
-  const BoxArray& grids = parent->boxArray(level);
-  const DistributionMapping& dmap = parent->DistributionMap(level);
 
   // grow a larger MultiFab to hold Er so we can difference across faces
-  MultiFab Erborder(grids, dmap, 1, 1);
+  // (Er may be the copy of one group for a group block)
+  MultiFab Erborder(Er.boxArray(), Er.DistributionMap(), 1, 1);
   Erborder.setVal(0.0);
   MultiFab::Copy(Erborder, Er, igroup, 0, 1, 0);
 
@@ -561,9 +893,11 @@ void RadSolve::levelFlux(int level,
     if (hd) {
       bp = &hd->bCoefficients(n);
     }
+#ifdef HAS_HYPRE
     else if (hm) {
       bp = &hm->bCoefficients(level, n);
     }
+#endif
     // w.z. I commented this out because we may not always have ccoef 
     //      when use_hypre_nonsymmetric_terms == 1.
     //      And ccoef is not being used anyway.
@@ -597,9 +931,11 @@ void RadSolve::levelFlux(int level,
   if (hd) {
     hd->boundaryFlux(&Flux[0], Er, igroup, Inhomogeneous_BC);
   }
+#ifdef HAS_HYPRE
   else if (hm) {
     hm->boundaryFlux(level, &Flux[0], Er, igroup, Inhomogeneous_BC);
   }
+#endif
   if (use_hypre_nonsymmetric_terms == 1) {
     //HypreExtMultiABec *hem = (HypreExtMultiABec*)hm;
     //hem->boundaryFlux(level, &Flux[0], Er);
@@ -649,12 +985,16 @@ void RadSolve::levelDterm(int level, MultiFab& Dterm, MultiFab& Er, int igroup)
   }
 
   // grow a larger MultiFab to hold Er so we can difference across faces
-  MultiFab Erborder(grids, dmap, 1, 1);
+  // (Er may be the copy of one group for a group block)
+  MultiFab Erborder(Er.boxArray(), Er.DistributionMap(), 1, 1);
   Erborder.setVal(0.0);
   MultiFab::Copy(Erborder, Er, igroup, 0, 1, 0);
 
   Erborder.FillBoundary(parent->Geom(level).periodicity()); // zeroes left in off-level boundaries
 
+  // The D terms only come with use_hypre_nonsymmetric_terms, which
+  // needs the Hypre multilevel solver.
+#ifdef HAS_HYPRE
   HypreExtMultiABec *hem = (HypreExtMultiABec*)hm;
 
 #ifdef _OPENMP
@@ -678,6 +1018,9 @@ void RadSolve::levelDterm(int level, MultiFab& Dterm, MultiFab& Er, int igroup)
 
   // Correct D terms at physical and coarse-fine boundaries.
   hem->boundaryDterm(level, &Dterm_face[0], Er, igroup);
+#else
+  amrex::Abort("RadSolve::levelDterm needs Castro built with USE_HYPRE = TRUE");
+#endif
 
 #ifdef _OPENMP
 #pragma omp parallel
@@ -809,9 +1152,11 @@ void RadSolve::levelACoeffs(int level, MultiFab& kpp,
   if (hd) {
     hd->aCoefficients(acoefs);
   }
+#ifdef HAS_HYPRE
   else if (hm) {
     hm->aCoefficients(level,acoefs);
   }
+#endif
 }
 
 
@@ -900,22 +1245,26 @@ void RadSolve::levelRhs(int level, MultiFab& rhs, const MultiFab& jg,
 
 void RadSolve::setHypreMulti(Real cMul, Real d1Mul, Real d2Mul)
 {
+#ifdef HAS_HYPRE
   HypreExtMultiABec *hem = dynamic_cast<HypreExtMultiABec*>(hm);
   if (hem) {
     hem-> cMultiplier() =  cMul;
     hem->d1Multiplier() = d1Mul;
     hem->d2Multiplier() = d2Mul;
   }
+#endif
 }
 
 void RadSolve::restoreHypreMulti()
 {
+#ifdef HAS_HYPRE
   HypreExtMultiABec *hem = dynamic_cast<HypreExtMultiABec*>(hm);
   if (hem) {
     hem-> cMultiplier() =  cMulti;
     hem->d1Multiplier() = d1Multi;
     hem->d2Multiplier() = d2Multi;  
   }
+#endif
 }
 
 void RadSolve::getCellCenterMetric(const Geometry& geom, const Box& reg, Vector<Real>& r, Vector<Real>& s)
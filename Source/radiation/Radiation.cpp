@@ -522,6 +522,24 @@ Radiation::Radiation(Amr* Parent, Castro* castro, int restart)
   skipAccelAllowed = 0;
   pp.query("skipAccelAllowed", skipAccelAllowed);
 
+  anderson_depth = 0;
+  pp.query("anderson_depth", anderson_depth);
+
+  adaptive_groups = 0;
+  pp.query("adaptive_groups", adaptive_groups);
+  adaptive_groups_tau = 10.0;
+  pp.query("adaptive_groups_tau", adaptive_groups_tau);
+  adaptive_groups_tol = 1.e-2;
+  pp.query("adaptive_groups_tol", adaptive_groups_tol);
+#ifdef NEUTRINO
+  if (adaptive_groups) {
+    amrex::Error("radiation.adaptive_groups is only available for photons");
+  }
+#endif
+  if (adaptive_groups && accelerate != 2) {
+    amrex::Error("radiation.adaptive_groups needs the gray acceleration (radiation.accelerate = 2)");
+  }
+
   matter_update_type = 0;
   pp.query("matter_update_type", matter_update_type);
 
@@ -558,6 +576,10 @@ Radiation::Radiation(Amr* Parent, Castro* castro, int restart)
   use_opacity_table_module = 0;
   pp.query("use_opacity_table_module", use_opacity_table_module);
 
+  use_opacity_cache = 0;
+  pp.query("use_opacity_cache", use_opacity_cache);
+  opacity_cache_data = 0;
+
   do_kappa_stm_emission = 0;
   pp.query("do_kappa_stm_emission", do_kappa_stm_emission);
 
@@ -678,6 +700,8 @@ Radiation::Radiation(Amr* Parent, Castro* castro, int restart)
     std::cout << "do_real_eos = " << do_real_eos << std::endl;
     std::cout << "do_multigroup = " << do_multigroup << std::endl;
     std::cout << "accelerate = " << accelerate << std::endl;
+    std::cout << "anderson_depth = " << anderson_depth << std::endl;
+    std::cout << "adaptive_groups = " << adaptive_groups << std::endl;
     std::cout << "verbose  = " << verbose << std::endl;
     if (RadTests::do_thermal_wave_cgs)
       std::cout << "do_thermal_wave_cgs = " << RadTests::do_thermal_wave_cgs << std::endl;
@@ -720,6 +744,10 @@ Radiation::Radiation(Amr* Parent, Castro* castro, int restart)
       FORT_INIT_OPACITY_TABLE(iverb);
     }
 #endif
+
+    if (use_opacity_cache) {
+      init_opacity_cache();
+    }
   }
   else {
     ca_initsinglegroup(nGroups);
@@ -1433,7 +1461,6 @@ void Radiation::getBndryDataMG(MGRadBndry& mgbd, MultiFab& Er,
   BL_PROFILE("Radiation::getBndryDataMG");
   Castro *castro = dynamic_cast<Castro*>(&parent->getLevel(level));
   const BoxArray& grids = castro->boxArray();
-  const DistributionMapping& dmap = castro->DistributionMap();
 
   if(level == 0) {
     mgbd.setBndryValues(Er, 0, 0, Radiation::nGroups, rad_bc);
@@ -1442,7 +1469,8 @@ void Radiation::getBndryDataMG(MGRadBndry& mgbd, MultiFab& Er,
     BoxArray cgrids(grids);
     IntVect crse_ratio = parent->refRatio(level-1);
     cgrids.coarsen(crse_ratio);
-    BndryRegister crse_br(cgrids, dmap, 0, 1, 1, Radiation::nGroups);
+    // Er need not have the level's distribution (group blocks)
+    BndryRegister crse_br(cgrids, Er.DistributionMap(), 0, 1, 1, Radiation::nGroups);
     crse_br.setVal(1.0e30);
     filBndry(crse_br, level-1, time);
 
@@ -2320,6 +2348,64 @@ void Radiation::fluxLimiter(int level,
   }
 }
 
+// Scaled gradients and flux limiters of all the groups, with one kernel
+// call (scgrd_flxlim) per tile and direction that loops over the groups,
+// as ca_compute_lamborder does for the hydro limiter.  Er must have one
+// ghost cell, filled as for scaledGradient with nGrow_Er = 1 (the kernel
+// indexes Er with the bounds of kappa_r), and lambda has a component
+// for each group.
+
+void Radiation::scaledGradientLimiter(int level,
+                                      Tuple<MultiFab, BL_SPACEDIM>& lambda,
+                                      MultiFab& kappa_r, MultiFab& Er,
+                                      int limiter)
+{
+  BL_PROFILE("Radiation::scaledGradientLimiter");
+  BL_ASSERT(kappa_r.nGrow() == 1);
+  BL_ASSERT(Er.nGrow() == kappa_r.nGrow());
+
+  const int ngroups = Er.nComp();
+  const Real* dx = parent->Geom(level).CellSize();
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+      FArrayBox dtmp;
+      for (int idim = 0; idim < BL_SPACEDIM; idim++) {
+
+	  for (MFIter mfi(lambda[idim],true); mfi.isValid(); ++mfi) {
+	      const Box &nbox  = mfi.tilebox();  // note that lambda is edge based
+	      const Box& reg = amrex::enclosedCells(nbox);
+
+	      if (limiter == 0) {
+		  lambda[idim][mfi].setVal(1./3., nbox, 0, ngroups);
+		  continue;
+	      }
+
+#if (BL_SPACEDIM >= 2)
+	      const Box& dbox = amrex::grow(reg,1);
+	      dtmp.resize(dbox, BL_SPACEDIM - 1);
+#endif
+
+	      scgrd_flxlim(BL_TO_FORTRAN(lambda[idim][mfi]), ngroups,
+			   ARLIM(reg.loVect()), ARLIM(reg.hiVect()),
+			   ARLIM(nbox.loVect()), ARLIM(nbox.hiVect()),
+			   idim,
+			   BL_TO_FORTRAN(kappa_r[mfi]),
+			   Er[mfi].dataPtr(),
+#if (BL_SPACEDIM >= 2)
+			   ARLIM(dbox.loVect()), ARLIM(dbox.hiVect()), dtmp.dataPtr(0),
+#endif
+#if (BL_SPACEDIM == 3)
+			   dtmp.dataPtr(1),
+#endif
+			   dx, limiter);
+	  }
+      }
+  }
+}
+
 void Radiation::get_rosseland_v_dcf(MultiFab& kappa_r, MultiFab& v, MultiFab& dcf,
 				    Real delta_t, Real c,
 				    AmrLevel* castro, int igroup)
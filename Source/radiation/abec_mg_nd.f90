@@ -0,0 +1,288 @@
+! Kernels for the native cell-centered multigrid solver (ABecMG) used
+! for the radiation diffusion equation.
+!
+! The operator is kept as a symmetric stencil with 4 components per
+! cell: st(:,:,:,1:3) couple a cell to its lower neighbor in x, y and
+! z (zero in unused dimensions), and st(:,:,:,4) is the diagonal.  The
+! coupling to the upper neighbor is the lower coupling of that neighbor.
+
+subroutine ca_abecmg_residual(lo, hi, &
+                              st, st_lo, st_hi, &
+                              x, x_lo, x_hi, &
+                              b, b_lo, b_hi, &
+                              r, r_lo, r_hi) bind(C, name="ca_abecmg_residual")
+
+  ! r = b - A x; st and x need one ghost cell in the active dimensions
+
+  use prob_params_module, only : dg
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: st_lo(3), st_hi(3)
+  integer,  intent(in   ) :: x_lo(3), x_hi(3)
+  integer,  intent(in   ) :: b_lo(3), b_hi(3)
+  integer,  intent(in   ) :: r_lo(3), r_hi(3)
+  real(rt), intent(in   ) :: st(st_lo(1):st_hi(1),st_lo(2):st_hi(2),st_lo(3):st_hi(3),4)
+  real(rt), intent(in   ) :: x(x_lo(1):x_hi(1),x_lo(2):x_hi(2),x_lo(3):x_hi(3))
+  real(rt), intent(in   ) :: b(b_lo(1):b_hi(1),b_lo(2):b_hi(2),b_lo(3):b_hi(3))
+  real(rt), intent(inout) :: r(r_lo(1):r_hi(1),r_lo(2):r_hi(2),r_lo(3):r_hi(3))
+
+  integer :: i, j, k
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+           r(i,j,k) = b(i,j,k) - st(i,j,k,4) * x(i,j,k) &
+                - st(i   ,j,k,1) * x(i-1,j,k) - st(i+1,j,k,1) * x(i+1,j,k)
+           if (dg(2) == 1) then
+              r(i,j,k) = r(i,j,k) &
+                   - st(i,j   ,k,2) * x(i,j-1,k) - st(i,j+1,k,2) * x(i,j+1,k)
+           endif
+           if (dg(3) == 1) then
+              r(i,j,k) = r(i,j,k) &
+                   - st(i,j,k   ,3) * x(i,j,k-1) - st(i,j,k+1,3) * x(i,j,k+1)
+           endif
+        enddo
+     enddo
+  enddo
+
+end subroutine ca_abecmg_residual
+
+
+
+subroutine ca_abecmg_apply(lo, hi, &
+                           st, st_lo, st_hi, &
+                           x, x_lo, x_hi, &
+                           y, y_lo, y_hi) bind(C, name="ca_abecmg_apply")
+
+  ! y = A x
+
+  use prob_params_module, only : dg
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: st_lo(3), st_hi(3)
+  integer,  intent(in   ) :: x_lo(3), x_hi(3)
+  integer,  intent(in   ) :: y_lo(3), y_hi(3)
+  real(rt), intent(in   ) :: st(st_lo(1):st_hi(1),st_lo(2):st_hi(2),st_lo(3):st_hi(3),4)
+  real(rt), intent(in   ) :: x(x_lo(1):x_hi(1),x_lo(2):x_hi(2),x_lo(3):x_hi(3))
+  real(rt), intent(inout) :: y(y_lo(1):y_hi(1),y_lo(2):y_hi(2),y_lo(3):y_hi(3))
+
+  integer :: i, j, k
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+           y(i,j,k) = st(i,j,k,4) * x(i,j,k) &
+                + st(i   ,j,k,1) * x(i-1,j,k) + st(i+1,j,k,1) * x(i+1,j,k)
+           if (dg(2) == 1) then
+              y(i,j,k) = y(i,j,k) &
+                   + st(i,j   ,k,2) * x(i,j-1,k) + st(i,j+1,k,2) * x(i,j+1,k)
+           endif
+           if (dg(3) == 1) then
+              y(i,j,k) = y(i,j,k) &
+                   + st(i,j,k   ,3) * x(i,j,k-1) + st(i,j,k+1,3) * x(i,j,k+1)
+           endif
+        enddo
+     enddo
+  enddo
+
+end subroutine ca_abecmg_apply
+
+
+
+subroutine ca_abecmg_gsrb(lo, hi, &
+                          st, st_lo, st_hi, &
+                          x, x_lo, x_hi, &
+                          b, b_lo, b_hi, color) bind(C, name="ca_abecmg_gsrb")
+
+  ! One Gauss-Seidel sweep over the cells with mod(i+j+k,2) == color.
+
+  use prob_params_module, only : dg
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: st_lo(3), st_hi(3)
+  integer,  intent(in   ) :: x_lo(3), x_hi(3)
+  integer,  intent(in   ) :: b_lo(3), b_hi(3)
+  integer,  intent(in   ), value :: color
+  real(rt), intent(in   ) :: st(st_lo(1):st_hi(1),st_lo(2):st_hi(2),st_lo(3):st_hi(3),4)
+  real(rt), intent(inout) :: x(x_lo(1):x_hi(1),x_lo(2):x_hi(2),x_lo(3):x_hi(3))
+  real(rt), intent(in   ) :: b(b_lo(1):b_hi(1),b_lo(2):b_hi(2),b_lo(3):b_hi(3))
+
+  integer  :: i, j, k, ioff
+  real(rt) :: res
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        ioff = mod(lo(1) + j + k + color, 2)
+        do i = lo(1) + ioff, hi(1), 2
+           res = b(i,j,k) &
+                - st(i   ,j,k,1) * x(i-1,j,k) - st(i+1,j,k,1) * x(i+1,j,k)
+           if (dg(2) == 1) then
+              res = res &
+                   - st(i,j   ,k,2) * x(i,j-1,k) - st(i,j+1,k,2) * x(i,j+1,k)
+           endif
+           if (dg(3) == 1) then
+              res = res &
+                   - st(i,j,k   ,3) * x(i,j,k-1) - st(i,j,k+1,3) * x(i,j,k+1)
+           endif
+           x(i,j,k) = res / st(i,j,k,4)
+        enddo
+     enddo
+  enddo
+
+end subroutine ca_abecmg_gsrb
+
+
+
+subroutine ca_abecmg_coarsen(lo, hi, &
+                             stf, f_lo, f_hi, &
+                             stc, c_lo, c_hi) bind(C, name="ca_abecmg_coarsen")
+
+  ! Galerkin coarse operator P^T A P for piecewise constant P over the
+  ! 2**dim children of each coarse cell.  lo and hi are coarse indices.
+
+  use prob_params_module, only : dg
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: f_lo(3), f_hi(3)
+  integer,  intent(in   ) :: c_lo(3), c_hi(3)
+  real(rt), intent(in   ) :: stf(f_lo(1):f_hi(1),f_lo(2):f_hi(2),f_lo(3):f_hi(3),4)
+  real(rt), intent(inout) :: stc(c_lo(1):c_hi(1),c_lo(2):c_hi(2),c_lo(3):c_hi(3),4)
+
+  integer :: i, j, k, ii, jj, kk, fi, fj, fk
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+
+           stc(i,j,k,:) = 0.0e0_rt
+
+           do kk = 0, dg(3)
+              fk = (1 + dg(3)) * k + kk
+              do jj = 0, dg(2)
+                 fj = (1 + dg(2)) * j + jj
+                 do ii = 0, dg(1)
+                    fi = (1 + dg(1)) * i + ii
+
+                    stc(i,j,k,4) = stc(i,j,k,4) + stf(fi,fj,fk,4)
+
+                    ! children on the low face couple to the lower coarse
+                    ! cell; the others couple to a sibling, which counts
+                    ! twice on the diagonal
+
+                    if (ii == 0) then
+                       stc(i,j,k,1) = stc(i,j,k,1) + stf(fi,fj,fk,1)
+                    else
+                       stc(i,j,k,4) = stc(i,j,k,4) + 2.0e0_rt * stf(fi,fj,fk,1)
+                    endif
+
+                    if (dg(2) == 1) then
+                       if (jj == 0) then
+                          stc(i,j,k,2) = stc(i,j,k,2) + stf(fi,fj,fk,2)
+                       else
+                          stc(i,j,k,4) = stc(i,j,k,4) + 2.0e0_rt * stf(fi,fj,fk,2)
+                       endif
+                    endif
+
+                    if (dg(3) == 1) then
+                       if (kk == 0) then
+                          stc(i,j,k,3) = stc(i,j,k,3) + stf(fi,fj,fk,3)
+                       else
+                          stc(i,j,k,4) = stc(i,j,k,4) + 2.0e0_rt * stf(fi,fj,fk,3)
+                       endif
+                    endif
+
+                 enddo
+              enddo
+           enddo
+
+        enddo
+     enddo
+  enddo
+
+end subroutine ca_abecmg_coarsen
+
+
+
+subroutine ca_abecmg_restrict(lo, hi, &
+                              rf, f_lo, f_hi, &
+                              rc, c_lo, c_hi) bind(C, name="ca_abecmg_restrict")
+
+  ! rc = P^T rf, the sum over the children
+
+  use prob_params_module, only : dg
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: f_lo(3), f_hi(3)
+  integer,  intent(in   ) :: c_lo(3), c_hi(3)
+  real(rt), intent(in   ) :: rf(f_lo(1):f_hi(1),f_lo(2):f_hi(2),f_lo(3):f_hi(3))
+  real(rt), intent(inout) :: rc(c_lo(1):c_hi(1),c_lo(2):c_hi(2),c_lo(3):c_hi(3))
+
+  integer :: i, j, k, ii, jj, kk
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+           rc(i,j,k) = 0.0e0_rt
+           do kk = 0, dg(3)
+              do jj = 0, dg(2)
+                 do ii = 0, dg(1)
+                    rc(i,j,k) = rc(i,j,k) + &
+                         rf((1+dg(1))*i+ii, (1+dg(2))*j+jj, (1+dg(3))*k+kk)
+                 enddo
+              enddo
+           enddo
+        enddo
+     enddo
+  enddo
+
+end subroutine ca_abecmg_restrict
+
+
+
+subroutine ca_abecmg_interp(lo, hi, &
+                            xf, f_lo, f_hi, &
+                            xc, c_lo, c_hi, fac) bind(C, name="ca_abecmg_interp")
+
+  ! xf = xf + fac * P xc, piecewise constant over the children
+
+  use prob_params_module, only : dg
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: f_lo(3), f_hi(3)
+  integer,  intent(in   ) :: c_lo(3), c_hi(3)
+  real(rt), intent(inout) :: xf(f_lo(1):f_hi(1),f_lo(2):f_hi(2),f_lo(3):f_hi(3))
+  real(rt), intent(in   ) :: xc(c_lo(1):c_hi(1),c_lo(2):c_hi(2),c_lo(3):c_hi(3))
+  real(rt), intent(in   ), value :: fac
+
+  integer :: i, j, k, ii, jj, kk, fi, fj, fk
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+           do kk = 0, dg(3)
+              fk = (1 + dg(3)) * k + kk
+              do jj = 0, dg(2)
+                 fj = (1 + dg(2)) * j + jj
+                 do ii = 0, dg(1)
+                    fi = (1 + dg(1)) * i + ii
+                    xf(fi,fj,fk) = xf(fi,fj,fk) + fac * xc(i,j,k)
+                 enddo
+              enddo
+           enddo
+        enddo
+     enddo
+  enddo
+
+end subroutine ca_abecmg_interp
@@ -0,0 +1,333 @@
+! Kernels for the adaptive group mode of the MGFLD solver
+! (radiation.adaptive_groups).  Zones that are optically thick in every
+! group and whose spectrum is close to the Planck spectrum of the
+! matter are gray: the group solves hold them fixed, and a gray solve
+! restricted to them updates their total radiation energy, which is
+! then spread over the groups with the Planck spectrum.  The Planck
+! spectrum of group g is j_g / kappa_g, i.e., the emissivity
+! integrated over the group boundaries.
+
+subroutine ca_adaptive_groups_flag(lo, hi, &
+                                   Er, Er_lo, Er_hi, &
+                                   kp, kp_lo, kp_hi, &
+                                   kr, kr_lo, kr_hi, &
+                                   jg, jg_lo, jg_hi, &
+                                   inlev, in_lo, in_hi, &
+                                   flag, fl_lo, fl_hi, &
+                                   dxmin, tau_thick, tol) bind(C, name="ca_adaptive_groups_flag")
+
+  ! flag = 1 where the zone is gray, 0 elsewhere.  Zones next to a
+  ! face of the level (inlev = 0 in the ghost cell) keep all groups, so
+  ! the gray solve needs no boundary data.
+
+  use rad_params_module, only : ngroups
+  use prob_params_module, only : dg
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: Er_lo(3), Er_hi(3)
+  integer,  intent(in   ) :: kp_lo(3), kp_hi(3)
+  integer,  intent(in   ) :: kr_lo(3), kr_hi(3)
+  integer,  intent(in   ) :: jg_lo(3), jg_hi(3)
+  integer,  intent(in   ) :: in_lo(3), in_hi(3)
+  integer,  intent(in   ) :: fl_lo(3), fl_hi(3)
+  real(rt), intent(in   ) :: Er(Er_lo(1):Er_hi(1),Er_lo(2):Er_hi(2),Er_lo(3):Er_hi(3),0:ngroups-1)
+  real(rt), intent(in   ) :: kp(kp_lo(1):kp_hi(1),kp_lo(2):kp_hi(2),kp_lo(3):kp_hi(3),0:ngroups-1)
+  real(rt), intent(in   ) :: kr(kr_lo(1):kr_hi(1),kr_lo(2):kr_hi(2),kr_lo(3):kr_hi(3),0:ngroups-1)
+  real(rt), intent(in   ) :: jg(jg_lo(1):jg_hi(1),jg_lo(2):jg_hi(2),jg_lo(3):jg_hi(3),0:ngroups-1)
+  real(rt), intent(in   ) :: inlev(in_lo(1):in_hi(1),in_lo(2):in_hi(2),in_lo(3):in_hi(3))
+  real(rt), intent(inout) :: flag(fl_lo(1):fl_hi(1),fl_lo(2):fl_hi(2),fl_lo(3):fl_hi(3))
+  real(rt), intent(in   ), value :: dxmin, tau_thick, tol
+
+  integer :: i, j, k, g
+  real(rt) :: Bg, Bsum, dev
+  logical :: gray
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+
+           gray = inlev(i-1,j,k) > 0.e0_rt .and. inlev(i+1,j,k) > 0.e0_rt
+           if (dg(2) == 1) then
+              gray = gray .and. inlev(i,j-1,k) > 0.e0_rt .and. inlev(i,j+1,k) > 0.e0_rt
+           end if
+           if (dg(3) == 1) then
+              gray = gray .and. inlev(i,j,k-1) > 0.e0_rt .and. inlev(i,j,k+1) > 0.e0_rt
+           end if
+
+           Bsum = 0.e0_rt
+           dev = 0.e0_rt
+
+           if (gray) then
+              do g = 0, ngroups-1
+                 if (kp(i,j,k,g) <= 0.e0_rt .or. kr(i,j,k,g)*dxmin < tau_thick) then
+                    gray = .false.
+                    exit
+                 end if
+                 Bg = jg(i,j,k,g) / kp(i,j,k,g)
+                 Bsum = Bsum + Bg
+                 dev = dev + abs(Er(i,j,k,g) - Bg)
+              end do
+           end if
+
+           if (gray .and. Bsum > 0.e0_rt .and. dev <= tol * Bsum) then
+              flag(i,j,k) = 1.e0_rt
+           else
+              flag(i,j,k) = 0.e0_rt
+           end if
+
+        end do
+     end do
+  end do
+
+end subroutine ca_adaptive_groups_flag
+
+
+
+subroutine ca_planck_spec(lo, hi, &
+                          kp, kp_lo, kp_hi, &
+                          jg, jg_lo, jg_hi, &
+                          spec, sp_lo, sp_hi) bind(C, name="ca_planck_spec")
+
+  ! spec = fraction of the Planck spectrum in each group
+
+  use rad_params_module, only : ngroups
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: kp_lo(3), kp_hi(3)
+  integer,  intent(in   ) :: jg_lo(3), jg_hi(3)
+  integer,  intent(in   ) :: sp_lo(3), sp_hi(3)
+  real(rt), intent(in   ) :: kp(kp_lo(1):kp_hi(1),kp_lo(2):kp_hi(2),kp_lo(3):kp_hi(3),0:ngroups-1)
+  real(rt), intent(in   ) :: jg(jg_lo(1):jg_hi(1),jg_lo(2):jg_hi(2),jg_lo(3):jg_hi(3),0:ngroups-1)
+  real(rt), intent(inout) :: spec(sp_lo(1):sp_hi(1),sp_lo(2):sp_hi(2),sp_lo(3):sp_hi(3),0:ngroups-1)
+
+  integer :: i, j, k, g
+  real(rt) :: Bsum
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+
+           Bsum = 0.e0_rt
+           do g = 0, ngroups-1
+              if (kp(i,j,k,g) > 0.e0_rt) then
+                 spec(i,j,k,g) = jg(i,j,k,g) / kp(i,j,k,g)
+              else
+                 spec(i,j,k,g) = 0.e0_rt
+              end if
+              Bsum = Bsum + spec(i,j,k,g)
+           end do
+
+           if (Bsum > 0.e0_rt) then
+              spec(i,j,k,:) = spec(i,j,k,:) / Bsum
+           else
+              spec(i,j,k,:) = 1.e0_rt / ngroups
+           end if
+
+        end do
+     end do
+  end do
+
+end subroutine ca_planck_spec
+
+
+
+subroutine ca_gray_sweep_acoe(lo, hi, &
+                              spec, sp_lo, sp_hi, &
+                              kp, kp_lo, kp_hi, &
+                              aco, a_lo, a_hi, &
+                              dt, tau) bind(C, name="ca_gray_sweep_acoe")
+
+  ! a coefficient of the gray equation: the a coefficients of the
+  ! groups summed with the weights in spec (metrics not included)
+
+  use rad_params_module, only : ngroups, clight
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: sp_lo(3), sp_hi(3)
+  integer,  intent(in   ) :: kp_lo(3), kp_hi(3)
+  integer,  intent(in   ) :: a_lo(3), a_hi(3)
+  real(rt), intent(in   ) :: spec(sp_lo(1):sp_hi(1),sp_lo(2):sp_hi(2),sp_lo(3):sp_hi(3),0:ngroups-1)
+  real(rt), intent(in   ) :: kp(kp_lo(1):kp_hi(1),kp_lo(2):kp_hi(2),kp_lo(3):kp_hi(3),0:ngroups-1)
+  real(rt), intent(inout) :: aco(a_lo(1):a_hi(1),a_lo(2):a_hi(2),a_lo(3):a_hi(3))
+  real(rt), intent(in   ), value :: dt, tau
+
+  integer :: i, j, k
+  real(rt) :: dt1
+
+  dt1 = (1.e0_rt+tau)/dt
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+           aco(i,j,k) = clight*sum(spec(i,j,k,:)*kp(i,j,k,:)) + dt1
+        end do
+     end do
+  end do
+
+end subroutine ca_gray_sweep_acoe
+
+
+
+subroutine ca_gray_sweep_update(lo, hi, &
+                                flag, fl_lo, fl_hi, &
+                                spec, sp_lo, sp_hi, &
+                                E, E_lo, E_hi, &
+                                Er, Er_lo, Er_hi) bind(C, name="ca_gray_sweep_update")
+
+  ! Where flag = 1, spread the total radiation energy E over the groups
+  ! with the spectrum in spec.
+
+  use rad_params_module, only : ngroups
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: fl_lo(3), fl_hi(3)
+  integer,  intent(in   ) :: sp_lo(3), sp_hi(3)
+  integer,  intent(in   ) :: E_lo(3), E_hi(3)
+  integer,  intent(in   ) :: Er_lo(3), Er_hi(3)
+  real(rt), intent(in   ) :: flag(fl_lo(1):fl_hi(1),fl_lo(2):fl_hi(2),fl_lo(3):fl_hi(3))
+  real(rt), intent(in   ) :: spec(sp_lo(1):sp_hi(1),sp_lo(2):sp_hi(2),sp_lo(3):sp_hi(3),0:ngroups-1)
+  real(rt), intent(in   ) :: E(E_lo(1):E_hi(1),E_lo(2):E_hi(2),E_lo(3):E_hi(3))
+  real(rt), intent(inout) :: Er(Er_lo(1):Er_hi(1),Er_lo(2):Er_hi(2),Er_lo(3):Er_hi(3),0:ngroups-1)
+
+  integer :: i, j, k
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+           if (flag(i,j,k) > 0.e0_rt) then
+              Er(i,j,k,:) = spec(i,j,k,:) * E(i,j,k)
+           end if
+        end do
+     end do
+  end do
+
+end subroutine ca_gray_sweep_update
+
+
+
+subroutine ca_hold_cells(lo, hi, &
+                         mask, m_lo, m_hi, &
+                         Er, Er_lo, Er_hi, &
+                         a, a_lo, a_hi, &
+                         b, b_lo, b_hi, &
+                         rhs, r_lo, r_hi, &
+                         alpha, beta, dx, idir) bind(C, name="ca_hold_cells")
+
+  ! Hold the cells with mask /= 0 at their value in Er: their rhs is
+  ! set to alpha a Er, and the coupling of every other cell to them
+  ! across the faces of direction idir (0-based) is moved to the
+  ! diagonal and the rhs of that cell.  ca_hold_faces then removes the
+  ! b coefficients of their faces.  mask and Er need one ghost cell.
+
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: m_lo(3), m_hi(3)
+  integer,  intent(in   ) :: Er_lo(3), Er_hi(3)
+  integer,  intent(in   ) :: a_lo(3), a_hi(3)
+  integer,  intent(in   ) :: b_lo(3), b_hi(3)
+  integer,  intent(in   ) :: r_lo(3), r_hi(3)
+  real(rt), intent(in   ) :: mask(m_lo(1):m_hi(1),m_lo(2):m_hi(2),m_lo(3):m_hi(3))
+  real(rt), intent(in   ) :: Er(Er_lo(1):Er_hi(1),Er_lo(2):Er_hi(2),Er_lo(3):Er_hi(3))
+  real(rt), intent(inout) :: a(a_lo(1):a_hi(1),a_lo(2):a_hi(2),a_lo(3):a_hi(3))
+  real(rt), intent(in   ) :: b(b_lo(1):b_hi(1),b_lo(2):b_hi(2),b_lo(3):b_hi(3))
+  real(rt), intent(inout) :: rhs(r_lo(1):r_hi(1),r_lo(2):r_hi(2),r_lo(3):r_hi(3))
+  real(rt), intent(in   ), value :: alpha, beta
+  real(rt), intent(in   ) :: dx(3)
+  integer,  intent(in   ), value :: idir
+
+  integer :: i, j, k, ioff, joff, koff
+  real(rt) :: fac, f
+
+  ioff = 0
+  joff = 0
+  koff = 0
+  if (idir == 0) then
+     ioff = 1
+  else if (idir == 1) then
+     joff = 1
+  else
+     koff = 1
+  end if
+
+  fac = beta / dx(idir+1)**2
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+
+           if (mask(i,j,k) /= 0.e0_rt) then
+              rhs(i,j,k) = alpha * a(i,j,k) * Er(i,j,k)
+              cycle
+           end if
+
+           if (mask(i-ioff,j-joff,k-koff) /= 0.e0_rt) then
+              f = fac * b(i,j,k)
+              a(i,j,k) = a(i,j,k) + f / alpha
+              rhs(i,j,k) = rhs(i,j,k) + f * Er(i-ioff,j-joff,k-koff)
+           end if
+
+           if (mask(i+ioff,j+joff,k+koff) /= 0.e0_rt) then
+              f = fac * b(i+ioff,j+joff,k+koff)
+              a(i,j,k) = a(i,j,k) + f / alpha
+              rhs(i,j,k) = rhs(i,j,k) + f * Er(i+ioff,j+joff,k+koff)
+           end if
+
+        end do
+     end do
+  end do
+
+end subroutine ca_hold_cells
+
+
+
+subroutine ca_hold_faces(lo, hi, &
+                         mask, m_lo, m_hi, &
+                         b, b_lo, b_hi, &
+                         idir) bind(C, name="ca_hold_faces")
+
+  ! b = 0 on the faces of direction idir next to a cell with mask /= 0
+
+  use amrex_fort_module, only : rt => amrex_real
+  implicit none
+
+  integer,  intent(in   ) :: lo(3), hi(3)
+  integer,  intent(in   ) :: m_lo(3), m_hi(3)
+  integer,  intent(in   ) :: b_lo(3), b_hi(3)
+  real(rt), intent(in   ) :: mask(m_lo(1):m_hi(1),m_lo(2):m_hi(2),m_lo(3):m_hi(3))
+  real(rt), intent(inout) :: b(b_lo(1):b_hi(1),b_lo(2):b_hi(2),b_lo(3):b_hi(3))
+  integer,  intent(in   ), value :: idir
+
+  integer :: i, j, k, ioff, joff, koff
+
+  ioff = 0
+  joff = 0
+  koff = 0
+  if (idir == 0) then
+     ioff = 1
+  else if (idir == 1) then
+     joff = 1
+  else
+     koff = 1
+  end if
+
+  do k = lo(3), hi(3)
+     do j = lo(2), hi(2)
+        do i = lo(1), hi(1)
+           if (mask(i,j,k) /= 0.e0_rt .or. mask(i-ioff,j-joff,k-koff) /= 0.e0_rt) then
+              b(i,j,k) = 0.e0_rt
+           end if
+        end do
+     end do
+  end do
+
+end subroutine ca_hold_faces
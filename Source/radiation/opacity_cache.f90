@@ -0,0 +1,153 @@
+! Tabulated Planck and Rosseland mean opacities for each group on a
+! uniform (log rho, log T) grid, filled from opacity_table_module at
+! initialization.  The lookups work on a row of zones at a time so that
+! the interpolation vectorizes.  The table memory is owned by the C++
+! side (Radiation::init_opacity_cache), where it may be shared by all
+! the ranks of a node.
+
+module opacity_cache_module
+
+  use amrex_fort_module, only : rt => amrex_real
+
+  implicit none
+
+  logical, save :: use_opacity_cache = .false.
+
+  integer, save :: cache_nrho = 0, cache_ntemp = 0
+
+  real(rt), save :: cache_lrho_lo, cache_dlrho, cache_ltemp_lo, cache_dltemp
+
+  ! ln(kappa) for (temp, rho, Planck/Rosseland, group)
+  real(rt), pointer, save :: cache_tab(:,:,:,:) => null()
+
+  real(rt), parameter :: cache_kappa_tiny = 1.e-200_rt
+
+  private :: cache_kappa_tiny
+
+contains
+
+  subroutine ca_init_opacity_cache(nrho, ntemp, rho_lo, rho_hi, temp_lo, temp_hi) &
+       bind(C, name="ca_init_opacity_cache")
+
+    use network, only : naux
+
+    integer, intent(in) :: nrho, ntemp
+    real(rt), intent(in) :: rho_lo, rho_hi, temp_lo, temp_hi
+
+    ! The table has no Ye axis.
+    if (naux > 0) then
+       call bl_error("radiation.use_opacity_cache requires naux = 0")
+    end if
+
+    if (nrho < 2 .or. ntemp < 2) then
+       call bl_error("radiation.use_opacity_cache needs at least 2 points in rho and T")
+    end if
+
+    cache_nrho = nrho
+    cache_ntemp = ntemp
+
+    cache_lrho_lo = log(rho_lo)
+    cache_dlrho = (log(rho_hi) - cache_lrho_lo) / (nrho - 1)
+    cache_ltemp_lo = log(temp_lo)
+    cache_dltemp = (log(temp_hi) - cache_ltemp_lo) / (ntemp - 1)
+
+  end subroutine ca_init_opacity_cache
+
+
+  ! Fill the table entries of group g; tab is the whole table.
+  subroutine ca_fill_opacity_cache(tab, g) bind(C, name="ca_fill_opacity_cache")
+
+    use rad_params_module, only : ngroups, nugroup
+    use opacity_table_module, only : get_opacities
+
+    integer, intent(in), value :: g
+    real(rt), intent(inout) :: tab(0:cache_ntemp-1, 0:cache_nrho-1, 2, 0:ngroups-1)
+
+    integer :: ir, it
+    real(rt) :: rho, temp, kp, kr
+    real(rt), parameter :: Ye = 0.e0_rt
+
+    do ir = 0, cache_nrho-1
+       rho = exp(cache_lrho_lo + ir*cache_dlrho)
+       do it = 0, cache_ntemp-1
+          temp = exp(cache_ltemp_lo + it*cache_dltemp)
+
+          call get_opacities(kp, kr, rho, temp, Ye, nugroup(g), .true., .true.)
+
+          tab(it,ir,1,g) = log(max(kp, cache_kappa_tiny))
+          tab(it,ir,2,g) = log(max(kr, cache_kappa_tiny))
+       end do
+    end do
+
+  end subroutine ca_fill_opacity_cache
+
+
+  subroutine ca_set_opacity_cache(tab_ptr) bind(C, name="ca_set_opacity_cache")
+
+    use iso_c_binding, only : c_ptr, c_f_pointer, c_associated
+    use rad_params_module, only : ngroups
+
+    type(c_ptr), intent(in), value :: tab_ptr
+
+    if (c_associated(tab_ptr)) then
+       call c_f_pointer(tab_ptr, cache_tab, [cache_ntemp, cache_nrho, 2, ngroups])
+       use_opacity_cache = .true.
+    else
+       cache_tab => null()
+       use_opacity_cache = .false.
+    end if
+
+  end subroutine ca_set_opacity_cache
+
+
+  ! Table cell and weights for n zones.  Values outside the table are
+  ! clamped to its edges.
+  subroutine opacity_cache_locate(n, rho, temp, ir, it, fr, ft)
+
+    integer, intent(in) :: n
+    real(rt), intent(in) :: rho(n), temp(n)
+    integer, intent(out) :: ir(n), it(n)
+    real(rt), intent(out) :: fr(n), ft(n)
+
+    integer :: i
+    real(rt) :: xr, xt
+
+    !$omp simd private(xr, xt)
+    do i = 1, n
+       xr = (log(rho(i)) - cache_lrho_lo) / cache_dlrho
+       xt = (log(temp(i)) - cache_ltemp_lo) / cache_dltemp
+       xr = min(max(xr, 0.e0_rt), real(cache_nrho-1, rt))
+       xt = min(max(xt, 0.e0_rt), real(cache_ntemp-1, rt))
+       ir(i) = min(int(xr), cache_nrho-2)
+       it(i) = min(int(xt), cache_ntemp-2)
+       fr(i) = xr - ir(i)
+       ft(i) = xt - it(i)
+    end do
+
+  end subroutine opacity_cache_locate
+
+
+  ! Bilinear interpolation in ln(kappa) of the Planck (icomp = 1) or
+  ! Rosseland (icomp = 2) mean of group g.
+  subroutine opacity_cache_interp(n, g, icomp, ir, it, fr, ft, kappa)
+
+    integer, intent(in) :: n, g, icomp
+    integer, intent(in) :: ir(n), it(n)
+    real(rt), intent(in) :: fr(n), ft(n)
+    real(rt), intent(out) :: kappa(n)
+
+    integer :: i, gg
+
+    gg = g + 1   ! cache_tab has unit lower bounds
+
+    !$omp simd
+    do i = 1, n
+       kappa(i) = exp( (1.e0_rt-fr(i)) * ( (1.e0_rt-ft(i)) * cache_tab(it(i)+1, ir(i)+1, icomp, gg) &
+                                          +         ft(i)  * cache_tab(it(i)+2, ir(i)+1, icomp, gg) ) &
+                      +         fr(i)  * ( (1.e0_rt-ft(i)) * cache_tab(it(i)+1, ir(i)+2, icomp, gg) &
+                                          +         ft(i)  * cache_tab(it(i)+2, ir(i)+2, icomp, gg) ) )
+    end do
+
+  end subroutine opacity_cache_interp
+
+end module opacity_cache_module
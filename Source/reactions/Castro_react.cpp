@@ -273,6 +273,30 @@ Castro::react_state(MultiFab& s, MultiFab& r, const iMultiFab& mask, MultiFab& w
 
     }
 
+    if (use_burn_cache) {
+
+	long hits = 0, misses = 0, checks = 0, check_fails = 0;
+
+	ca_get_burn_cache_stats(hits, misses, checks, check_fails);
+
+	if (verbose) {
+
+	    long stats[4] = {hits, misses, checks, check_fails};
+
+	    ParallelDescriptor::ReduceLongSum(stats, 4, ParallelDescriptor::IOProcessorNumber());
+
+	    if (ParallelDescriptor::IOProcessor() && stats[0] + stats[1] > 0) {
+		std::cout << "... burn cache hit rate: "
+			  << static_cast<Real>(stats[0]) / static_cast<Real>(stats[0] + stats[1])
+			  << " (" << stats[0] << " hits, " << stats[1] << " misses)" << std::endl;
+		if (stats[2] > 0)
+		    std::cout << "... burn cache checks failed: " << stats[3] << " of " << stats[2] << std::endl;
+	    }
+
+	}
+
+    }
+
     if (verbose > 0)
     {
         const int IOProc   = ParallelDescriptor::IOProcessorNumber();
@@ -314,9 +338,10 @@ Castro::react_state(Real time, Real dt)
     const int ng = S_new.nGrow();
     const iMultiFab& interior_mask = build_interior_boundary_mask(ng);
 
-    // Create a MultiFab with all of the non-reacting source terms.
+    // Sum all of the non-reacting source terms. This buffer persists
+    // for the whole advance and is reused by get_react_source_prim.
 
-    MultiFab A_src(grids, dmap, NUM_STATE, ng);
+    MultiFab& A_src = sdc_source_sum;
     sum_of_sources(A_src);
 
     MultiFab& reactions = get_old_data(Reactions_Type);
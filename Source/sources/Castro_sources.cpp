@@ -428,11 +428,10 @@ Castro::get_react_source_prim(MultiFab& react_src, Real dt)
 
     int ng = 0;
 
-    // Carries the contribution of all non-reacting source terms.
+    // Carries the contribution of all non-reacting source terms. This
+    // was already summed for this iteration in react_state.
 
-    MultiFab A(grids, dmap, NUM_STATE, ng);
-
-    sum_of_sources(A);
+    const MultiFab& A = sdc_source_sum;
 
     // Compute the state that has effectively only been updated with advection.
     // U* = U_old + dt A
@@ -451,12 +450,16 @@ Castro::get_react_source_prim(MultiFab& react_src, Real dt)
 
     cons_to_prim(S_noreact, q_noreact, qaux_noreact);
 
-    // Compute the primitive version of the old state, q_old
+    // Compute the primitive version of the old state, q_old. The old
+    // state does not change between SDC iterations, so we only need
+    // to do this on the first one.
 
-    MultiFab q_old(grids, dmap, QVAR, ng);
-    MultiFab qaux_old(grids, dmap, NQAUX, ng);
+    MultiFab& q_old = sdc_q_old;
 
-    cons_to_prim(S_old, q_old, qaux_old);
+    if (sdc_iteration == 0) {
+        MultiFab qaux_old(grids, dmap, NQAUX, ng);
+        cons_to_prim(S_old, q_old, qaux_old);
+    }
 
     // Compute the effective advective update on the primitive state.
     // A(q) = (q* - q_old)/dt
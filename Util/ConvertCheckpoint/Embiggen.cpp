@@ -30,6 +30,7 @@
 #include "AMReX_BCRec.H"
 #include "AMReX_LevelBld.H"
 #include "AMReX_AmrLevel.H"
+#include "FabCompress.H"
 
 using namespace amrex;
 
@@ -349,6 +350,15 @@ static void ReadCheckpointFile(const std::string& fileName) {
 
       int nstate;
       is >> nstate;
+
+      // A compressed Castro checkpoint has 0 here, followed by the
+      // real number of states; its MultiFabs are read with FabCompress.
+      bool compressed = false;
+      if (nstate == 0) {
+        compressed = true;
+        is >> nstate;
+      }
+
       int ndesc = nstate;
 
       // This should be the same at all levels
@@ -394,7 +404,11 @@ static void ReadCheckpointFile(const std::string& fileName) {
              FullPathName += '/';
            }
            FullPathName += mf_name;
-           VisMF::Read(*(falRef.state[i].new_data), FullPathName);
+           if (compressed) {
+             FabCompress::Read(*(falRef.state[i].new_data), FullPathName);
+           } else {
+             VisMF::Read(*(falRef.state[i].new_data), FullPathName);
+           }
         }
 
         // This reads the "old" data, if it's there
@@ -408,7 +422,11 @@ static void ReadCheckpointFile(const std::string& fileName) {
             FullPathName += '/';
 	  }
           FullPathName += mf_name;
-          VisMF::Read(*(falRef.state[i].old_data), FullPathName);
+          if (compressed) {
+            FabCompress::Read(*(falRef.state[i].old_data), FullPathName);
+          } else {
+            VisMF::Read(*(falRef.state[i].old_data), FullPathName);
+          }
         }
 
       }
@@ -510,8 +528,11 @@ static void WriteCheckpointFile(const std::string& inFileName, const std::string
 	std::string newCastroHeaderName = outFileName + "/CastroHeader";
 	newCastroHeaderFile.open(newCastroHeaderName.c_str(), std::ios::binary);
 
+	// Only the version line: the new checkpoint is never compressed.
 	if (newCastroHeaderFile.good()) {
-	  newCastroHeaderFile << oldCastroHeaderFile.rdbuf();
+	  std::string version_line;
+	  std::getline(oldCastroHeaderFile, version_line);
+	  newCastroHeaderFile << version_line << std::endl;
 	  newCastroHeaderFile.close();
 	}
 
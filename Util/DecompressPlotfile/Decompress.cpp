@@ -0,0 +1,86 @@
+// Rewrite the compressed levels of a Castro plotfile
+// (castro.compress_plotfile = 1) as ordinary VisMF data, so that
+// amrvis, yt, fcompare, ... can read it.
+// ---------------------------------------------------------------
+#include <iostream>
+#include <string>
+
+#include "AMReX_REAL.H"
+#include "AMReX_MultiFab.H"
+#include "AMReX_ParmParse.H"
+#include "AMReX_ParallelDescriptor.H"
+#include "AMReX_Utility.H"
+#include "AMReX_VisMF.H"
+#include "FabCompress.H"
+
+using namespace amrex;
+
+static void PrintUsage(const char* progName)
+{
+    if (ParallelDescriptor::IOProcessor()) {
+        std::cout << "Usage: " << progName << " plotfile=<plotfile> [remove=1] [verbose=1]" << std::endl;
+        std::cout << "  Rewrites every compressed level, Level_<n>/Cell_ZH, of the plotfile" << std::endl;
+        std::cout << "  as Level_<n>/Cell_H; remove=1 deletes the compressed files." << std::endl;
+    }
+    amrex::Finalize();
+    exit(1);
+}
+
+int main(int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+
+    if (argc == 1)
+        PrintUsage(argv[0]);
+
+    ParmParse pp;
+
+    std::string plotfile;
+    if (!pp.query("plotfile", plotfile))
+        PrintUsage(argv[0]);
+
+    int remove = 0;
+    pp.query("remove", remove);
+
+    int verbose = 1;
+    pp.query("verbose", verbose);
+
+    // The plotfile Header names Level_<n>/Cell for every level; the
+    // compressed levels are those with a Cell_ZH.
+    int nconverted = 0;
+    for (int lev = 0; ; lev++) {
+        const std::string level_dir = amrex::Concatenate(plotfile + "/Level_", lev, 1);
+        if (!amrex::FileExists(level_dir))
+            break;
+
+        const std::string name = level_dir + "/Cell";
+        if (!FabCompress::Exists(name))
+            continue;
+
+        MultiFab mf;
+        FabCompress::Read(mf, name);
+        VisMF::Write(mf, name);
+
+        if (remove) {
+            ParallelDescriptor::Barrier();
+            if (ParallelDescriptor::IOProcessor()) {
+                const Vector<std::string> files = FabCompress::Files(name);
+                for (int i = 0; i < files.size(); i++) {
+                    amrex::UnlinkFile(files[i]);
+                }
+                amrex::UnlinkFile(name + "_ZH");
+            }
+        }
+
+        if (verbose && ParallelDescriptor::IOProcessor())
+            std::cout << "decompressed " << name << std::endl;
+
+        nconverted++;
+    }
+
+    if (verbose && ParallelDescriptor::IOProcessor() && nconverted == 0)
+        std::cout << plotfile << " has no compressed levels" << std::endl;
+
+    amrex::Finalize();
+    return 0;
+}